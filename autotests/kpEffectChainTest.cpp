@@ -0,0 +1,194 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+//
+// Checks that kpEffectChain::applyEffect() gives exactly the same pixels
+// as applying each effect's own applyEffect() to the whole image in turn.
+//
+
+#include "imagelib/effects/kpEffectBalance.h"
+#include "imagelib/effects/kpEffectChain.h"
+#include "imagelib/effects/kpEffectFlatten.h"
+#include "imagelib/effects/kpEffectGrayscale.h"
+#include "imagelib/effects/kpEffectHSV.h"
+#include "imagelib/effects/kpEffectInvert.h"
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QRandomGenerator>
+#include <QTest>
+
+class kpEffectChainTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void applyEffect_data();
+    void applyEffect();
+};
+
+//---------------------------------------------------------------------
+
+enum Effect {
+    Balance,
+    BalanceRed,
+    Flatten,
+    Grayscale,
+    HSV,
+    Invert,
+    InvertRedBlue
+};
+
+// Returns a random image of <format>, whose pixels include fully opaque,
+// fully transparent and partly transparent ones.
+static QImage RandomImage(QImage::Format format)
+{
+    // (a fixed seed so that any failure can be reproduced)
+    QRandomGenerator random(20260103u);
+
+    QImage image(37, 23, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); x++) {
+            const QRgb rgba = random.generate();
+            switch ((x + y) % 5) {
+            case 0:
+                line[x] = qRgba(qRed(rgba), qGreen(rgba), qBlue(rgba), 0);
+                break;
+            case 1:
+                line[x] = qRgba(qRed(rgba), qGreen(rgba), qBlue(rgba), 255);
+                break;
+            default:
+                line[x] = rgba;
+                break;
+            }
+        }
+    }
+
+    return image.convertToFormat(format);
+}
+
+// Applies <effect> to <image> with its own applyEffect() and adds it to
+// <chain>.
+static void ApplyAndAdd(Effect effect, kpImage *image, kpEffectChain *chain)
+{
+    switch (effect) {
+    case Balance:
+        *image = kpEffectBalance::applyEffect(*image, kpEffectBalance::RGB, 20, -15, 10);
+        chain->addBalance(kpEffectBalance::RGB, 20, -15, 10);
+        break;
+
+    case BalanceRed:
+        *image = kpEffectBalance::applyEffect(*image, kpEffectBalance::Red, -30, 40, -5);
+        chain->addBalance(kpEffectBalance::Red, -30, 40, -5);
+        break;
+
+    case Flatten:
+        kpEffectFlatten::applyEffect(image, QColor(12, 200, 99), QColor(250, 3, 128));
+        chain->addFlatten(QColor(12, 200, 99), QColor(250, 3, 128));
+        break;
+
+    case Grayscale:
+        *image = kpEffectGrayscale::applyEffect(*image);
+        chain->addGrayscale();
+        break;
+
+    case HSV:
+        *image = kpEffectHSV::applyEffect(*image, 75, 0.25, -0.1);
+        chain->addHSV(75, 0.25, -0.1);
+        break;
+
+    case Invert:
+        kpEffectInvert::applyEffect(image, kpEffectInvert::RGB);
+        chain->addInvert(kpEffectInvert::RGB);
+        break;
+
+    case InvertRedBlue:
+        kpEffectInvert::applyEffect(image, kpEffectInvert::Red | kpEffectInvert::Blue);
+        chain->addInvert(kpEffectInvert::Red | kpEffectInvert::Blue);
+        break;
+    }
+}
+
+// Returns a description of the first difference between <actual> and
+// <expected>, or an empty string.
+static QString CompareImages(const QImage &actual, const QImage &expected, const QImage &input)
+{
+    if (actual.format() != expected.format() || actual.size() != expected.size()) {
+        return QStringLiteral("format %1 instead of %2").arg(static_cast<int>(actual.format())).arg(static_cast<int>(expected.format()));
+    }
+
+    for (int y = 0; y < actual.height(); y++) {
+        const auto *actualLine = reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        const auto *expectedLine = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        const auto *inputLine = reinterpret_cast<const QRgb *>(input.constScanLine(y));
+
+        for (int x = 0; x < actual.width(); x++) {
+            if (actualLine[x] != expectedLine[x]) {
+                return QStringLiteral("pixel (%1,%2) (%3) became %4 instead of %5")
+                    .arg(x)
+                    .arg(y)
+                    .arg(QString::number(inputLine[x], 16), QString::number(actualLine[x], 16), QString::number(expectedLine[x], 16));
+            }
+        }
+    }
+
+    return {};
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpEffectChainTest::applyEffect_data()
+{
+    QTest::addColumn<QList<int>>("effects");
+
+    // Each effect on its own.
+    QTest::newRow("Balance") << QList<int>{Balance};
+    QTest::newRow("BalanceRed") << QList<int>{BalanceRed};
+    QTest::newRow("Flatten") << QList<int>{Flatten};
+    QTest::newRow("Grayscale") << QList<int>{Grayscale};
+    QTest::newRow("HSV") << QList<int>{HSV};
+    QTest::newRow("Invert") << QList<int>{Invert};
+    QTest::newRow("InvertRedBlue") << QList<int>{InvertRedBlue};
+
+    // Chains.
+    QTest::newRow("Grayscale,Balance,Invert,HSV") << QList<int>{Grayscale, Balance, Invert, HSV};
+    QTest::newRow("Balance,HSV,Invert,Flatten") << QList<int>{Balance, HSV, Invert, Flatten};
+    QTest::newRow("InvertRedBlue,Flatten,BalanceRed,Grayscale") << QList<int>{InvertRedBlue, Flatten, BalanceRed, Grayscale};
+    QTest::newRow("Invert,Invert") << QList<int>{Invert, Invert};
+    QTest::newRow("HSV,Invert,HSV,InvertRedBlue,Balance") << QList<int>{HSV, Invert, HSV, InvertRedBlue, Balance};
+}
+
+// private slot
+void kpEffectChainTest::applyEffect()
+{
+    QFETCH(QList<int>, effects);
+
+    for (const QImage::Format format : {QImage::Format_ARGB32, QImage::Format_ARGB32_Premultiplied}) {
+        const QImage input = ::RandomImage(format);
+
+        kpImage expected = input;
+        kpEffectChain chain;
+        for (const int effect : effects) {
+            ::ApplyAndAdd(static_cast<Effect>(effect), &expected, &chain);
+        }
+        QCOMPARE(chain.count(), int(effects.count()));
+
+        const kpImage actual = chain.applyEffect(input);
+
+        const QString error = ::CompareImages(actual, expected, input);
+        QVERIFY2(error.isEmpty(), qPrintable(QStringLiteral("format %1: ").arg(static_cast<int>(format)) + error));
+    }
+}
+
+//---------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(kpEffectChainTest)
+
+#include "kpEffectChainTest.moc"
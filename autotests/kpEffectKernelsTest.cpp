@@ -0,0 +1,209 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+//
+// Checks that every SIMD implementation of the kpEffectKernels gives
+// exactly the same pixels as the portable one.
+//
+
+#include "imagelib/effects/kpEffectKernels.h"
+
+#include <QColor>
+#include <QList>
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <cstring>
+
+class kpEffectKernelsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void invert_data();
+    void invert();
+
+    void grayscale_data();
+    void grayscale();
+
+    void flatten_data();
+    void flatten();
+
+private:
+    void addInstructionSetRows();
+};
+
+Q_DECLARE_METATYPE(kpEffectKernels::InstructionSet)
+
+//---------------------------------------------------------------------
+
+// Row widths: every tail length for the widest vector (8 pixels), both
+// sides of a multiple of the vector width, and odd widths.
+static const int Widths[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 255, 256, 257, 1001};
+
+// Returns random pixels, with valid premultiplied values if
+// <premultiplied>.
+static QList<QRgb> RandomPixels(QRandomGenerator *random, int count, bool premultiplied)
+{
+    QList<QRgb> pixels(count);
+    for (int i = 0; i < count; i++) {
+        const QRgb rgba = random->generate();
+        pixels[i] = premultiplied ? qPremultiply(rgba) : rgba;
+    }
+
+    // Make sure the extremes are present, not just likely.
+    if (count >= 4) {
+        pixels[0] = qRgba(0, 0, 0, 0);
+        pixels[1] = qRgba(255, 255, 255, 255);
+        pixels[2] = premultiplied ? qRgba(1, 0, 1, 1) : qRgba(255, 0, 255, 1);
+        pixels[3] = qRgba(0, 0, 0, 255);
+    }
+
+    return pixels;
+}
+
+// Runs <kernel> over a random row of each width, with the portable
+// implementation and with <set>, and compares the results byte for byte.
+// Each row is also run starting one pixel into its buffer, so that the
+// SIMD kernels' unaligned loads and stores are exercised.
+//
+// Returns a description of the first difference, or an empty string.
+template<typename Kernel>
+static QString CompareWithScalar(kpEffectKernels::InstructionSet set, bool premultiplied, Kernel kernel)
+{
+    // (a fixed seed so that any failure can be reproduced)
+    QRandomGenerator random(20260101u + static_cast<quint32>(set));
+
+    for (const int width : Widths) {
+        for (int offset = 0; offset <= 1; offset++) {
+            const QList<QRgb> input = RandomPixels(&random, offset + width, premultiplied);
+
+            QList<QRgb> expected = input;
+            kernel(expected.data() + offset, width, kpEffectKernels::Scalar);
+
+            QList<QRgb> actual = input;
+            kernel(actual.data() + offset, width, set);
+
+            if (std::memcmp(expected.constData(), actual.constData(), input.size() * sizeof(QRgb)) == 0) {
+                continue;
+            }
+
+            for (int i = 0; i < input.size(); i++) {
+                if (expected[i] != actual[i]) {
+                    return QStringLiteral("width %1 offset %2: pixel %3 (%4) became %5 instead of %6")
+                        .arg(width)
+                        .arg(offset)
+                        .arg(i)
+                        .arg(QString::number(input[i], 16), QString::number(actual[i], 16), QString::number(expected[i], 16));
+                }
+            }
+        }
+    }
+
+    return {};
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpEffectKernelsTest::addInstructionSetRows()
+{
+    QTest::addColumn<kpEffectKernels::InstructionSet>("set");
+
+    QTest::newRow("SSE2") << kpEffectKernels::SSE2;
+    QTest::newRow("AVX2") << kpEffectKernels::AVX2;
+    QTest::newRow("NEON") << kpEffectKernels::NEON;
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpEffectKernelsTest::invert_data()
+{
+    addInstructionSetRows();
+}
+
+// private slot
+void kpEffectKernelsTest::invert()
+{
+    QFETCH(kpEffectKernels::InstructionSet, set);
+    if (!kpEffectKernels::isSupported(set)) {
+        QSKIP("Not supported by this build or CPU");
+    }
+
+    const QRgb masks[] = {0x00FFFFFF, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00FF00FF, 0xFFFFFFFF};
+    for (const QRgb mask : masks) {
+        const QString error = CompareWithScalar(set, false /*not premultiplied*/, [mask](QRgb *pixels, int count, kpEffectKernels::InstructionSet set) {
+            kpEffectKernels::invert(pixels, count, mask, set);
+        });
+        QVERIFY2(error.isEmpty(), qPrintable(QStringLiteral("mask %1: ").arg(mask, 0, 16) + error));
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpEffectKernelsTest::grayscale_data()
+{
+    addInstructionSetRows();
+}
+
+// private slot
+void kpEffectKernelsTest::grayscale()
+{
+    QFETCH(kpEffectKernels::InstructionSet, set);
+    if (!kpEffectKernels::isSupported(set)) {
+        QSKIP("Not supported by this build or CPU");
+    }
+
+    const QString error = CompareWithScalar(set, false /*not premultiplied*/, [](QRgb *pixels, int count, kpEffectKernels::InstructionSet set) {
+        kpEffectKernels::grayscale(pixels, count, set);
+    });
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpEffectKernelsTest::flatten_data()
+{
+    addInstructionSetRows();
+}
+
+// private slot
+void kpEffectKernelsTest::flatten()
+{
+    QFETCH(kpEffectKernels::InstructionSet, set);
+    if (!kpEffectKernels::isSupported(set)) {
+        QSKIP("Not supported by this build or CPU");
+    }
+
+    const QColor colorPairs[][2] = {
+        {Qt::black, Qt::white},
+        {Qt::white, Qt::black},
+        {QColor(255, 0, 0), QColor(0, 0, 255)},
+        {QColor(12, 200, 99), QColor(250, 3, 128)},
+        {QColor(128, 128, 128), QColor(128, 128, 128)},
+    };
+
+    for (const bool premultiplied : {false, true}) {
+        for (const auto &colors : colorPairs) {
+            const QColor color1 = colors[0], color2 = colors[1];
+            const QString error = CompareWithScalar(set, premultiplied, [=](QRgb *pixels, int count, kpEffectKernels::InstructionSet set) {
+                kpEffectKernels::flatten(pixels, count, premultiplied, color1, color2, set);
+            });
+            const QString row = QStringLiteral("premultiplied %1, colors %2 %3: ").arg(static_cast<int>(premultiplied)).arg(color1.name(), color2.name());
+            QVERIFY2(error.isEmpty(), qPrintable(row + error));
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(kpEffectKernelsTest)
+
+#include "kpEffectKernelsTest.moc"
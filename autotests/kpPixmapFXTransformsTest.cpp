@@ -0,0 +1,292 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+//
+// Checks that kpPixmapFX::rotate() and kpPixmapFX::skew() give the same
+// pixels as the unsmoothed QPainter::drawImage() they used to be drawn
+// with, and that kpPixmapFX::flip() gives the same image and metadata as
+// QImage::mirrored().
+//
+
+#include "pixmapfx/kpPixmapFX.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QRandomGenerator>
+#include <QTest>
+#include <QTransform>
+
+#include <cmath>
+
+class kpPixmapFXTransformsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void rotate_data();
+    void rotate();
+
+    void skew_data();
+    void skew();
+
+    void flip_data();
+    void flip();
+};
+
+//---------------------------------------------------------------------
+
+// Odd and even sizes, a single pixel and one big enough to be split
+// across threads.
+static const QSize Sizes[] = {QSize(1, 1), QSize(2, 3), QSize(16, 9), QSize(31, 17), QSize(64, 64), QSize(1031, 1021)};
+
+// A destination pixel whose centre maps this close to a source pixel
+// boundary may take either pixel, as QPainter maps in fixed point.
+static const double BoundaryEpsilon = 1.0 / 16;
+
+// Returns random pixels, including fully and partly transparent ones.
+static QImage RandomImage(QRandomGenerator *random, const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); x++) {
+            const QRgb rgba = random->generate();
+            line[x] = (x + y) % 7 == 0 ? qRgba(qRed(rgba), qGreen(rgba), qBlue(rgba), 0) : rgba;
+        }
+    }
+
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+// Same as TrueMatrix() in kpPixmapFX_Transforms.cpp.
+static QTransform TrueMatrix(const QTransform &matrix, int width, int height)
+{
+    const auto fixInt = [](double x) {
+        return std::fabs(x - qRound(x)) < 0.000001 ? double(qRound(x)) : x;
+    };
+
+    const QTransform m = QPixmap::trueMatrix(matrix, width, height);
+    return QTransform(fixInt(m.m11()), fixInt(m.m12()), fixInt(m.m21()), fixInt(m.m22()), fixInt(m.dx()), fixInt(m.dy()));
+}
+
+// Draws <src> transformed by <matrix> the way TransformPixmap() did
+// before it mapped the pixels itself.
+static QImage PainterTransform(const QImage &src, const QTransform &trueMatrix, const QSize &size, const kpColor &backgroundColor)
+{
+    QImage dest(size, QImage::Format_ARGB32_Premultiplied);
+    dest.fill(0);
+
+    QPainter p(&dest);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.fillRect(dest.rect(), backgroundColor.toQColor());
+    p.setWorldTransform(trueMatrix);
+    p.drawImage(QPoint(0, 0), src);
+    p.end();
+
+    return dest;
+}
+
+// Returns the pixel of <src> at (<x>,<y>), or <background> if outside.
+static QRgb SourcePixel(const QImage &src, double x, double y, QRgb background)
+{
+    const int sx = int(std::floor(x));
+    const int sy = int(std::floor(y));
+    if (sx < 0 || sx >= src.width() || sy < 0 || sy >= src.height()) {
+        return background;
+    }
+
+    return src.pixel(sx, sy);
+}
+
+// Returns whether <pixel> is what the destination pixel (<x>,<y>) may be,
+// given that its centre maps to close to a pixel boundary of <src>.  At
+// the edges of <src>, QPainter may also clamp to the nearest source pixel.
+static bool IsPossiblePixel(QRgb pixel, const QImage &src, const QTransform &inverse, int x, int y, QRgb background)
+{
+    const QPointF srcPoint = inverse.map(QPointF(x + 0.5, y + 0.5));
+
+    for (const double ex : {-BoundaryEpsilon, BoundaryEpsilon}) {
+        for (const double ey : {-BoundaryEpsilon, BoundaryEpsilon}) {
+            if (pixel == SourcePixel(src, srcPoint.x() + ex, srcPoint.y() + ey, background)) {
+                return true;
+            }
+        }
+    }
+
+    const bool atEdge = srcPoint.x() > -1 && srcPoint.x() < src.width() + 1 && srcPoint.y() > -1 && srcPoint.y() < src.height() + 1
+        && (srcPoint.x() < 1 || srcPoint.x() > src.width() - 1 || srcPoint.y() < 1 || srcPoint.y() > src.height() - 1);
+    if (atEdge) {
+        const double cx = qBound(0.0, srcPoint.x(), src.width() - 0.5);
+        const double cy = qBound(0.0, srcPoint.y(), src.height() - 0.5);
+        return pixel == background || pixel == SourcePixel(src, cx, cy, background);
+    }
+
+    return false;
+}
+
+// Transforms random images of every size in Sizes by <matrixFor>(size)
+// with <transform> and with QPainter, over an opaque and a transparent
+// background, and compares the results.
+//
+// Returns a description of the first difference, or an empty string.
+template<typename MatrixFor, typename Transform>
+static QString CompareWithPainter(MatrixFor matrixFor, Transform transform)
+{
+    // (a fixed seed so that any failure can be reproduced)
+    QRandomGenerator random(20260102u);
+
+    const kpColor backgrounds[] = {kpColor(200, 30, 60), kpColor::Transparent};
+
+    for (const QSize &size : Sizes) {
+        const QImage src = RandomImage(&random, size);
+
+        const QTransform matrix = matrixFor(size);
+        const QTransform trueMatrix = ::TrueMatrix(matrix, size.width(), size.height());
+        const QTransform inverse = trueMatrix.inverted();
+
+        for (const kpColor &backgroundColor : backgrounds) {
+            const QRgb background = qPremultiply(backgroundColor.toQRgb());
+
+            const QImage actual = transform(src, backgroundColor);
+            const QImage expected = PainterTransform(src, trueMatrix, matrix.mapRect(src.rect()).size(), backgroundColor);
+
+            const QString where = QStringLiteral("%1x%2, %3 background: ")
+                                      .arg(size.width())
+                                      .arg(size.height())
+                                      .arg(backgroundColor.isTransparent() ? QStringLiteral("transparent") : QStringLiteral("opaque"));
+
+            if (actual.size() != expected.size()) {
+                return where
+                    + QStringLiteral("size %1x%2 instead of %3x%4").arg(actual.width()).arg(actual.height()).arg(expected.width()).arg(expected.height());
+            }
+
+            for (int y = 0; y < actual.height(); y++) {
+                for (int x = 0; x < actual.width(); x++) {
+                    const QRgb a = actual.pixel(x, y);
+                    const QRgb e = expected.pixel(x, y);
+                    if (a == e) {
+                        continue;
+                    }
+
+                    if (!::IsPossiblePixel(a, src, inverse, x, y, background) || !::IsPossiblePixel(e, src, inverse, x, y, background)) {
+                        return where
+                            + QStringLiteral("pixel (%1,%2) is %3 instead of %4")
+                                  .arg(x)
+                                  .arg(y)
+                                  .arg(QString::number(a, 16), QString::number(e, 16));
+                    }
+                }
+            }
+        }
+    }
+
+    return {};
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpPixmapFXTransformsTest::rotate_data()
+{
+    QTest::addColumn<double>("angle");
+
+    // (multiples of 90 degrees are lossless and never drawn with QPainter)
+    for (const double angle : {1.0, 17.0, 30.0, 45.0, -60.0, 123.4, 200.0, 315.0}) {
+        QTest::newRow(qPrintable(QString::number(angle))) << angle;
+    }
+}
+
+// private slot
+void kpPixmapFXTransformsTest::rotate()
+{
+    QFETCH(double, angle);
+
+    const QString error = ::CompareWithPainter(
+        [angle](const QSize &size) {
+            return kpPixmapFX::rotateMatrix(size.width(), size.height(), angle);
+        },
+        [angle](const QImage &src, const kpColor &backgroundColor) {
+            return kpPixmapFX::rotate(src, angle, backgroundColor);
+        });
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpPixmapFXTransformsTest::skew_data()
+{
+    QTest::addColumn<double>("hangle");
+    QTest::addColumn<double>("vangle");
+
+    QTest::newRow("20,0") << 20.0 << 0.0;
+    QTest::newRow("0,-35") << 0.0 << -35.0;
+    QTest::newRow("45,0") << 45.0 << 0.0;
+    QTest::newRow("15,10") << 15.0 << 10.0;
+    QTest::newRow("-70,5") << -70.0 << 5.0;
+}
+
+// private slot
+void kpPixmapFXTransformsTest::skew()
+{
+    QFETCH(double, hangle);
+    QFETCH(double, vangle);
+
+    const QString error = ::CompareWithPainter(
+        [hangle, vangle](const QSize &size) {
+            return kpPixmapFX::skewMatrix(size.width(), size.height(), hangle, vangle);
+        },
+        [hangle, vangle](const QImage &src, const kpColor &backgroundColor) {
+            return kpPixmapFX::skew(src, hangle, vangle, backgroundColor);
+        });
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpPixmapFXTransformsTest::flip_data()
+{
+    QTest::addColumn<bool>("horiz");
+    QTest::addColumn<bool>("vert");
+
+    QTest::newRow("horiz") << true << false;
+    QTest::newRow("vert") << false << true;
+    QTest::newRow("both") << true << true;
+}
+
+// private slot
+void kpPixmapFXTransformsTest::flip()
+{
+    QFETCH(bool, horiz);
+    QFETCH(bool, vert);
+
+    QRandomGenerator random(20260104u);
+    QImage src = ::RandomImage(&random, QSize(31, 17));
+    src.setDotsPerMeterX(2835);
+    src.setDotsPerMeterY(5670);
+    src.setOffset(QPoint(3, -4));
+    src.setDevicePixelRatio(2);
+    src.setText(QStringLiteral("Comment"), QStringLiteral("flipped"));
+
+    const QImage actual = kpPixmapFX::flip(src, horiz, vert);
+    const QImage expected = src.mirrored(horiz, vert);
+
+    QCOMPARE(actual, expected);
+    QCOMPARE(actual.dotsPerMeterX(), expected.dotsPerMeterX());
+    QCOMPARE(actual.dotsPerMeterY(), expected.dotsPerMeterY());
+    QCOMPARE(actual.offset(), expected.offset());
+    QCOMPARE(actual.devicePixelRatio(), expected.devicePixelRatio());
+    QCOMPARE(actual.text(), expected.text());
+}
+
+//---------------------------------------------------------------------
+
+QTEST_GUILESS_MAIN(kpPixmapFXTransformsTest)
+
+#include "kpPixmapFXTransformsTest.moc"
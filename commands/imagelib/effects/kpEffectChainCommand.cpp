@@ -0,0 +1,36 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#include "kpEffectChainCommand.h"
+
+#include <KLocalizedString>
+
+//--------------------------------------------------------------------------------
+
+kpEffectChainCommand::kpEffectChainCommand(const kpEffectChain &chain, bool actOnSelection, kpCommandEnvironment *environ)
+    : kpEffectCommandBase(i18n("Adjustments"), actOnSelection, environ)
+    , m_chain(chain)
+{
+}
+
+kpEffectChainCommand::~kpEffectChainCommand() = default;
+
+//
+// kpEffectChainCommand implements kpEffectCommandBase interface
+//
+
+// public virtual [base kpEffectCommandBase]
+bool kpEffectChainCommand::isInvertible() const
+{
+    return m_chain.isInvertible();
+}
+
+// protected virtual [base kpEffectCommandBase]
+kpImage kpEffectChainCommand::applyEffect(const kpImage &image)
+{
+    return m_chain.applyEffect(image);
+}
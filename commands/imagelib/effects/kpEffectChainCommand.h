@@ -0,0 +1,36 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpEffectChainCommand_H
+#define kpEffectChainCommand_H
+
+#include "imagelib/effects/kpEffectChain.h"
+#include "imagelib/kpImage.h"
+#include "kpEffectCommandBase.h"
+
+// Applies several adjustments in one pass, with a single undo entry
+// (and a single copy of the old image) for all of them.
+class kpEffectChainCommand : public kpEffectCommandBase
+{
+public:
+    kpEffectChainCommand(const kpEffectChain &chain, bool actOnSelection, kpCommandEnvironment *environ);
+    ~kpEffectChainCommand() override;
+
+    //
+    // kpEffectCommandBase interface
+    //
+
+public:
+    bool isInvertible() const override;
+
+protected:
+    kpImage applyEffect(const kpImage &image) override;
+
+    kpEffectChain m_chain;
+};
+
+#endif // kpEffectChainCommand_H
@@ -100,7 +100,7 @@ void kpTransformFlipCommand::flip()
         doc->imageSelection()->flip(m_horiz, m_vert);
         environ()->somethingBelowTheCursorChanged();
     } else {
-        doc->setImage(doc->image().mirrored(m_horiz, m_vert));
+        doc->setImage(kpPixmapFX::flip(doc->image(), m_horiz, m_vert));
     }
 
     QApplication::restoreOverrideCursor();
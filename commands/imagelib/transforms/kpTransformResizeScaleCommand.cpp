@@ -36,6 +36,7 @@ kpTransformResizeScaleCommand::kpTransformResizeScaleCommand(bool actOnSelection
     : kpCommand(environ)
     , m_actOnSelection(actOnSelection)
     , m_type(type)
+    , m_smoothScaleFilter(kpTransformResample::Bilinear)
     , m_backgroundColor(environ->backgroundColor())
     , m_oldSelectionPtr(nullptr)
 {
@@ -136,6 +137,18 @@ void kpTransformResizeScaleCommand::resize(int width, int height)
     m_isLosslessScale = ((m_type == Scale) && (m_newWidth / m_oldWidth * m_oldWidth == m_newWidth) && (m_newHeight / m_oldHeight * m_oldHeight == m_newHeight));
 }
 
+// public
+kpTransformResample::Filter kpTransformResizeScaleCommand::smoothScaleFilter() const
+{
+    return m_smoothScaleFilter;
+}
+
+// public
+void kpTransformResizeScaleCommand::setSmoothScaleFilter(kpTransformResample::Filter filter)
+{
+    m_smoothScaleFilter = filter;
+}
+
 // public
 bool kpTransformResizeScaleCommand::scaleSelectionWithImage() const
 {
@@ -238,7 +251,8 @@ void kpTransformResizeScaleCommand::execute()
             m_oldImage = oldImage;
         }
 
-        kpImage newImage = kpPixmapFX::scale(oldImage, m_newWidth, m_newHeight, m_type == SmoothScale);
+        kpImage newImage = (m_type == SmoothScale) ? kpTransformResample::scale(oldImage, m_newWidth, m_newHeight, m_smoothScaleFilter)
+                                                   : kpPixmapFX::scale(oldImage, m_newWidth, m_newHeight);
 
         if (!m_oldSelectionPtr && document()->selection()) {
             // Save sel border
@@ -312,20 +326,17 @@ void kpTransformResizeScaleCommand::unexecute()
         } else {
             QApplication::setOverrideCursor(Qt::WaitCursor);
 
-            kpImage newImage(m_oldWidth, m_oldHeight, QImage::Format_ARGB32_Premultiplied);
-
-            kpPixmapFX::setPixmapAt(&newImage, QPoint(0, 0), doc->image());
+            // (works on the tiles, so does not need the whole image in memory)
+            doc->resize(m_oldWidth, m_oldHeight, m_backgroundColor);
 
             if (m_newWidth < m_oldWidth) {
-                kpPixmapFX::setPixmapAt(&newImage, QPoint(m_newWidth, 0), m_oldRightImage);
+                doc->setImageAt(m_oldRightImage, QPoint(m_newWidth, 0));
             }
 
             if (m_newHeight < m_oldHeight) {
-                kpPixmapFX::setPixmapAt(&newImage, QPoint(0, m_newHeight), m_oldBottomImage);
+                doc->setImageAt(m_oldBottomImage, QPoint(0, m_newHeight));
             }
 
-            doc->setImage(newImage);
-
             QApplication::restoreOverrideCursor();
         }
     }
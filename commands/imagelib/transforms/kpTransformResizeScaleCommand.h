@@ -11,6 +11,7 @@
 #include "commands/kpCommand.h"
 #include "imagelib/kpColor.h"
 #include "imagelib/kpImage.h"
+#include "imagelib/transforms/kpTransformResample.h"
 
 class QSize;
 
@@ -44,6 +45,11 @@ public:
     QSize newSize() const;
     virtual void resize(int width, int height);
 
+    // The filter used for SmoothScale.  Defaults to
+    // kpTransformResample::Bilinear.
+    kpTransformResample::Filter smoothScaleFilter() const;
+    void setSmoothScaleFilter(kpTransformResample::Filter filter);
+
 public:
     bool scaleSelectionWithImage() const;
 
@@ -58,6 +64,7 @@ protected:
     bool m_actOnSelection;
     int m_newWidth, m_newHeight;
     Type m_type;
+    kpTransformResample::Filter m_smoothScaleFilter;
     bool m_isLosslessScale;
     bool m_scaleSelectionWithImage;
     kpColor m_backgroundColor;
@@ -100,7 +100,7 @@ void kpTransformRotateCommand::execute()
         // Calculate rotated points
         QPolygon currentPoints = sel->calculatePoints();
         currentPoints.translate(-currentPoints.boundingRect().x(), -currentPoints.boundingRect().y());
-        QTransform rotateMatrix = kpPixmapFX::rotateMatrix(doc->image(m_actOnSelection), m_angle);
+        QTransform rotateMatrix = kpPixmapFX::rotateMatrix(doc->width(m_actOnSelection), doc->height(m_actOnSelection), m_angle);
         currentPoints = rotateMatrix.map(currentPoints);
         currentPoints.translate(-currentPoints.boundingRect().x() + newTopLeft.x(), -currentPoints.boundingRect().y() + newTopLeft.y());
 
@@ -86,7 +86,8 @@ void kpTransformSkewCommand::execute()
         // Calculate skewed points
         QPolygon currentPoints = sel->calculatePoints();
         currentPoints.translate(-currentPoints.boundingRect().x(), -currentPoints.boundingRect().y());
-        QTransform skewMatrix = kpPixmapFX::skewMatrix(doc->image(m_actOnSelection),
+        QTransform skewMatrix = kpPixmapFX::skewMatrix(doc->width(m_actOnSelection),
+                                                       doc->height(m_actOnSelection),
                                                        kpTransformSkewDialog::horizontalAngleForPixmapFX(m_hangle),
                                                        kpTransformSkewDialog::verticalAngleForPixmapFX(m_vangle));
         currentPoints = skewMatrix.map(currentPoints);
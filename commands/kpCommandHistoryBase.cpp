@@ -63,6 +63,7 @@ kpCommandHistoryBase::kpCommandHistoryBase(bool doReadConfig, KActionCollection
     m_undoMaxLimitSizeLimit = 16 * 1048576;
 
     m_documentRestoredPosition = 0;
+    m_documentSavingPosition = 0;
 
     if (doReadConfig) {
         readConfig();
@@ -199,6 +200,20 @@ void kpCommandHistoryBase::writeConfig()
     cfg.sync();
 }
 
+// Moves <*position>, which is as described for m_documentRestoredPosition,
+// when a command is added.
+static void PositionAfterAddCommand(int *position)
+{
+    if (*position != INT_MAX) {
+        if (*position > 0) {
+            // The redo path back to the position has been cleared.
+            *position = INT_MAX;
+        } else {
+            (*position)--;
+        }
+    }
+}
+
 // public
 void kpCommandHistoryBase::addCommand(kpCommand *command, bool execute)
 {
@@ -218,16 +233,11 @@ void kpCommandHistoryBase::addCommand(kpCommand *command, bool execute)
 #if DEBUG_KP_COMMAND_HISTORY
     qCDebug(kpLogCommands) << "\tdocumentRestoredPosition=" << m_documentRestoredPosition;
 #endif
-    if (m_documentRestoredPosition != INT_MAX) {
-        if (m_documentRestoredPosition > 0) {
-            m_documentRestoredPosition = INT_MAX;
-        } else {
-            m_documentRestoredPosition--;
-        }
+    ::PositionAfterAddCommand(&m_documentRestoredPosition);
+    ::PositionAfterAddCommand(&m_documentSavingPosition);
 #if DEBUG_KP_COMMAND_HISTORY
-        qCDebug(kpLogCommands) << "\t\tdocumentRestoredPosition=" << m_documentRestoredPosition;
+    qCDebug(kpLogCommands) << "\t\tdocumentRestoredPosition=" << m_documentRestoredPosition;
 #endif
-    }
 
     trimCommandListsUpdateActions();
 }
@@ -243,6 +253,7 @@ void kpCommandHistoryBase::clear()
     ::ClearPointerList(m_redoCommandList);
 
     m_documentRestoredPosition = 0;
+    m_documentSavingPosition = 0;
 
     updateActions();
 }
@@ -269,6 +280,10 @@ void kpCommandHistoryBase::undoInternal()
 #if DEBUG_KP_COMMAND_HISTORY
     qCDebug(kpLogCommands) << "\tdocumentRestoredPosition=" << m_documentRestoredPosition;
 #endif
+    if (m_documentSavingPosition != INT_MAX) {
+        m_documentSavingPosition++;
+    }
+
     if (m_documentRestoredPosition != INT_MAX) {
         m_documentRestoredPosition++;
         if (m_documentRestoredPosition == 0)
@@ -301,6 +316,10 @@ void kpCommandHistoryBase::redoInternal()
 #if DEBUG_KP_COMMAND_HISTORY
     qCDebug(kpLogCommands) << "\tdocumentRestoredPosition=" << m_documentRestoredPosition;
 #endif
+    if (m_documentSavingPosition != INT_MAX) {
+        m_documentSavingPosition--;
+    }
+
     if (m_documentRestoredPosition != INT_MAX) {
         m_documentRestoredPosition--;
         if (m_documentRestoredPosition == 0) {
@@ -503,6 +522,12 @@ void kpCommandHistoryBase::trimCommandLists()
             m_documentRestoredPosition = INT_MAX;
         }
     }
+
+    if (m_documentSavingPosition != INT_MAX
+        && (m_documentSavingPosition > static_cast<int>(m_redoCommandList.size())
+            || -m_documentSavingPosition > static_cast<int>(m_undoCommandList.size()))) {
+        m_documentSavingPosition = INT_MAX;
+    }
 }
 
 static void populatePopupMenu(QMenu *popupMenu, const QString &undoOrRedo, const QList<kpCommand *> &commandList)
@@ -612,14 +637,26 @@ void kpCommandHistoryBase::setNextUndoCommand(kpCommand *command)
     trimCommandListsUpdateActions();
 }
 
+// public slot virtual
+void kpCommandHistoryBase::documentSaveStarted()
+{
+#if DEBUG_KP_COMMAND_HISTORY
+    qCDebug(kpLogCommands) << "kpCommandHistoryBase::documentSaveStarted()";
+#endif
+
+    m_documentSavingPosition = 0;
+}
+
 // public slot virtual
 void kpCommandHistoryBase::documentSaved()
 {
 #if DEBUG_KP_COMMAND_HISTORY
-    qCDebug(kpLogCommands) << "kpCommandHistoryBase::documentSaved()";
+    qCDebug(kpLogCommands) << "kpCommandHistoryBase::documentSaved() savingPosition=" << m_documentSavingPosition;
 #endif
 
-    m_documentRestoredPosition = 0;
+    // (commands may have been executed, undone or redone while the document
+    //  was being saved in the background)
+    m_documentRestoredPosition = m_documentSavingPosition;
 }
 
 #include "moc_kpCommandHistoryBase.cpp"
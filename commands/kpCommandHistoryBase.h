@@ -92,6 +92,7 @@ public:
     void setNextUndoCommand(kpCommand *command);
 
 public Q_SLOTS:
+    virtual void documentSaveStarted();
     virtual void documentSaved();
 
 Q_SIGNALS:
@@ -115,6 +116,12 @@ protected:
     //
     // ASSUMPTION: will never have INT_MAX commands in any list.
     int m_documentRestoredPosition;
+
+    // Same as <m_documentRestoredPosition> but for the state of the document
+    // when it was last snapshotted for saving (see documentSaveStarted()).
+    // It becomes <m_documentRestoredPosition> once the save succeeds, which
+    // can be after more commands have been executed.
+    int m_documentSavingPosition;
 };
 
 #endif // kpCommandHistoryBase_H
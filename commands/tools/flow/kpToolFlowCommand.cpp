@@ -11,6 +11,7 @@
 
 #include "document/kpDocument.h"
 #include "imagelib/kpImage.h"
+#include "imagelib/kpTiledImage.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
 #include "views/manager/kpViewManager.h"
@@ -19,6 +20,8 @@
 
 struct kpToolFlowCommandPrivate {
     kpImage image;
+    // Instead of <image> until finalize(), for a tiled document.
+    kpTiledImage tiledImage;
     QRect boundingRect;
 };
 
@@ -26,7 +29,11 @@ kpToolFlowCommand::kpToolFlowCommand(const QString &name, kpCommandEnvironment *
     : kpNamedCommand(name, environ)
     , d(new kpToolFlowCommandPrivate())
 {
-    d->image = document()->image();
+    if (document()->isTiled()) {
+        d->tiledImage = document()->tiledImage();
+    } else {
+        d->image = document()->image();
+    }
 }
 
 kpToolFlowCommand::~kpToolFlowCommand()
@@ -87,10 +94,15 @@ void kpToolFlowCommand::finalize()
 {
     if (d->boundingRect.isValid()) {
         // Store only the needed part of doc image.
-        d->image = kpTool::neededPixmap(d->image, d->boundingRect);
+        if (!d->tiledImage.isNull()) {
+            d->image = d->tiledImage.copy(d->boundingRect);
+        } else {
+            d->image = kpTool::neededPixmap(d->image, d->boundingRect);
+        }
     } else {
         d->image = kpImage();
     }
+    d->tiledImage = kpTiledImage();
 }
 
 // public
@@ -19,6 +19,8 @@ struct kpToolFloodFillCommandPrivate;
 class kpToolFloodFillCommand : public kpCommand, public kpFloodFill
 {
 public:
+    // ASSUMPTION: document()->imagePointer() is not null i.e. the image fits
+    //             in memory.
     kpToolFloodFillCommand(int x, int y, const kpColor &color, int processedColorSimilarity, kpCommandEnvironment *environ);
     ~kpToolFloodFillCommand() override;
 
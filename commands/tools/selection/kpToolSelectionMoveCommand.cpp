@@ -102,7 +102,9 @@ void kpToolSelectionMoveCommand::unexecute()
 
     vm->setQueueUpdates();
 
-    if (!m_oldDocumentImage.isNull()) {
+    if (!m_oldDocumentTiledImage.isNull()) {
+        doc->setImageAt(m_oldDocumentTiledImage.copy(m_documentBoundingRect), m_documentBoundingRect.topLeft());
+    } else if (!m_oldDocumentImage.isNull()) {
         doc->setImageAt(m_oldDocumentImage, m_documentBoundingRect.topLeft());
     }
 
@@ -162,8 +164,14 @@ void kpToolSelectionMoveCommand::copyOntoDocument()
     // to be consistent with the requirement on other selection operations.
     Q_ASSERT(sel && sel->hasContent());
 
-    if (m_oldDocumentImage.isNull()) {
-        m_oldDocumentImage = doc->image();
+    // (a cheap snapshot either way, until finalize() keeps just the part
+    //  that changed)
+    if (m_oldDocumentImage.isNull() && m_oldDocumentTiledImage.isNull()) {
+        if (doc->isTiled()) {
+            m_oldDocumentTiledImage = doc->tiledImage();
+        } else {
+            m_oldDocumentImage = doc->image();
+        }
     }
 
     QRect selBoundingRect = sel->boundingRect();
@@ -177,7 +185,12 @@ void kpToolSelectionMoveCommand::copyOntoDocument()
 // public
 void kpToolSelectionMoveCommand::finalize()
 {
-    if (!m_oldDocumentImage.isNull() && !m_documentBoundingRect.isNull()) {
+    if (!m_oldDocumentTiledImage.isNull()) {
+        if (!m_documentBoundingRect.isNull()) {
+            m_oldDocumentImage = m_oldDocumentTiledImage.copy(m_documentBoundingRect);
+        }
+        m_oldDocumentTiledImage = kpTiledImage();
+    } else if (!m_oldDocumentImage.isNull() && !m_documentBoundingRect.isNull()) {
         m_oldDocumentImage = kpTool::neededPixmap(m_oldDocumentImage, m_documentBoundingRect);
     }
 }
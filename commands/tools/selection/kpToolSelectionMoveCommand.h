@@ -14,6 +14,7 @@
 
 #include "commands/kpNamedCommand.h"
 #include "imagelib/kpImage.h"
+#include "imagelib/kpTiledImage.h"
 
 class kpAbstractSelection;
 
@@ -39,6 +40,9 @@ private:
     QPoint m_startPoint, m_endPoint;
 
     kpImage m_oldDocumentImage;
+    // Instead of <m_oldDocumentImage> until finalize(), for a tiled
+    // document.
+    kpTiledImage m_oldDocumentTiledImage;
 
     // area of document affected (not the bounding rect of the sel)
     QRect m_documentBoundingRect;
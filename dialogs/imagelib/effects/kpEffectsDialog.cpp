@@ -9,6 +9,8 @@
 
 #include "kpEffectsDialog.h"
 
+#include "commands/imagelib/effects/kpEffectChainCommand.h"
+#include "commands/kpMacroCommand.h"
 #include "document/kpDocument.h"
 #include "environments/dialogs/imagelib/transforms/kpTransformDialogEnvironment.h"
 #include "kpDefs.h"
@@ -31,7 +33,10 @@
 #include <QImage>
 #include <QLabel>
 #include <QLayout>
-#include <QTimer>
+#include <QPromise>
+#include <QPushButton>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 // protected static
 int kpEffectsDialog::s_lastWidth = 640;
@@ -45,8 +50,12 @@ kpEffectsDialog::kpEffectsDialog(bool actOnSelection, kpTransformDialogEnvironme
                                actOnSelection,
                                _env,
                                parent)
-    , m_delayedUpdateTimer(new QTimer(this))
+    , m_previewThreadPool(new QThreadPool(this))
+    , m_previewWatcher(new QFutureWatcher<QImage>(this))
     , m_effectsComboBox(nullptr)
+    , m_addToChainButton(nullptr)
+    , m_clearChainButton(nullptr)
+    , m_chainLabel(nullptr)
     , m_settingsGroupBox(nullptr)
     , m_settingsLayout(nullptr)
     , m_effectWidget(nullptr)
@@ -63,8 +72,10 @@ kpEffectsDialog::kpEffectsDialog(bool actOnSelection, kpTransformDialogEnvironme
         setWindowTitle(i18nc("@title:window", "More Image Effects"));
     }
 
-    m_delayedUpdateTimer->setSingleShot(true);
-    connect(m_delayedUpdateTimer, &QTimer::timeout, this, &kpEffectsDialog::slotUpdateWithWaitCursor);
+    // Only the most recent preview is of interest so there is no point
+    // computing several at once.
+    m_previewThreadPool->setMaxThreadCount(1);
+    connect(m_previewWatcher, &QFutureWatcher<QImage>::resultReadyAt, this, &kpEffectsDialog::slotPreviewResultReady);
 
     QWidget *effectContainer = new QWidget(mainWidget());
 
@@ -86,13 +97,26 @@ kpEffectsDialog::kpEffectsDialog(bool actOnSelection, kpTransformDialogEnvironme
     m_effectsComboBox->addItem(i18n("Reduce Colors"));
     m_effectsComboBox->addItem(i18n("Soften & Sharpen"));
 
+    m_addToChainButton = new QPushButton(i18n("&Then Apply Another"), effectContainer);
+    m_addToChainButton->setToolTip(i18n("Keep this effect and choose another one to apply after it"));
+    m_clearChainButton = new QPushButton(i18n("C&lear"), effectContainer);
+
     containerLayout->addWidget(label);
     containerLayout->addWidget(m_effectsComboBox, 1);
+    containerLayout->addWidget(m_addToChainButton);
+    containerLayout->addWidget(m_clearChainButton);
 
     label->setBuddy(m_effectsComboBox);
 
     addCustomWidgetToFront(effectContainer);
 
+    m_chainLabel = new QLabel(mainWidget());
+    m_chainLabel->setWordWrap(true);
+    addCustomWidget(m_chainLabel);
+
+    connect(m_addToChainButton, &QPushButton::clicked, this, &kpEffectsDialog::slotAddToChain);
+    connect(m_clearChainButton, &QPushButton::clicked, this, &kpEffectsDialog::slotClearChain);
+
     m_settingsGroupBox = new QGroupBox(mainWidget());
     m_settingsLayout = new QVBoxLayout(m_settingsGroupBox);
     addCustomWidgetToBack(m_settingsGroupBox);
@@ -116,6 +140,9 @@ kpEffectsDialog::kpEffectsDialog(bool actOnSelection, kpTransformDialogEnvironme
 
 kpEffectsDialog::~kpEffectsDialog()
 {
+    cancelPreview();
+    m_previewThreadPool->waitForDone();
+
     s_lastWidth = width();
     s_lastHeight = height();
 }
@@ -123,6 +150,10 @@ kpEffectsDialog::~kpEffectsDialog()
 // public virtual [base kpTransformPreviewDialog]
 bool kpEffectsDialog::isNoOp() const
 {
+    if (!m_chain.isEmpty()) {
+        return false;
+    }
+
     if (!m_effectWidget) {
         return true;
     }
@@ -131,13 +162,29 @@ bool kpEffectsDialog::isNoOp() const
 }
 
 // public
-kpEffectCommandBase *kpEffectsDialog::createCommand() const
+kpCommand *kpEffectsDialog::createCommand() const
 {
-    if (!m_effectWidget) {
-        return nullptr;
+    kpCommandEnvironment *cmdEnviron = m_environ->commandEnvironment();
+
+    if (m_chain.isEmpty()) {
+        if (!m_effectWidget) {
+            return nullptr;
+        }
+
+        return m_effectWidget->createCommand(cmdEnviron);
     }
 
-    return m_effectWidget->createCommand(m_environ->commandEnvironment());
+    kpEffectChain chain = m_chain;
+    if (!m_effectWidget || m_effectWidget->isNoOp() || m_effectWidget->addToChain(&chain)) {
+        return new kpEffectChainCommand(chain, m_actOnSelection, cmdEnviron);
+    }
+
+    // The selected effect cannot be part of the chain so it is applied
+    // afterwards, as part of the same undo step.
+    auto *macroCmd = new kpMacroCommand(i18n("Adjustments"), cmdEnviron);
+    macroCmd->addCommand(new kpEffectChainCommand(chain, m_actOnSelection, cmdEnviron));
+    macroCmd->addCommand(m_effectWidget->createCommand(cmdEnviron));
+    return macroCmd;
 }
 
 // protected virtual [base kpTransformPreviewDialog]
@@ -154,15 +201,33 @@ QSize kpEffectsDialog::newDimensions() const
 // protected virtual [base kpTransformPreviewDialog]
 QImage kpEffectsDialog::transformPixmap(const QImage &pixmap, int targetWidth, int targetHeight) const
 {
-    QImage pixmapWithEffect;
+    const kpEffectFunction effect = effectFunction();
+    const QImage pixmapWithEffect = effect ? effect(pixmap) : pixmap;
 
-    if (m_effectWidget && !m_effectWidget->isNoOp()) {
-        pixmapWithEffect = m_effectWidget->applyEffect(pixmap);
-    } else {
-        pixmapWithEffect = pixmap;
+    return kpPixmapFX::scale(pixmapWithEffect, targetWidth, targetHeight);
+}
+
+// protected
+kpEffectFunction kpEffectsDialog::effectFunction() const
+{
+    const bool haveEffect = (m_effectWidget && !m_effectWidget->isNoOp());
+
+    if (m_chain.isEmpty()) {
+        return haveEffect ? m_effectWidget->effectFunction() : kpEffectFunction();
     }
 
-    return kpPixmapFX::scale(pixmapWithEffect, targetWidth, targetHeight);
+    // Preview the selected effect as part of the chain, if possible, to
+    // get the single pass that createCommand() will use.
+    kpEffectChain chain = m_chain;
+    kpEffectFunction effectAfterChain;
+    if (haveEffect && !m_effectWidget->addToChain(&chain)) {
+        effectAfterChain = m_effectWidget->effectFunction();
+    }
+
+    return [chain, effectAfterChain](const kpImage &image) {
+        const kpImage chainedImage = chain.applyEffect(image);
+        return effectAfterChain ? effectAfterChain(chainedImage) : chainedImage;
+    };
 }
 
 // public
@@ -252,7 +317,13 @@ void kpEffectsDialog::selectEffect(int which)
 
         connect(m_effectWidget, &kpEffectWidgetBase::settingsChangedNoWaitCursor, this, &kpEffectsDialog::slotUpdate);
         connect(m_effectWidget, &kpEffectWidgetBase::settingsChanged, this, &kpEffectsDialog::slotUpdateWithWaitCursor);
-        connect(m_effectWidget, &kpEffectWidgetBase::settingsChangedDelayed, this, &kpEffectsDialog::slotDelayedUpdate);
+        // The preview is computed in the background so there is no need to
+        // wait for settingsChangedDelayed() activity to stop.
+        connect(m_effectWidget, &kpEffectWidgetBase::settingsChangedDelayed, this, &kpEffectsDialog::slotUpdate);
+
+        connect(m_effectWidget, &kpEffectWidgetBase::settingsChangedNoWaitCursor, this, &kpEffectsDialog::updateChainWidgets);
+        connect(m_effectWidget, &kpEffectWidgetBase::settingsChanged, this, &kpEffectsDialog::updateChainWidgets);
+        connect(m_effectWidget, &kpEffectWidgetBase::settingsChangedDelayed, this, &kpEffectsDialog::updateChainWidgets);
 
 #if DEBUG_KP_EFFECTS_DIALOG
         qCDebug(kpLogDialogs) << "about to setUpdatesEnabled()";
@@ -260,48 +331,140 @@ void kpEffectsDialog::selectEffect(int which)
         setUpdatesEnabled(e);
     }
 
+    updateChainWidgets();
+
 #if DEBUG_KP_EFFECTS_DIALOG
     qCDebug(kpLogDialogs) << "done" << endl << endl << endl;
 #endif
 }
 
-// protected slot virtual [base kpTransformPreviewDialog]
-void kpEffectsDialog::slotUpdate()
+// protected slot
+void kpEffectsDialog::slotAddToChain()
 {
-#if DEBUG_KP_EFFECTS_DIALOG
-    qCDebug(kpLogDialogs) << "kpEffectsDialog::slotUpdate()"
-                          << " timerActive=" << m_delayedUpdateTimer->isActive() << endl;
-#endif
+    if (!m_effectWidget || m_effectWidget->isNoOp()) {
+        return;
+    }
+
+    if (!m_effectWidget->addToChain(&m_chain)) {
+        return;
+    }
 
-    m_delayedUpdateTimer->stop();
+    m_chainEffectNames.append(m_effectsComboBox->currentText());
 
-    kpTransformPreviewDialog::slotUpdate();
+    // Start the next effect from fresh settings, so that the one just
+    // added is not applied twice.
+    selectEffect(m_effectsComboBox->currentIndex());
+
+    slotUpdate();
+}
+
+// protected slot
+void kpEffectsDialog::slotClearChain()
+{
+    m_chain = kpEffectChain();
+    m_chainEffectNames.clear();
+
+    updateChainWidgets();
+    slotUpdate();
+}
+
+// protected slot
+void kpEffectsDialog::updateChainWidgets()
+{
+    kpEffectChain probe;
+    m_addToChainButton->setEnabled(m_effectWidget && !m_effectWidget->isNoOp() && m_effectWidget->addToChain(&probe));
+    m_clearChainButton->setEnabled(!m_chain.isEmpty());
+
+    if (m_chain.isEmpty()) {
+        m_chainLabel->hide();
+    } else {
+        m_chainLabel->setText(i18n("Applied first: %1", m_chainEffectNames.join(i18nc("separator between effect names", ", "))));
+        m_chainLabel->show();
+    }
+}
+
+// Computes the preview of <effect> applied to <shrunkenDocumentPixmap>
+// scaled to <targetSize>.
+//
+// Unless the image is already tiny, a quick preview computed from a
+// downscaled copy is reported first, followed by the full resolution one.
+static void ComputePreview(QPromise<QImage> &promise, const kpImage &shrunkenDocumentPixmap, const kpEffectFunction &effect, const QSize &targetSize)
+{
+    // The coarse preview is computed from an image with 1/<CoarseFactor>
+    // of the width and height of the full resolution one.
+    const int CoarseFactor = 4;
+    const int MinCoarseLength = 32;
+
+    if (promise.isCanceled()) {
+        return;
+    }
+
+    auto applyEffect = [&](const kpImage &image) {
+        return kpPixmapFX::scale(effect ? effect(image) : image, targetSize.width(), targetSize.height());
+    };
+
+    if (effect && shrunkenDocumentPixmap.width() / CoarseFactor >= MinCoarseLength
+        && shrunkenDocumentPixmap.height() / CoarseFactor >= MinCoarseLength) {
+        const kpImage coarseImage = kpPixmapFX::scale(shrunkenDocumentPixmap,
+                                                      shrunkenDocumentPixmap.width() / CoarseFactor,
+                                                      shrunkenDocumentPixmap.height() / CoarseFactor);
+        promise.addResult(applyEffect(coarseImage));
+
+        if (promise.isCanceled()) {
+            return;
+        }
+    }
+
+    promise.addResult(applyEffect(shrunkenDocumentPixmap));
 }
 
 // protected slot virtual [base kpTransformPreviewDialog]
-void kpEffectsDialog::slotUpdateWithWaitCursor()
+void kpEffectsDialog::updatePreview()
 {
 #if DEBUG_KP_EFFECTS_DIALOG
-    qCDebug(kpLogDialogs) << "kpEffectsDialog::slotUpdateWithWaitCursor()"
-                          << " timerActive=" << m_delayedUpdateTimer->isActive() << endl;
+    qCDebug(kpLogDialogs) << "kpEffectsDialog::updatePreview()"
+                          << " running=" << m_previewWatcher->isRunning() << endl;
 #endif
 
-    m_delayedUpdateTimer->stop();
+    if (!canUpdatePreview()) {
+        return;
+    }
+
+    updateShrunkenDocumentPixmap();
+
+    if (m_shrunkenDocumentPixmap.isNull()) {
+        return;
+    }
 
-    kpTransformPreviewDialog::slotUpdateWithWaitCursor();
+    cancelPreview();
+
+    const kpEffectFunction effect = effectFunction();
+
+    // (resultReadyAt() from the previous future, if still pending, is
+    //  discarded by setFuture())
+    m_previewWatcher->setFuture(QtConcurrent::run(m_previewThreadPool, &ComputePreview, m_shrunkenDocumentPixmap, effect, previewTargetSize()));
 }
 
 // protected slot
-void kpEffectsDialog::slotDelayedUpdate()
+void kpEffectsDialog::slotPreviewResultReady(int index)
 {
 #if DEBUG_KP_EFFECTS_DIALOG
-    qCDebug(kpLogDialogs) << "kpEffectsDialog::slotDelayedUpdate()"
-                          << " timerActive=" << m_delayedUpdateTimer->isActive() << endl;
+    qCDebug(kpLogDialogs) << "kpEffectsDialog::slotPreviewResultReady(" << index << ")";
 #endif
-    m_delayedUpdateTimer->stop();
 
-    // (single shot)
-    m_delayedUpdateTimer->start(400 /*ms*/);
+    if (m_previewWatcher->isCanceled()) {
+        return;
+    }
+
+    setPreviewPixmap(m_previewWatcher->resultAt(index));
+}
+
+// protected
+void kpEffectsDialog::cancelPreview()
+{
+    // The effect itself cannot be interrupted but ComputePreview() stops
+    // at the next opportunity and its results are no longer reported.
+    m_previewWatcher->cancel();
 }
 
 #include "moc_kpEffectsDialog.cpp"
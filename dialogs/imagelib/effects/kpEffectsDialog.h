@@ -8,16 +8,22 @@
 #ifndef KP_EFFECTS_DIALOG_H
 #define KP_EFFECTS_DIALOG_H
 
+#include <QFutureWatcher>
+#include <QImage>
+#include <QStringList>
+
 #include "dialogs/imagelib/transforms/kpTransformPreviewDialog.h"
+#include "imagelib/effects/kpEffectChain.h"
+#include "widgets/imagelib/effects/kpEffectWidgetBase.h"
 
 class QComboBox;
 class QGroupBox;
-class QImage;
-class QTimer;
+class QLabel;
+class QPushButton;
+class QThreadPool;
 class QVBoxLayout;
 
-class kpEffectCommandBase;
-class kpEffectWidgetBase;
+class kpCommand;
 
 class kpEffectsDialog : public kpTransformPreviewDialog
 {
@@ -30,33 +36,60 @@ public:
     ~kpEffectsDialog() override;
 
     bool isNoOp() const override;
-    kpEffectCommandBase *createCommand() const;
+
+    // Returns a kpEffectChainCommand if effects were added to the chain,
+    // otherwise the command of the selected effect.
+    kpCommand *createCommand() const;
 
 protected:
     QSize newDimensions() const override;
     QImage transformPixmap(const QImage &pixmap, int targetWidth, int targetHeight) const override;
 
+    // Returns the chain followed by the selected effect, or an empty
+    // function if both are no-ops.
+    kpEffectFunction effectFunction() const;
+
 public:
     int selectedEffect() const;
 public Q_SLOTS:
     void selectEffect(int which);
 
 protected Q_SLOTS:
-    void slotUpdate() override;
-    void slotUpdateWithWaitCursor() override;
+    // Computes the preview on a worker thread, first at a coarse resolution
+    // and then at the resolution of the preview label.  Any preview still
+    // being computed for the previous settings is cancelled.
+    void updatePreview() override;
+
+    void slotPreviewResultReady(int index);
 
-    void slotDelayedUpdate();
+    // Appends the selected effect to the chain so that another effect can
+    // be applied after it.
+    void slotAddToChain();
+    void slotClearChain();
+
+    void updateChainWidgets();
 
 protected:
+    void cancelPreview();
+
     static int s_lastWidth, s_lastHeight;
 
-    QTimer *m_delayedUpdateTimer;
+    QThreadPool *m_previewThreadPool;
+    QFutureWatcher<QImage> *m_previewWatcher;
 
     QComboBox *m_effectsComboBox;
+    QPushButton *m_addToChainButton;
+    QPushButton *m_clearChainButton;
+    QLabel *m_chainLabel;
     QGroupBox *m_settingsGroupBox;
     QVBoxLayout *m_settingsLayout;
 
     kpEffectWidgetBase *m_effectWidget;
+
+    // The effects, applied before the selected one, that were added with
+    // slotAddToChain().
+    kpEffectChain m_chain;
+    QStringList m_chainEffectNames;
 };
 
 #endif // KP_EFFECTS_DIALOG_H
@@ -23,6 +23,7 @@
 #include "environments/dialogs/imagelib/transforms/kpTransformDialogEnvironment.h"
 #include "generic/widgets/kpResizeSignallingLabel.h"
 #include "imagelib/kpColor.h"
+#include "imagelib/kpImagePyramid.h"
 #include "layers/selections/image/kpAbstractImageSelection.h"
 #include "pixmapfx/kpPixmapFX.h"
 
@@ -217,7 +218,7 @@ int kpTransformPreviewDialog::scaleDimension(int dimension, double scale, int mi
     return qMax(min, qMin(max, qRound(dimension * scale)));
 }
 
-// private
+// protected
 void kpTransformPreviewDialog::updateShrunkenDocumentPixmap()
 {
 #if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
@@ -232,7 +233,7 @@ void kpTransformPreviewDialog::updateShrunkenDocumentPixmap()
     }
 
     kpDocument *doc = document();
-    Q_ASSERT(doc && !doc->image().isNull());
+    Q_ASSERT(doc && !doc->rect().isEmpty());
 
     if (m_shrunkenDocumentPixmap.isNull() || m_previewPixmapLabel->size() != m_previewPixmapLabelSizeWhenUpdatedPixmap) {
 #if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
@@ -243,6 +244,9 @@ void kpTransformPreviewDialog::updateShrunkenDocumentPixmap()
         //       Isn't scaling the skewed result maintaining aspect enough?
         double keepsAspectScale = aspectScale(m_previewPixmapLabel->width(), m_previewPixmapLabel->height(), m_oldWidth, m_oldHeight);
 
+        const int shrunkenWidth = scaleDimension(m_oldWidth, keepsAspectScale, 1, m_previewPixmapLabel->width());
+        const int shrunkenHeight = scaleDimension(m_oldHeight, keepsAspectScale, 1, m_previewPixmapLabel->height());
+
         kpImage image;
 
         if (m_actOnSelection) {
@@ -254,84 +258,106 @@ void kpTransformPreviewDialog::updateShrunkenDocumentPixmap()
             image = sel->transparentImage();
             delete sel;
         } else {
-            image = doc->image();
+            // Start from the smallest cached level that is still big
+            // enough, rather than the full resolution image.
+            image = doc->downsampledImage(
+                kpImagePyramid::levelForScale(qMax(double(shrunkenWidth) / double(m_oldWidth), double(shrunkenHeight) / double(m_oldHeight))));
         }
 
-        m_shrunkenDocumentPixmap = kpPixmapFX::scale(image,
-                                                     scaleDimension(m_oldWidth, keepsAspectScale, 1, m_previewPixmapLabel->width()),
-                                                     scaleDimension(m_oldHeight, keepsAspectScale, 1, m_previewPixmapLabel->height()));
+        m_shrunkenDocumentPixmap = kpPixmapFX::scale(image, shrunkenWidth, shrunkenHeight);
 
         m_previewPixmapLabelSizeWhenUpdatedPixmap = m_previewPixmapLabel->size();
     }
 }
 
-// private
-void kpTransformPreviewDialog::updatePreview()
+// protected
+bool kpTransformPreviewDialog::canUpdatePreview() const
 {
-#if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
-    qCDebug(kpLogDialogs) << "kpTransformPreviewDialog::updatePreview()";
-#endif
-
     if (!m_previewGroupBox) {
-        return;
+        return false;
     }
 
-    kpDocument *doc = document();
-    if (!doc) {
-        return;
+    if (!document()) {
+        return false;
     }
 
     if (!updatesEnabled()) {
 #if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
         qCDebug(kpLogDialogs) << "updates not enabled - aborting";
 #endif
-        return;
+        return false;
     }
 
-    updateShrunkenDocumentPixmap();
-
-    if (!m_shrunkenDocumentPixmap.isNull()) {
-        QSize newDim = newDimensions();
-        double keepsAspectScale = aspectScale(m_previewPixmapLabel->width(), m_previewPixmapLabel->height(), newDim.width(), newDim.height());
-
-        int targetWidth = scaleDimension(newDim.width(),
-                                         keepsAspectScale,
-                                         1, // min
-                                         m_previewPixmapLabel->width()); // max
-        int targetHeight = scaleDimension(newDim.height(),
-                                          keepsAspectScale,
-                                          1, // min
-                                          m_previewPixmapLabel->height()); // max
+    return true;
+}
 
-        // TODO: Some effects work directly on QImage; so could cache the
-        //       QImage so that transformPixmap() is faster
-        QImage transformedShrunkenDocumentPixmap = transformPixmap(m_shrunkenDocumentPixmap, targetWidth, targetHeight);
+// protected
+QSize kpTransformPreviewDialog::previewTargetSize() const
+{
+    QSize newDim = newDimensions();
+    double keepsAspectScale = aspectScale(m_previewPixmapLabel->width(), m_previewPixmapLabel->height(), newDim.width(), newDim.height());
+
+    int targetWidth = scaleDimension(newDim.width(),
+                                     keepsAspectScale,
+                                     1, // min
+                                     m_previewPixmapLabel->width()); // max
+    int targetHeight = scaleDimension(newDim.height(),
+                                      keepsAspectScale,
+                                      1, // min
+                                      m_previewPixmapLabel->height()); // max
+
+    return {targetWidth, targetHeight};
+}
 
-        QImage previewPixmap(m_previewPixmapLabel->width(), m_previewPixmapLabel->height(), QImage::Format_ARGB32_Premultiplied);
-        previewPixmap.fill(QColor(Qt::transparent).rgba());
-        kpPixmapFX::setPixmapAt(&previewPixmap,
-                                (previewPixmap.width() - transformedShrunkenDocumentPixmap.width()) / 2,
-                                (previewPixmap.height() - transformedShrunkenDocumentPixmap.height()) / 2,
-                                transformedShrunkenDocumentPixmap);
+// protected
+void kpTransformPreviewDialog::setPreviewPixmap(const QImage &transformedShrunkenDocumentPixmap)
+{
+    QImage previewPixmap(m_previewPixmapLabel->width(), m_previewPixmapLabel->height(), QImage::Format_ARGB32_Premultiplied);
+    previewPixmap.fill(QColor(Qt::transparent).rgba());
+    kpPixmapFX::setPixmapAt(&previewPixmap,
+                            (previewPixmap.width() - transformedShrunkenDocumentPixmap.width()) / 2,
+                            (previewPixmap.height() - transformedShrunkenDocumentPixmap.height()) / 2,
+                            transformedShrunkenDocumentPixmap);
 
 #if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
-        qCDebug(kpLogDialogs) << "kpTransformPreviewDialog::updatePreview ():"
-                              << "   shrunkenDocumentPixmap: w=" << m_shrunkenDocumentPixmap.width() << " h=" << m_shrunkenDocumentPixmap.height()
-                              << "   previewPixmapLabel: w=" << m_previewPixmapLabel->width() << " h=" << m_previewPixmapLabel->height()
-                              << "   transformedShrunkenDocumentPixmap: w=" << transformedShrunkenDocumentPixmap.width()
-                              << " h=" << transformedShrunkenDocumentPixmap.height() << "   previewPixmap: w=" << previewPixmap.width()
-                              << " h=" << previewPixmap.height() << endl;
+    qCDebug(kpLogDialogs) << "kpTransformPreviewDialog::setPreviewPixmap ():"
+                          << "   shrunkenDocumentPixmap: w=" << m_shrunkenDocumentPixmap.width() << " h=" << m_shrunkenDocumentPixmap.height()
+                          << "   previewPixmapLabel: w=" << m_previewPixmapLabel->width() << " h=" << m_previewPixmapLabel->height()
+                          << "   transformedShrunkenDocumentPixmap: w=" << transformedShrunkenDocumentPixmap.width()
+                          << " h=" << transformedShrunkenDocumentPixmap.height() << "   previewPixmap: w=" << previewPixmap.width()
+                          << " h=" << previewPixmap.height() << endl;
 #endif
 
-        m_previewPixmapLabel->setPixmap(QPixmap::fromImage(previewPixmap));
+    m_previewPixmapLabel->setPixmap(QPixmap::fromImage(previewPixmap));
 
-        // immediate update esp. for expensive previews
-        m_previewPixmapLabel->repaint();
+    // immediate update esp. for expensive previews
+    m_previewPixmapLabel->repaint();
 
 #if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
-        qCDebug(kpLogDialogs) << "\tafter QLabel::setPixmap() previewPixmapLabel: w=" << m_previewPixmapLabel->width()
-                              << " h=" << m_previewPixmapLabel->height() << endl;
+    qCDebug(kpLogDialogs) << "\tafter QLabel::setPixmap() previewPixmapLabel: w=" << m_previewPixmapLabel->width()
+                          << " h=" << m_previewPixmapLabel->height() << endl;
+#endif
+}
+
+// protected slot virtual
+void kpTransformPreviewDialog::updatePreview()
+{
+#if DEBUG_KP_TRANSFORM_PREVIEW_DIALOG
+    qCDebug(kpLogDialogs) << "kpTransformPreviewDialog::updatePreview()";
 #endif
+
+    if (!canUpdatePreview()) {
+        return;
+    }
+
+    updateShrunkenDocumentPixmap();
+
+    if (!m_shrunkenDocumentPixmap.isNull()) {
+        const QSize targetSize = previewTargetSize();
+
+        // TODO: Some effects work directly on QImage; so could cache the
+        //       QImage so that transformPixmap() is faster
+        setPreviewPixmap(transformPixmap(m_shrunkenDocumentPixmap, targetSize.width(), targetSize.height()));
     }
 }
 
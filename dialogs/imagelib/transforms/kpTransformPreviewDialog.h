@@ -80,11 +80,18 @@ public:
     static double aspectScale(int newWidth, int newHeight, int oldWidth, int oldHeight);
     static int scaleDimension(int dimension, double scale, int min, int max);
 
-private:
+protected:
     void updateShrunkenDocumentPixmap();
 
+    // Returns whether the preview is shown and can be updated now.
+    bool canUpdatePreview() const;
+    // Returns the size that transformPixmap() should scale the preview to.
+    QSize previewTargetSize() const;
+    // Shows <transformedShrunkenDocumentPixmap>, centered, in the preview label.
+    void setPreviewPixmap(const QImage &transformedShrunkenDocumentPixmap);
+
 protected Q_SLOTS:
-    void updatePreview();
+    virtual void updatePreview();
 
     // Call this whenever a value (e.g. an angle) changes
     // and the Dimensions & Preview need to be updated
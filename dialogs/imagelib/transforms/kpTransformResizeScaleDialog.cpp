@@ -39,6 +39,7 @@
 
 #define kpSettingResizeScaleLastKeepAspect "Resize Scale - Last Keep Aspect"
 #define kpSettingResizeScaleScaleType "Resize Scale - ScaleType"
+#define kpSettingResizeScaleSmoothScaleFilter "Resize Scale - Smooth Scale Filter"
 
 //---------------------------------------------------------------------
 
@@ -89,6 +90,8 @@ kpTransformResizeScaleDialog::kpTransformResizeScaleDialog(kpTransformDialogEnvi
     setKeepAspectRatio(cfg.readEntry(kpSettingResizeScaleLastKeepAspect, false));
     m_lastType =
         static_cast<kpTransformResizeScaleCommand::Type>(cfg.readEntry(kpSettingResizeScaleScaleType, static_cast<int>(kpTransformResizeScaleCommand::Resize)));
+    m_smoothScaleFilterCombo->setCurrentIndex(
+        qBound(0, cfg.readEntry(kpSettingResizeScaleSmoothScaleFilter, static_cast<int>(kpTransformResample::Bilinear)), m_smoothScaleFilterCombo->count() - 1));
 
     slotActOnChanged();
 
@@ -200,7 +203,9 @@ QGroupBox *kpTransformResizeScaleDialog::createOperationGroupBox(QWidget *baseWi
 
              "<li><b>Smooth Scale</b>: This is the same as"
              " <i>Scale</i> except that it blends neighboring"
-             " pixels to produce a smoother looking picture.</li>"
+             " pixels to produce a smoother looking picture."
+             " The <b>Filter</b> chooses how: <i>Bilinear</i> is fastest,"
+             " <i>Mitchell</i> and <i>Lanczos</i> are sharper.</li>"
              "</ul>"
              "</qt>"));
 
@@ -218,10 +223,22 @@ QGroupBox *kpTransformResizeScaleDialog::createOperationGroupBox(QWidget *baseWi
     resizeScaleButtonGroup->addButton(m_scaleButton);
     resizeScaleButtonGroup->addButton(m_smoothScaleButton);
 
+    m_smoothScaleFilterLabel = new QLabel(i18n("&Filter:"), operationGroupBox);
+    m_smoothScaleFilterCombo = new QComboBox(operationGroupBox);
+    m_smoothScaleFilterCombo->insertItem(kpTransformResample::Bilinear, i18n("Bilinear"));
+    m_smoothScaleFilterCombo->insertItem(kpTransformResample::Mitchell, i18n("Mitchell"));
+    m_smoothScaleFilterCombo->insertItem(kpTransformResample::Lanczos3, i18n("Lanczos"));
+    m_smoothScaleFilterLabel->setBuddy(m_smoothScaleFilterCombo);
+
+    auto *filterLayout = new QHBoxLayout();
+    filterLayout->addWidget(m_smoothScaleFilterLabel);
+    filterLayout->addWidget(m_smoothScaleFilterCombo, 1);
+
     auto *operationLayout = new QGridLayout(operationGroupBox);
     operationLayout->addWidget(m_resizeButton, 0, 0, Qt::AlignCenter);
     operationLayout->addWidget(m_scaleButton, 0, 1, Qt::AlignCenter);
     operationLayout->addWidget(m_smoothScaleButton, 0, 2, Qt::AlignCenter);
+    operationLayout->addLayout(filterLayout, 1, 2);
 
     connect(m_resizeButton, &QToolButton::toggled, this, &kpTransformResizeScaleDialog::slotTypeChanged);
     connect(m_scaleButton, &QToolButton::toggled, this, &kpTransformResizeScaleDialog::slotTypeChanged);
@@ -449,6 +466,9 @@ void kpTransformResizeScaleDialog::slotActOnChanged()
 void kpTransformResizeScaleDialog::slotTypeChanged()
 {
     m_lastType = type();
+
+    m_smoothScaleFilterLabel->setEnabled(m_lastType == kpTransformResizeScaleCommand::SmoothScale);
+    m_smoothScaleFilterCombo->setEnabled(m_lastType == kpTransformResizeScaleCommand::SmoothScale);
 }
 
 //---------------------------------------------------------------------
@@ -599,6 +619,14 @@ kpTransformResizeScaleCommand::Type kpTransformResizeScaleDialog::type() const
 //---------------------------------------------------------------------
 // public
 
+kpTransformResample::Filter kpTransformResizeScaleDialog::smoothScaleFilter() const
+{
+    return static_cast<kpTransformResample::Filter>(m_smoothScaleFilterCombo->currentIndex());
+}
+
+//---------------------------------------------------------------------
+// public
+
 bool kpTransformResizeScaleDialog::isNoOp() const
 {
     return (imageWidth() == originalWidth() && imageHeight() == originalHeight());
@@ -737,6 +765,7 @@ void kpTransformResizeScaleDialog::accept()
 
     cfg.writeEntry(kpSettingResizeScaleLastKeepAspect, m_keepAspectRatioCheckBox->isChecked());
     cfg.writeEntry(kpSettingResizeScaleScaleType, static_cast<int>(m_lastType));
+    cfg.writeEntry(kpSettingResizeScaleSmoothScaleFilter, static_cast<int>(smoothScaleFilter()));
     cfg.sync();
 }
 
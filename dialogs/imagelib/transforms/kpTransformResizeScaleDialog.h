@@ -16,6 +16,7 @@
 class QCheckBox;
 class QComboBox;
 class QGroupBox;
+class QLabel;
 class QToolButton;
 class QSpinBox;
 class QDoubleSpinBox;
@@ -41,6 +42,7 @@ public:
     int imageHeight() const;
     bool actOnSelection() const;
     kpTransformResizeScaleCommand::Type type() const;
+    kpTransformResample::Filter smoothScaleFilter() const;
 
     bool isNoOp() const;
 
@@ -82,6 +84,8 @@ private:
     QComboBox *m_actOnCombo;
 
     QToolButton *m_resizeButton, *m_scaleButton, *m_smoothScaleButton;
+    QLabel *m_smoothScaleFilterLabel;
+    QComboBox *m_smoothScaleFilterCombo;
 
     QSpinBox *m_originalWidthInput, *m_originalHeightInput, *m_newWidthInput, *m_newHeightInput;
     QDoubleSpinBox *m_percentWidthInput, *m_percentHeightInput;
@@ -114,7 +114,7 @@ QSize kpTransformSkewDialog::newDimensions() const
     kpDocument *doc = document();
     Q_ASSERT(doc);
 
-    auto skewMatrix = kpPixmapFX::skewMatrix(doc->image(), horizontalAngleForPixmapFX(), verticalAngleForPixmapFX());
+    auto skewMatrix = kpPixmapFX::skewMatrix(doc->width(), doc->height(), horizontalAngleForPixmapFX(), verticalAngleForPixmapFX());
     auto skewRect = skewMatrix.mapRect(doc->rect(m_actOnSelection));
 
     return {skewRect.width(), skewRect.height()};
@@ -88,6 +88,16 @@ void kpDocumentSaveOptionsPreviewDialog::setFilePixmapAndSize(const QImage &pixm
     m_fileSizeLabel->setText(i18np("1 byte (approx. %2%)", "%1 bytes (approx. %2%)", m_fileSize, percent));
 }
 
+// public slot
+void kpDocumentSaveOptionsPreviewDialog::setFileSizeEstimate(qint64 fileSize)
+{
+#if DEBUG_KP_DOCUMENT_SAVE_OPTIONS_WIDGET
+    qCDebug(kpLogDialogs) << "kpDocumentSaveOptionsPreviewDialog::setFileSizeEstimate(" << fileSize << ")";
+#endif
+
+    m_fileSizeLabel->setText(i18np("About 1 byte (estimating...)", "About %1 bytes (estimating...)", fileSize));
+}
+
 // public slot
 void kpDocumentSaveOptionsPreviewDialog::updatePixmapPreview()
 {
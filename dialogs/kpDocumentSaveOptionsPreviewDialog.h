@@ -40,6 +40,9 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     void setFilePixmapAndSize(const QImage &filePixmap, qint64 fileSize);
+    // Shows <fileSize> as an estimate while the real file size is being
+    // computed.  The file pixmap is left as is.
+    void setFileSizeEstimate(qint64 fileSize);
     void updatePixmapPreview();
 
 protected:
@@ -0,0 +1,783 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_BATCH_PROCESSOR 0
+
+#include "document/kpBatchProcessor.h"
+
+#include "document/kpDocument.h"
+#include "document/kpDocumentSaveOptions.h"
+#include "imagelib/effects/kpEffectBalance.h"
+#include "imagelib/effects/kpEffectBlurSharpen.h"
+#include "imagelib/effects/kpEffectChain.h"
+#include "imagelib/effects/kpEffectEmboss.h"
+#include "imagelib/effects/kpEffectInvert.h"
+#include "imagelib/effects/kpEffectReduceColors.h"
+#include "imagelib/effects/kpEffectToneEnhance.h"
+#include "imagelib/kpColor.h"
+#include "imagelib/kpDocumentMetaInfo.h"
+#include "imagelib/transforms/kpTransformAutoCrop.h"
+#include "imagelib/transforms/kpTransformResample.h"
+#include "pixmapfx/kpPixmapFX.h"
+
+#include "kpLogCategories.h"
+#include <KLocalizedString>
+
+#include <QColor>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QList>
+#include <QMimeDatabase>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QUrl>
+#include <QtConcurrentMap>
+
+#include <climits>
+#include <cstdio>
+
+//---------------------------------------------------------------------
+
+namespace
+{
+struct BatchOperation {
+    enum Type {
+        AutoCrop,
+        Scale,
+        Rotate,
+        Skew,
+        Flip,
+        ReduceColors,
+        BlurSharpen,
+        Emboss,
+        ToneEnhance,
+        // Consecutive Balance, Flatten, Grayscale, HSV and Invert
+        // operations, which are applied in one pass.
+        PixelEffects
+    };
+
+    Type type{AutoCrop};
+
+    // AutoCrop
+    int processedColorSimilarity{0};
+
+    // Scale (a <width> or <height> of 0 keeps the aspect ratio)
+    int width{0}, height{0};
+    double percent{0};
+    bool smooth{false};
+    kpTransformResample::Filter filter{kpTransformResample::Bilinear};
+
+    // Rotate & Skew (in degrees)
+    double angle{0}, verticalAngle{0};
+    kpColor backgroundColor{kpColor::White};
+
+    // Flip
+    bool horizontal{false}, vertical{false};
+
+    // ReduceColors
+    int depth{0};
+    bool dither{false};
+
+    // BlurSharpen & Emboss
+    kpEffectBlurSharpen::Type blurSharpenType{kpEffectBlurSharpen::None};
+    int strength{0};
+
+    // ToneEnhance
+    double granularity{0}, amount{0};
+
+    // PixelEffects
+    kpEffectChain chain;
+};
+
+// A file to process and where to save it (see PlanOutputPaths()).
+struct BatchFile {
+    QString path;
+    QString outputPath;
+
+    // If set, the file is not processed at all.
+    bool outputOverwritesInput{false};
+};
+
+struct FileResult {
+    enum Error {
+        NoError,
+        OutputOverwritesInput,
+        CouldNotRead,
+        CouldNotDecode,
+        CouldNotWrite
+    };
+
+    Error error{NoError};
+    QString errorString;
+
+    QString outputPath;
+    QSize inputSize, outputSize;
+
+    qint64 readMsecs{0}, processMsecs{0}, writeMsecs{0};
+};
+}
+
+//---------------------------------------------------------------------
+
+struct kpBatchProcessorPrivate {
+    QList<BatchOperation> operations;
+
+    QString outputDirectory;
+    QString mimeType;
+    int quality{kpDocumentSaveOptions::invalidQuality()};
+    int colorDepth{kpDocumentSaveOptions::invalidColorDepth()};
+    bool dither{false};
+
+    int maxJobs{QThread::idealThreadCount()};
+    int memoryLimit{2048};
+};
+
+//---------------------------------------------------------------------
+
+kpBatchProcessor::kpBatchProcessor()
+    : d(new kpBatchProcessorPrivate())
+{
+}
+
+//---------------------------------------------------------------------
+
+kpBatchProcessor::~kpBatchProcessor()
+{
+    delete d;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QString kpBatchProcessor::operationsHelpText()
+{
+    return i18n(
+        "Operations:\n"
+        "  autocrop[:similarity%]\n"
+        "  scale:<width>x<height>[:fast|bilinear|mitchell|lanczos3]\n"
+        "  scale:<percent>%[:fast|bilinear|mitchell|lanczos3]\n"
+        "  rotate:<degrees>[:background color]\n"
+        "  skew:<horizontal degrees>:<vertical degrees>[:background color]\n"
+        "  flip:horizontal|vertical\n"
+        "  reduce-colors:1|8[:dither]\n"
+        "  blur:<strength 0-10>\n"
+        "  sharpen:<strength 0-10>\n"
+        "  emboss:<strength 0-10>\n"
+        "  tone-enhance:<granularity 0-1>:<amount 0-1>\n"
+        "  balance:<brightness>:<contrast>:<gamma> (each -50 to 50)\n"
+        "  hsv:<hue -180-180>:<saturation -1-1>:<value -1-1>\n"
+        "  flatten:<color>:<color>\n"
+        "  grayscale\n"
+        "  invert\n"
+        "A width or height of 0 keeps the aspect ratio.  The background color\n"
+        "defaults to white.");
+}
+
+//---------------------------------------------------------------------
+
+// Sets <*number> to <text> if it is a number in [<min>, <max>].
+static bool ParseNumber(const QString &text, double min, double max, double *number)
+{
+    bool ok = false;
+    const double value = text.toDouble(&ok);
+    if (!ok || value < min || value > max) {
+        return false;
+    }
+
+    *number = value;
+    return true;
+}
+
+static bool ParseInteger(const QString &text, int min, int max, int *number)
+{
+    bool ok = false;
+    const int value = text.toInt(&ok);
+    if (!ok || value < min || value > max) {
+        return false;
+    }
+
+    *number = value;
+    return true;
+}
+
+static bool ParseColor(const QString &text, QColor *color)
+{
+    *color = QColor::fromString(text);
+    return color->isValid();
+}
+
+// Parses "<width>x<height>" or "<percent>%" into <operation>.
+static bool ParseScaleSize(const QString &text, BatchOperation *operation)
+{
+    if (text.endsWith(QLatin1Char('%'))) {
+        return ::ParseNumber(text.chopped(1), 0.01, 10000, &operation->percent);
+    }
+
+    const QStringList dimensions = text.split(QLatin1Char('x'));
+    if (dimensions.count() != 2 || !::ParseInteger(dimensions[0], 0, INT_MAX, &operation->width)
+        || !::ParseInteger(dimensions[1], 0, INT_MAX, &operation->height)) {
+        return false;
+    }
+
+    return (operation->width > 0 || operation->height > 0);
+}
+
+static bool ParseScaleFilter(const QString &text, BatchOperation *operation)
+{
+    operation->smooth = true;
+
+    if (text == QLatin1String("fast")) {
+        operation->smooth = false;
+    } else if (text == QLatin1String("bilinear")) {
+        operation->filter = kpTransformResample::Bilinear;
+    } else if (text == QLatin1String("mitchell")) {
+        operation->filter = kpTransformResample::Mitchell;
+    } else if (text == QLatin1String("lanczos3")) {
+        operation->filter = kpTransformResample::Lanczos3;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+// Parses <name> with <args> into <operation>.
+static bool ParseOperation(const QString &name, const QStringList &args, BatchOperation *operation)
+{
+    const int numArgs = args.count();
+
+    if (name == QLatin1String("autocrop")) {
+        operation->type = BatchOperation::AutoCrop;
+
+        if (numArgs > 1) {
+            return false;
+        }
+
+        double similarity = 0;
+        if (numArgs == 1 && !::ParseNumber(QString(args[0]).remove(QLatin1Char('%')), 0, 100, &similarity)) {
+            return false;
+        }
+
+        operation->processedColorSimilarity = kpColor::processSimilarity(similarity / 100);
+        return true;
+    }
+
+    if (name == QLatin1String("scale")) {
+        operation->type = BatchOperation::Scale;
+
+        return (numArgs == 1 || numArgs == 2) && ::ParseScaleSize(args[0], operation) && (numArgs == 1 || ::ParseScaleFilter(args[1], operation));
+    }
+
+    if (name == QLatin1String("rotate") || name == QLatin1String("skew")) {
+        const bool rotate = (name == QLatin1String("rotate"));
+        operation->type = rotate ? BatchOperation::Rotate : BatchOperation::Skew;
+
+        const int numAngles = rotate ? 1 : 2;
+        if (numArgs != numAngles && numArgs != numAngles + 1) {
+            return false;
+        }
+
+        // (kpPixmapFX::skew() only accepts angles strictly between -90 and 90)
+        if (!::ParseNumber(args[0], rotate ? -360 : -89, rotate ? 360 : 89, &operation->angle)
+            || (!rotate && !::ParseNumber(args[1], -89, 89, &operation->verticalAngle))) {
+            return false;
+        }
+
+        if (numArgs == numAngles + 1) {
+            QColor color;
+            if (!::ParseColor(args[numAngles], &color)) {
+                return false;
+            }
+
+            operation->backgroundColor = kpColor(color.rgba());
+        }
+
+        return true;
+    }
+
+    if (name == QLatin1String("flip")) {
+        operation->type = BatchOperation::Flip;
+
+        if (numArgs != 1) {
+            return false;
+        }
+
+        operation->horizontal = (args[0] == QLatin1String("horizontal"));
+        operation->vertical = (args[0] == QLatin1String("vertical"));
+        return (operation->horizontal || operation->vertical);
+    }
+
+    if (name == QLatin1String("reduce-colors")) {
+        operation->type = BatchOperation::ReduceColors;
+
+        if (numArgs != 1 && numArgs != 2) {
+            return false;
+        }
+
+        operation->depth = args[0].toInt();
+        operation->dither = (numArgs == 2);
+        return (operation->depth == 1 || operation->depth == 8) && (numArgs == 1 || args[1] == QLatin1String("dither"));
+    }
+
+    if (name == QLatin1String("blur") || name == QLatin1String("sharpen") || name == QLatin1String("emboss")) {
+        if (name == QLatin1String("emboss")) {
+            operation->type = BatchOperation::Emboss;
+        } else {
+            operation->type = BatchOperation::BlurSharpen;
+            operation->blurSharpenType = (name == QLatin1String("blur")) ? kpEffectBlurSharpen::Blur : kpEffectBlurSharpen::Sharpen;
+        }
+
+        return numArgs == 1 && ::ParseInteger(args[0], kpEffectBlurSharpen::MinStrength, kpEffectBlurSharpen::MaxStrength, &operation->strength);
+    }
+
+    if (name == QLatin1String("tone-enhance")) {
+        operation->type = BatchOperation::ToneEnhance;
+
+        return numArgs == 2 && ::ParseNumber(args[0], 0, 1, &operation->granularity) && ::ParseNumber(args[1], 0, 1, &operation->amount);
+    }
+
+    //
+    // Per-pixel effects
+    //
+
+    operation->type = BatchOperation::PixelEffects;
+
+    if (name == QLatin1String("balance")) {
+        int brightness = 0, contrast = 0, gamma = 0;
+        if (numArgs != 3 || !::ParseInteger(args[0], -50, 50, &brightness) || !::ParseInteger(args[1], -50, 50, &contrast)
+            || !::ParseInteger(args[2], -50, 50, &gamma)) {
+            return false;
+        }
+
+        operation->chain.addBalance(kpEffectBalance::RGB, brightness, contrast, gamma);
+        return true;
+    }
+
+    if (name == QLatin1String("hsv")) {
+        double hue = 0, saturation = 0, value = 0;
+        if (numArgs != 3 || !::ParseNumber(args[0], -180, 180, &hue) || !::ParseNumber(args[1], -1, 1, &saturation)
+            || !::ParseNumber(args[2], -1, 1, &value)) {
+            return false;
+        }
+
+        operation->chain.addHSV(hue, saturation, value);
+        return true;
+    }
+
+    if (name == QLatin1String("flatten")) {
+        QColor color1, color2;
+        if (numArgs != 2 || !::ParseColor(args[0], &color1) || !::ParseColor(args[1], &color2)) {
+            return false;
+        }
+
+        operation->chain.addFlatten(color1, color2);
+        return true;
+    }
+
+    if (name == QLatin1String("grayscale")) {
+        if (numArgs != 0) {
+            return false;
+        }
+
+        operation->chain.addGrayscale();
+        return true;
+    }
+
+    if (name == QLatin1String("invert")) {
+        if (numArgs != 0) {
+            return false;
+        }
+
+        operation->chain.addInvert(kpEffectInvert::RGB);
+        return true;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpBatchProcessor::addOperation(const QString &operation, QString *errorString)
+{
+    const QStringList parts = operation.split(QLatin1Char(':'));
+
+    BatchOperation parsed;
+    if (!::ParseOperation(parts.first().toLower(), parts.mid(1), &parsed)) {
+        if (errorString) {
+            *errorString = i18n("Invalid operation \"%1\".", operation);
+        }
+
+        return false;
+    }
+
+    // Per-pixel effects in a row share one pass over the image: parsing the
+    // (now known to be valid) effect again appends it to the previous chain.
+    if (parsed.type == BatchOperation::PixelEffects && !d->operations.isEmpty() && d->operations.last().type == BatchOperation::PixelEffects) {
+        ::ParseOperation(parts.first().toLower(), parts.mid(1), &d->operations.last());
+    } else {
+        d->operations.append(parsed);
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpBatchProcessor::setOutputDirectory(const QString &dir)
+{
+    d->outputDirectory = dir;
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpBatchProcessor::setOutputFormat(const QString &format)
+{
+    QMimeDatabase db;
+
+    const QMimeType mimeType = format.contains(QLatin1Char('/')) ? db.mimeTypeForName(format)
+                                                                 : db.mimeTypeForFile(QLatin1String("image.") + format, QMimeDatabase::MatchExtension);
+    if (!mimeType.isValid() || !QImageWriter::supportedMimeTypes().contains(mimeType.name().toLatin1())) {
+        return false;
+    }
+
+    d->mimeType = mimeType.name();
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpBatchProcessor::setQuality(int quality)
+{
+    d->quality = quality;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpBatchProcessor::setColorDepth(int colorDepth, bool dither)
+{
+    d->colorDepth = colorDepth;
+    d->dither = dither;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpBatchProcessor::setMaxJobs(int maxJobs)
+{
+    d->maxJobs = qMax(1, maxJobs);
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpBatchProcessor::setMemoryLimit(int megabytes)
+{
+    d->memoryLimit = qMax(1, megabytes);
+}
+
+//---------------------------------------------------------------------
+
+// Returns the approximate memory, in megabytes, that processing the
+// image file <path> needs: the decoded image, the result of the current
+// operation and the copy that is encoded.
+static int EstimateMegabytes(const QString &path, const kpBatchProcessorPrivate &settings)
+{
+    // (only reads the header)
+    const QSize size = QImageReader(path).size();
+    if (!size.isValid()) {
+        return qMax(1, settings.memoryLimit / settings.maxJobs);
+    }
+
+    const qint64 bytes = qint64(size.width()) * size.height() * 4 * 3;
+
+    // An image that is bigger than the whole limit waits for every other
+    // file to finish and is then processed alone.
+    return static_cast<int>(qBound(qint64(1), (bytes + 1024 * 1024 - 1) / (1024 * 1024), qint64(settings.memoryLimit)));
+}
+
+static kpImage ApplyOperation(const kpImage &image, const BatchOperation &operation)
+{
+    switch (operation.type) {
+    case BatchOperation::AutoCrop: {
+        const QRect rect = kpTransformAutoCropContentsRect(image, operation.processedColorSimilarity);
+        return rect.isEmpty() ? image : kpPixmapFX::getPixmapAt(image, rect);
+    }
+
+    case BatchOperation::Scale: {
+        int width = operation.width, height = operation.height;
+        if (operation.percent > 0) {
+            width = qMax(1, qRound(image.width() * operation.percent / 100));
+            height = qMax(1, qRound(image.height() * operation.percent / 100));
+        } else if (width == 0) {
+            width = qMax(1, qRound(double(image.width()) * height / image.height()));
+        } else if (height == 0) {
+            height = qMax(1, qRound(double(image.height()) * width / image.width()));
+        }
+
+        return operation.smooth ? kpTransformResample::scale(image, width, height, operation.filter) : kpPixmapFX::scale(image, width, height);
+    }
+
+    case BatchOperation::Rotate:
+        return kpPixmapFX::rotate(image, operation.angle, operation.backgroundColor);
+
+    case BatchOperation::Skew:
+        return kpPixmapFX::skew(image, operation.angle, operation.verticalAngle, operation.backgroundColor);
+
+    case BatchOperation::Flip:
+        return kpPixmapFX::flip(image, operation.horizontal, operation.vertical);
+
+    case BatchOperation::ReduceColors:
+        return kpEffectReduceColors::applyEffect(image, operation.depth, operation.dither);
+
+    case BatchOperation::BlurSharpen:
+        return kpEffectBlurSharpen::applyEffect(image, operation.blurSharpenType, operation.strength);
+
+    case BatchOperation::Emboss:
+        return kpEffectEmboss::applyEffect(image, operation.strength);
+
+    case BatchOperation::ToneEnhance:
+        return kpEffectToneEnhance::applyEffect(image, operation.granularity, operation.amount);
+
+    case BatchOperation::PixelEffects:
+        return operation.chain.applyEffect(image);
+    }
+
+    return image;
+}
+
+// Returns <path> in a form in which two paths to the same file compare
+// equal, even if the file does not exist yet.
+static QString ComparablePath(const QString &path)
+{
+    const QFileInfo fileInfo(path);
+    if (fileInfo.exists()) {
+        return fileInfo.canonicalFilePath();
+    }
+
+    const QString canonicalDir = fileInfo.absoluteDir().canonicalPath();
+    return canonicalDir.isEmpty() ? fileInfo.absoluteFilePath() : QDir(canonicalDir).filePath(fileInfo.fileName());
+}
+
+// Returns the file extension that <path> is saved with: that of the
+// output format or else of the format that kpDocument::decodeLocalFile()
+// will detect.
+static QString OutputSuffix(const QString &path, const kpBatchProcessorPrivate &settings)
+{
+    QMimeDatabase db;
+
+    if (!settings.mimeType.isEmpty()) {
+        return db.mimeTypeForName(settings.mimeType).preferredSuffix();
+    }
+
+    QFile file(path);
+    return db.mimeTypeForFileNameAndData(QFileInfo(path).fileName(), &file).preferredSuffix();
+}
+
+// Decides, before any file is processed, where each of <files> is saved:
+// "<output directory>/<base name>.<suffix>".
+//
+// Files that would be saved to the same path as an earlier one (e.g.
+// "a.png" and "a.jpg" when converting to PNG) get "-2", "-3" etc. added
+// to their base names instead, so that no result overwrites another.  A
+// file whose output path is one of the input files is not processed at
+// all.
+static QList<BatchFile> PlanOutputPaths(const QStringList &files, const kpBatchProcessorPrivate &settings)
+{
+    QSet<QString> inputPaths;
+    for (const QString &path : files) {
+        inputPaths.insert(::ComparablePath(path));
+    }
+
+    const QDir outputDir(settings.outputDirectory);
+    QSet<QString> outputPaths;
+
+    QList<BatchFile> batchFiles;
+    batchFiles.reserve(files.count());
+
+    for (const QString &path : files) {
+        const QString baseName = QFileInfo(path).completeBaseName();
+        const QString suffix = ::OutputSuffix(path, settings);
+
+        BatchFile batchFile;
+        batchFile.path = path;
+
+        QString comparableOutputPath;
+        for (int n = 1;; n++) {
+            const QString fileName = (n == 1) ? baseName + QLatin1Char('.') + suffix : QStringLiteral("%1-%2.%3").arg(baseName).arg(n).arg(suffix);
+            batchFile.outputPath = outputDir.filePath(fileName);
+            comparableOutputPath = ::ComparablePath(batchFile.outputPath);
+
+            // (a numbered name must not clash with an input file either)
+            if (!outputPaths.contains(comparableOutputPath) && (n == 1 || !inputPaths.contains(comparableOutputPath))) {
+                break;
+            }
+        }
+
+        outputPaths.insert(comparableOutputPath);
+        batchFile.outputOverwritesInput = inputPaths.contains(comparableOutputPath);
+
+        batchFiles.append(batchFile);
+    }
+
+    return batchFiles;
+}
+
+// Runs on a thread of the batch thread pool.  Shows no dialogs and
+// leaves the messages to the caller.
+static FileResult ProcessFile(const BatchFile &batchFile, const kpBatchProcessorPrivate &settings, QSemaphore *memory)
+{
+    const QString &path = batchFile.path;
+
+#if DEBUG_KP_BATCH_PROCESSOR
+    qCDebug(kpLogDocument) << "kpBatchProcessor ProcessFile(" << path << ") ->" << batchFile.outputPath;
+#endif
+
+    FileResult result;
+    result.outputPath = batchFile.outputPath;
+
+    if (batchFile.outputOverwritesInput) {
+        result.error = FileResult::OutputOverwritesInput;
+        return result;
+    }
+
+    const int megabytes = ::EstimateMegabytes(path, settings);
+    memory->acquire(megabytes);
+    const QSemaphoreReleaser memoryReleaser(memory, megabytes);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QFileInfo fileInfo(path);
+
+    kpDocumentSaveOptions saveOptions;
+    kpDocumentMetaInfo metaInfo;
+    bool readOK = false;
+    kpImage image = kpDocument::decodeLocalFile(QUrl::fromLocalFile(fileInfo.absoluteFilePath()), &saveOptions, &metaInfo, &readOK);
+
+    result.readMsecs = timer.restart();
+
+    if (!readOK || image.isNull()) {
+        result.error = readOK ? FileResult::CouldNotDecode : FileResult::CouldNotRead;
+        return result;
+    }
+
+    result.inputSize = image.size();
+
+    for (const BatchOperation &operation : settings.operations) {
+        image = ::ApplyOperation(image, operation);
+    }
+
+    result.outputSize = image.size();
+    result.processMsecs = timer.restart();
+
+    if (!settings.mimeType.isEmpty()) {
+        saveOptions.setMimeType(settings.mimeType);
+    }
+    if (!kpDocumentSaveOptions::qualityIsInvalid(settings.quality)) {
+        saveOptions.setQuality(settings.quality);
+    }
+    if (!kpDocumentSaveOptions::colorDepthIsInvalid(settings.colorDepth)) {
+        saveOptions.setColorDepth(settings.colorDepth);
+        saveOptions.setDither(settings.dither);
+    }
+
+    if (!kpDocument::writeLocalFile(image, result.outputPath, saveOptions, metaInfo, &result.errorString)) {
+        result.error = FileResult::CouldNotWrite;
+    }
+
+    result.writeMsecs = timer.elapsed();
+
+    return result;
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpBatchProcessor::run(const QStringList &files) const
+{
+#if DEBUG_KP_BATCH_PROCESSOR
+    qCDebug(kpLogDocument) << "kpBatchProcessor::run() files=" << files.count() << "operations=" << d->operations.count() << "maxJobs=" << d->maxJobs
+                           << "memoryLimit=" << d->memoryLimit;
+#endif
+
+    // The operations spread big images across the global thread pool, so
+    // the files get their own pool: waiting for the operations must never
+    // take up the threads that they need.
+    QThreadPool pool;
+    pool.setMaxThreadCount(d->maxJobs);
+
+    QSemaphore memory(d->memoryLimit);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const kpBatchProcessorPrivate &settings = *d;
+    const QList<BatchFile> batchFiles = ::PlanOutputPaths(files, settings);
+    const QList<FileResult> results = QtConcurrent::blockingMapped<QList<FileResult>>(&pool, batchFiles, [&settings, &memory](const BatchFile &batchFile) {
+        return ::ProcessFile(batchFile, settings, &memory);
+    });
+
+    const qint64 totalMsecs = timer.elapsed();
+
+    int numFailed = 0;
+    for (int i = 0; i < files.count(); i++) {
+        const FileResult &result = results[i];
+
+        QString errorString;
+        switch (result.error) {
+        case FileResult::NoError:
+            break;
+        case FileResult::OutputOverwritesInput:
+            errorString = i18n("Not processed because saving it as \"%1\" would overwrite an input file.", result.outputPath);
+            break;
+        case FileResult::CouldNotRead:
+            errorString = i18n("Could not open the file.");
+            break;
+        case FileResult::CouldNotDecode:
+            errorString = i18n("The file is not a supported image.");
+            break;
+        case FileResult::CouldNotWrite:
+            errorString = i18n("Could not save \"%1\": %2",
+                               result.outputPath,
+                               result.errorString.isEmpty() ? i18n("Error saving image") : result.errorString);
+            break;
+        }
+
+        if (!errorString.isEmpty()) {
+            fprintf(stderr, "%s: %s\n", qPrintable(files[i]), qPrintable(errorString));
+            numFailed++;
+            continue;
+        }
+
+        printf("%s\n",
+               qPrintable(i18n("%1 -> %2: %3x%4 -> %5x%6, read %7 ms, process %8 ms, write %9 ms",
+                               files[i],
+                               result.outputPath,
+                               result.inputSize.width(),
+                               result.inputSize.height(),
+                               result.outputSize.width(),
+                               result.outputSize.height(),
+                               result.readMsecs,
+                               result.processMsecs,
+                               result.writeMsecs)));
+    }
+
+    printf("%s\n", qPrintable(i18np("Processed 1 file in %2 ms (%3 failed).", "Processed %1 files in %2 ms (%3 failed).", files.count(), totalMsecs, numFailed)));
+
+    return numFailed;
+}
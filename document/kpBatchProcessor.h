@@ -0,0 +1,76 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpBatchProcessor_H
+#define kpBatchProcessor_H
+
+#include <QString>
+#include <QStringList>
+
+//
+// Applies a sequence of operations to many image files without any
+// windows, for "kolourpaint --batch".
+//
+// Each operation is given as "name[:argument[:argument...]]", e.g.
+// "autocrop", "scale:640x480:lanczos3" or "reduce-colors:8:dither" (see
+// operationsHelpText()).  The operations use the same imagelib code as the
+// corresponding commands and effects dialogs.
+//
+// Files are processed on a dedicated thread pool, so that the threads
+// that the operations themselves use are never starved.  A file is only
+// started once its estimated memory use fits in the memory limit, together
+// with the other files in progress.
+//
+
+class kpBatchProcessor
+{
+public:
+    kpBatchProcessor();
+    ~kpBatchProcessor();
+
+    kpBatchProcessor(const kpBatchProcessor &) = delete;
+    kpBatchProcessor &operator=(const kpBatchProcessor &) = delete;
+
+    // Returns a description of every operation, for --help.
+    static QString operationsHelpText();
+
+    // Parses <operation> and appends it to the operations applied to every
+    // file.  Returns false and sets <errorString> if it is not valid.
+    bool addOperation(const QString &operation, QString *errorString);
+
+    // Output files are written to <dir>, keeping their base names.  If two
+    // files would be saved to the same path, the later one gets a number
+    // added to its base name.  A file that would be saved over one of the
+    // input files is not processed.
+    void setOutputDirectory(const QString &dir);
+
+    // <format> is a file extension (e.g. "png") or a MIME type.  If it is
+    // never set, every file is saved in the format it was read in.
+    // Returns false if images cannot be saved in <format>.
+    bool setOutputFormat(const QString &format);
+
+    // Overrides the quality and color depth that would otherwise be read
+    // from each file (see kpDocumentSaveOptions).
+    void setQuality(int quality);
+    void setColorDepth(int colorDepth, bool dither);
+
+    // The maximum number of files processed at the same time.
+    void setMaxJobs(int maxJobs);
+    // The approximate memory, in megabytes, that the images of the files
+    // in progress may use together.
+    void setMemoryLimit(int megabytes);
+
+    // Processes <files> and prints the timing of every file to stdout
+    // once they have all been processed.  Returns the number of files
+    // that could not be processed.
+    int run(const QStringList &files) const;
+
+private:
+    struct kpBatchProcessorPrivate *d;
+};
+
+#endif // kpBatchProcessor_H
@@ -15,6 +15,7 @@
 #include "imagelib/effects/kpEffectReduceColors.h"
 #include "imagelib/kpColor.h"
 #include "imagelib/kpDocumentMetaInfo.h"
+#include "imagelib/kpTiledImage.h"
 #include "kpDefs.h"
 #include "layers/selections/image/kpAbstractImageSelection.h"
 #include "layers/selections/kpAbstractSelection.h"
@@ -31,6 +32,7 @@
 
 #include <QColor>
 #include <QImage>
+#include <QPoint>
 #include <QRect>
 #include <QSize>
 
@@ -54,16 +56,40 @@ kpDocument::kpDocument(int w, int h, kpDocumentEnvironment *environ)
     qCDebug(kpLogDocument) << "kpDocument::kpDocument (" << w << "," << h << ")";
 #endif
 
-    m_image = new kpImage(w, h, QImage::Format_ARGB32_Premultiplied);
-    m_image->fill(QColor(Qt::white).rgb());
-
     d->environ = environ;
+
+    // 64 MiB of pixels (4096x4096).  Below this, filling the image is quick
+    // and an untiled document is cheaper to draw on directly (see
+    // beginDirectDraw()).
+    const qint64 MinTiledBytes = qint64(64) << 20;
+
+    if (qint64(w) * h * 4 < MinTiledBytes) {
+        m_image = new kpImage(w, h, QImage::Format_ARGB32_Premultiplied);
+        m_image->fill(QColor(Qt::white).rgb());
+        return;
+    }
+
+    // Start out as just the color white, whatever the size.  Pixels are
+    // only allocated for the tiles that get drawn on.
+    m_image = new kpImage();
+    d->tiledImage = kpTiledImage(w, h, QColor(Qt::white).rgb());
+
+    // Don't even try to keep an image that does not fit in memory there.
+    if (needsOutOfCore(QSize(w, h))) {
+        d->tiledImage.setOutOfCore();
+    }
 }
 
 //---------------------------------------------------------------------
 
 kpDocument::~kpDocument()
 {
+    // Let the file be completely written but don't report the result.
+    if (d->saveWatcher) {
+        d->saveWatcher->waitForFinished();
+        delete d->saveWatcher;
+    }
+
     delete d;
 
     delete m_image;
@@ -192,6 +218,10 @@ void kpDocument::setMetaInfo(const kpDocumentMetaInfo &metaInfo)
 
 void kpDocument::setModified(bool yes)
 {
+    if (yes) {
+        d->modificationCount++;
+    }
+
     if (yes == m_modified) {
         return;
     }
@@ -228,7 +258,7 @@ int kpDocument::constructorWidth() const
 
 int kpDocument::width(bool ofSelection) const
 {
-    return (ofSelection && m_selection) ? m_selection->width() : m_image->width();
+    return (ofSelection && m_selection) ? m_selection->width() : isTiled() ? d->tiledImage.width() : m_image->width();
 }
 
 //---------------------------------------------------------------------
@@ -256,7 +286,7 @@ int kpDocument::constructorHeight() const
 
 int kpDocument::height(bool ofSelection) const
 {
-    return (ofSelection && m_selection) ? m_selection->height() : m_image->height();
+    return (ofSelection && m_selection) ? m_selection->height() : isTiled() ? d->tiledImage.height() : m_image->height();
 }
 
 //---------------------------------------------------------------------
@@ -277,7 +307,7 @@ void kpDocument::setHeight(int h, const kpColor &backgroundColor)
 
 QRect kpDocument::rect(bool ofSelection) const
 {
-    return (ofSelection && m_selection) ? m_selection->boundingRect() : m_image->rect();
+    return (ofSelection && m_selection) ? m_selection->boundingRect() : isTiled() ? d->tiledImage.rect() : m_image->rect();
 }
 
 //---------------------------------------------------------------------
@@ -285,6 +315,10 @@ QRect kpDocument::rect(bool ofSelection) const
 // public
 kpImage kpDocument::getImageAt(const QRect &rect) const
 {
+    if (isTiled()) {
+        return d->tiledImage.copy(rect);
+    }
+
     return kpPixmapFX::getPixmapAt(*m_image, rect);
 }
 
@@ -297,7 +331,11 @@ void kpDocument::setImageAt(const kpImage &image, const QPoint &at)
     qCDebug(kpLogDocument) << "kpDocument::setImageAt (image (w=" << image.width() << ",h=" << image.height() << "), x=" << at.x() << ",y=" << at.y();
 #endif
 
-    kpPixmapFX::setPixmapAt(m_image, at, image);
+    if (isTiled()) {
+        d->tiledImage.setImageAt(image, at);
+    } else {
+        kpPixmapFX::setPixmapAt(m_image, at, image);
+    }
     slotContentsChanged(QRect(at.x(), at.y(), image.width(), image.height()));
 }
 
@@ -313,6 +351,11 @@ kpImage kpDocument::image(bool ofSelection) const
         Q_ASSERT(imageSel);
 
         ret = imageSel->baseImage();
+    } else if (isOutOfCore()) {
+        // Would not fit in memory.
+        qCWarning(kpLogDocument) << "kpDocument::image() refusing to put together an out of core" << d->tiledImage.size() << "image";
+    } else if (isTiled()) {
+        ret = d->tiledImage.toImage();
     } else {
         ret = *m_image;
     }
@@ -325,18 +368,166 @@ kpImage kpDocument::image(bool ofSelection) const
 // public
 kpImage *kpDocument::imagePointer() const
 {
+    if (isOutOfCore()) {
+        qCWarning(kpLogDocument) << "kpDocument::imagePointer() refusing to put together an out of core" << d->tiledImage.size() << "image";
+        return nullptr;
+    }
+
+    if (isTiled()) {
+#if DEBUG_KP_DOCUMENT
+        qCDebug(kpLogDocument) << "kpDocument::imagePointer() untiling";
+#endif
+        const kpImage image = d->tiledImage.toImage();
+        if (image.isNull()) {
+            // Out of memory - keep the tiles.
+            qCWarning(kpLogDocument) << "kpDocument::imagePointer() could not put together a" << d->tiledImage.size() << "image";
+            return nullptr;
+        }
+
+        // The pixels stay the same, so this is still const.
+        *m_image = image;
+        d->tiledImage = kpTiledImage();
+    }
+
     return m_image;
 }
 
 //---------------------------------------------------------------------
 
+// public
+kpImage *kpDocument::beginDirectDraw(const QRect &rect, QPoint *origin)
+{
+    Q_ASSERT(origin);
+
+    if (!isTiled()) {
+        *origin = QPoint(0, 0);
+        return m_image;
+    }
+
+    d->directDrawImage = d->tiledImage.copy(rect);
+    d->directDrawOrigin = rect.topLeft();
+
+    *origin = d->directDrawOrigin;
+    return &d->directDrawImage;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocument::endDirectDraw()
+{
+    if (!d->directDrawImage.isNull()) {
+        d->tiledImage.setImageAt(d->directDrawImage, d->directDrawOrigin);
+        d->directDrawImage = kpImage();
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpDocument::isTiled() const
+{
+    return !d->tiledImage.isNull();
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocument::setTiled(bool yes)
+{
+    if (yes == isTiled()) {
+        return;
+    }
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::setTiled(" << yes << ")";
+#endif
+
+    if (yes) {
+        d->tiledImage = kpTiledImage(*m_image);
+        *m_image = kpImage();
+    } else {
+        // (stays tiled if it does not fit in memory)
+        imagePointer();
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpDocument::isOutOfCore() const
+{
+    return isTiled() && d->tiledImage.isOutOfCore();
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpDocument::setOutOfCore(bool yes)
+{
+    if (yes) {
+        setTiled();
+    } else if (!isTiled()) {
+        return true;
+    }
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::setOutOfCore(" << yes << ")";
+#endif
+
+    return d->tiledImage.setOutOfCore(yes);
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpTiledImage kpDocument::tiledImage() const
+{
+    Q_ASSERT(isTiled());
+    return d->tiledImage;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpDocument::downsampledImage(int level) const
+{
+    if (isTiled()) {
+        return d->imagePyramid.level(d->tiledImage, level);
+    }
+
+    return d->imagePyramid.level(*m_image, level);
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpDocument::downsampledImageAt(int level, const QRect &levelRect) const
+{
+    if (isTiled()) {
+        return d->imagePyramid.levelAt(d->tiledImage, level, levelRect);
+    }
+
+    return d->imagePyramid.level(*m_image, level).copy(levelRect);
+}
+
+//---------------------------------------------------------------------
+
 // public
 void kpDocument::setImage(const kpImage &image)
 {
     m_oldWidth = width();
     m_oldHeight = height();
 
-    *m_image = image;
+    if (isTiled()) {
+        const bool outOfCore = d->tiledImage.isOutOfCore();
+        d->tiledImage = kpTiledImage(image);
+        if (outOfCore) {
+            d->tiledImage.setOutOfCore();
+        }
+    } else {
+        *m_image = image;
+    }
 
     if (m_oldWidth == width() && m_oldHeight == height()) {
         slotContentsChanged(image.rect());
@@ -370,8 +561,12 @@ void kpDocument::fill(const kpColor &color)
     qCDebug(kpLogDocument) << "kpDocument::fill ()";
 #endif
 
-    m_image->fill(color.toQRgb());
-    slotContentsChanged(m_image->rect());
+    if (isTiled()) {
+        d->tiledImage.fill(color.toQRgb());
+    } else {
+        m_image->fill(color.toQRgb());
+    }
+    slotContentsChanged(rect());
 }
 
 //---------------------------------------------------------------------
@@ -393,7 +588,11 @@ void kpDocument::resize(int w, int h, const kpColor &backgroundColor)
         return;
     }
 
-    kpPixmapFX::resize(m_image, w, h, backgroundColor);
+    if (isTiled()) {
+        d->tiledImage.resize(w, h, backgroundColor.toQRgb());
+    } else {
+        kpPixmapFX::resize(m_image, w, h, backgroundColor);
+    }
 
     slotSizeChanged(QSize(width(), height()));
 }
@@ -402,6 +601,8 @@ void kpDocument::resize(int w, int h, const kpColor &backgroundColor)
 
 void kpDocument::slotContentsChanged(const QRect &rect)
 {
+    d->imagePyramid.invalidate(rect);
+
     setModified();
     Q_EMIT contentsChanged(rect);
 }
@@ -410,6 +611,8 @@ void kpDocument::slotContentsChanged(const QRect &rect)
 
 void kpDocument::slotSizeChanged(const QSize &newSize)
 {
+    d->imagePyramid.invalidate();
+
     setModified();
     Q_EMIT sizeChanged(newSize.width(), newSize.height());
     Q_EMIT sizeChanged(newSize);
@@ -16,6 +16,7 @@
 #include "pixmapfx/kpPixmapFX.h"
 #undef environ
 
+class QByteArray;
 class QImage;
 class QIODevice;
 class QPoint;
@@ -24,6 +25,7 @@ class QSize;
 
 class kpColor;
 class kpDocumentEnvironment;
+class kpTiledImage;
 class kpDocumentSaveOptions;
 class kpDocumentMetaInfo;
 class kpAbstractImageSelection;
@@ -44,6 +46,10 @@ public:
     //              and constructorHeight()) need not be specified.
     //
     //           ?
+    //
+    // The document starts out as a <w>x<h> image of solid white.  A big
+    // one (at least 64 MiB of pixels) is tiled, which takes no time or
+    // memory whatever the size, until it is drawn on (see isTiled()).
     kpDocument(int w, int h, kpDocumentEnvironment *environ);
     ~kpDocument() override;
 
@@ -59,10 +65,46 @@ public:
                                     QWidget *parent,
                                     kpDocumentSaveOptions *saveOptions = nullptr,
                                     kpDocumentMetaInfo *metaInfo = nullptr);
+    // Decodes <data>, which was read from <url>, and converts it to
+    // QImage::Format_ARGB32_Premultiplied.  Returns a null image if <data>
+    // is not a supported image.  Shows no dialogs, so it is safe to call
+    // from any thread.
+    static QImage decodeImage(const QByteArray &data,
+                              const QUrl &url,
+                              kpDocumentSaveOptions *saveOptions = nullptr,
+                              kpDocumentMetaInfo *metaInfo = nullptr);
+    // Same as decodeImage() but reads the local file <url> through a memory
+    // mapping, without KIO.  <readOK> is set to whether the file could be
+    // opened.
+    static QImage decodeLocalFile(const QUrl &url,
+                                  kpDocumentSaveOptions *saveOptions = nullptr,
+                                  kpDocumentMetaInfo *metaInfo = nullptr,
+                                  bool *readOK = nullptr);
+    // Returns whether an image of <size> is too big to comfortably keep in
+    // memory, so that it should be opened out of core (see setOutOfCore()).
+    static bool needsOutOfCore(const QSize &size);
+    // Returns the size of the image in the local file <url>, without
+    // decoding it, or an invalid size if it is not known.
+    static QSize localFileImageSize(const QUrl &url);
+    // Same as decodeLocalFile() but decodes into an out of core
+    // kpTiledImage, a band of rows at a time, so the whole image is never in
+    // memory.  If the image format cannot be read a part at a time, nothing
+    // is decoded: a null image is returned and <tooBig> is set.
+    static kpTiledImage decodeLocalFileOutOfCore(const QUrl &url,
+                                                 kpDocumentSaveOptions *saveOptions = nullptr,
+                                                 kpDocumentMetaInfo *metaInfo = nullptr,
+                                                 bool *readOK = nullptr,
+                                                 bool *tooBig = nullptr);
     // REFACTOR: fix: open*() should only be called once.
     //                Create a new kpDocument() if you want to open again.
     void openNew(const QUrl &url);
     bool open(const QUrl &url, bool newDocSameNameIfNotExist = false);
+    // Same as a successful open() but with an image that has already been
+    // read from <url> e.g. by kpDocumentLoader.  The document is no longer
+    // tiled afterwards, unless it isOutOfCore().
+    void openImage(const QUrl &url, const kpImage &image, const kpDocumentSaveOptions &saveOptions, const kpDocumentMetaInfo &metaInfo);
+    // Same but makes the document tiled, with the tiles of <image>.
+    void openImage(const QUrl &url, const kpTiledImage &image, const kpDocumentSaveOptions &saveOptions, const kpDocumentMetaInfo &metaInfo);
 
     static void getDataFromImage(const QImage &image, kpDocumentSaveOptions &saveOptions, kpDocumentMetaInfo &metaInfo);
 
@@ -84,8 +126,24 @@ public:
                                  const kpDocumentMetaInfo &metaInfo,
                                  bool lossyPrompt,
                                  QWidget *parent);
-    bool save(bool lossyPrompt = false);
-    bool saveAs(const QUrl &url, const kpDocumentSaveOptions &saveOptions, bool lossyPrompt = true);
+    // Atomically writes <pixmap> to the local file <filename>.  Shows no
+    // dialogs, so it is safe to call from any thread.  On failure, false is
+    // returned and <errorString> is set to the reason, if one is known.
+    static bool writeLocalFile(const QImage &pixmap,
+                               const QString &filename,
+                               const kpDocumentSaveOptions &saveOptions,
+                               const kpDocumentMetaInfo &metaInfo,
+                               QString *errorString = nullptr);
+    // If <inBackground> and the URL is a local file, a snapshot of the
+    // image is encoded and written on a thread pool thread while the user
+    // keeps editing; true is then returned if the save was started and
+    // documentSaved() is emitted once it succeeds.  Otherwise, the image is
+    // saved before returning.  Either way, only one save runs at a time.
+    bool save(bool lossyPrompt = false, bool inBackground = false);
+    bool saveAs(const QUrl &url, const kpDocumentSaveOptions &saveOptions, bool lossyPrompt = true, bool inBackground = false);
+
+    // Blocks until any background save has finished and been reported.
+    void waitForSave();
 
     // Returns whether save() or saveAs() have ever been called and returned true
     bool savedAtLeastOnceBefore() const;
@@ -163,10 +221,67 @@ public:
     // image (i.e. before selection transparency is applied), which may be
     // null if the image selection is a just a border.
     //
+    // "image(false)" is null if the document isOutOfCore().
+    //
     // ASSUMPTION: For <ofSelection> == true only, an image selection exists.
     kpImage image(bool ofSelection = false) const;
+    // Returns the document's image itself, for drawing on directly (and
+    // then calling slotContentsChanged()).  A tiled document is turned
+    // into an untiled one first, so prefer beginDirectDraw().  If the
+    // image isOutOfCore() or too big to put together in memory, the
+    // document stays tiled and nullptr is returned.
     kpImage *imagePointer() const;
 
+    // Returns an image to draw <rect> of the document on directly and sets
+    // <origin> to the document position of its top-left pixel.  Once done,
+    // call endDirectDraw() and then slotContentsChanged().
+    //
+    // For an untiled document, this is imagePointer() with <origin> (0,0),
+    // so drawing outside <rect> also works.  For a tiled one, it is a copy
+    // of just <rect>, which endDirectDraw() stores back into the tiles.
+    kpImage *beginDirectDraw(const QRect &rect, QPoint *origin);
+    void endDirectDraw();
+
+    // Whether the image is stored as a kpTiledImage rather than as one
+    // kpImage.  The image API behaves the same either way, but
+    // getImageAt(), setImageAt(), fill(), resize() and downsampledImage()
+    // only touch the tiles they need, and tiledImage() is a cheap
+    // snapshot.  image() has to put the whole image together.
+    //
+    // Big new documents are tiled, so that only the tiles that are drawn
+    // on are ever allocated.
+    bool isTiled() const;
+    void setTiled(bool yes = true);
+
+    // Whether the tiles are kept in a scratch file rather than in memory
+    // (see kpTiledImage::setOutOfCore()), for images that do not fit in
+    // memory.  Documents whose size needsOutOfCore() start out this way.
+    // setOutOfCore() makes the document tiled first and returns false if
+    // the scratch file cannot be created.  setImage() keeps the new image
+    // out of core too.
+    //
+    // imagePointer(), image() and imageWithSelection() refuse to put an
+    // out of core image together in memory, so callers have to check.
+    bool isOutOfCore() const;
+    bool setOutOfCore(bool yes = true);
+
+    // Returns a copy of the tiles of the document's image.  Only valid if
+    // isTiled().
+    kpTiledImage tiledImage() const;
+
+    // Returns a copy of the document's image (ignoring any floating
+    // selection) shrunk by a factor of 2^<level> in each dimension, as
+    // described by kpImagePyramid.  It is cached and kept up to date with
+    // contentsChanged(), so this is cheap to call repeatedly.
+    //
+    // Use kpImagePyramid::levelForScale() to find the <level> to draw
+    // from, for a given scale.
+    kpImage downsampledImage(int level) const;
+    // Same as downsampledImage(<level>).copy(<levelRect>), but cheaper for
+    // a big tiled document, which might not have room for all of <level>
+    // (see kpImagePyramid::levelAt()).
+    kpImage downsampledImageAt(int level, const QRect &levelRect) const;
+
     void setImage(const kpImage &image);
     // ASSUMPTION: If setting the selection's image, the selection must be
     //             an image selection.
@@ -260,6 +375,8 @@ public:
     //
     //    b) with a transparent background: this makes no difference.
     //
+    // Null if the document isOutOfCore().
+    //
     kpImage imageWithSelection() const;
 
     /*
@@ -276,8 +393,18 @@ public Q_SLOTS:
     void slotContentsChanged(const QRect &rect);
     void slotSizeChanged(const QSize &newSize);
 
+private Q_SLOTS:
+    void slotBackgroundSaveFinished();
+
+private:
+    void saveFinished(const QUrl &url, const kpDocumentSaveOptions &saveOptions, quint64 modificationCount);
+
 Q_SIGNALS:
     void documentOpened();
+    // Emitted when the image to save is taken, followed by documentSaved()
+    // if it is saved successfully.  If the document is modified in between
+    // (during a background save), it stays modified after documentSaved().
+    void documentSaveStarted();
     void documentSaved();
 
     // Emitted whenever the isModified() flag changes from false to true.
@@ -0,0 +1,302 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_DOCUMENT_LOADER 0
+
+#include "document/kpDocumentLoader.h"
+
+#include "document/kpDocument.h"
+#include "imagelib/kpTiledImage.h"
+
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QtConcurrentRun>
+
+#include "kpLogCategories.h"
+#include <KIO/StoredTransferJob>
+#include <KJobWidgets>
+
+//---------------------------------------------------------------------
+
+namespace
+{
+struct DecodeResult {
+    QImage image;
+    // Set instead of <image> if the image is too big for memory.
+    kpTiledImage tiledImage;
+    kpDocumentSaveOptions saveOptions;
+    kpDocumentMetaInfo metaInfo;
+    // Only false if a local file could not be opened.
+    bool readOK = true;
+    // Set if a local file is too big for memory but cannot be read a part
+    // at a time (see kpDocument::decodeLocalFileOutOfCore()).
+    bool tooBig = false;
+};
+
+// Runs on a thread pool thread.  Only touches its arguments so that it
+// can outlive the kpDocumentLoader that started it.
+DecodeResult Decode(const QByteArray &data, const QUrl &url)
+{
+    DecodeResult result;
+    result.image = kpDocument::decodeImage(data, url, &result.saveOptions, &result.metaInfo);
+    return result;
+}
+
+// Same as Decode() for local files, which are read without KIO.  These
+// are the only ones that can be opened out of core, as a remote file is
+// transferred into memory first anyway.
+DecodeResult DecodeLocalFile(const QUrl &url)
+{
+    DecodeResult result;
+
+    if (kpDocument::needsOutOfCore(kpDocument::localFileImageSize(url))) {
+        result.tiledImage = kpDocument::decodeLocalFileOutOfCore(url, &result.saveOptions, &result.metaInfo, &result.readOK, &result.tooBig);
+        return result;
+    }
+
+    result.image = kpDocument::decodeLocalFile(url, &result.saveOptions, &result.metaInfo, &result.readOK);
+    return result;
+}
+}
+
+//---------------------------------------------------------------------
+
+struct kpDocumentLoaderPrivate {
+    QUrl url;
+    QWidget *dialogParent;
+
+    kpDocumentLoader::Status status;
+
+    QPointer<KIO::StoredTransferJob> job;
+    QFutureWatcher<DecodeResult> *decodeWatcher;
+
+    DecodeResult result;
+};
+
+//---------------------------------------------------------------------
+
+kpDocumentLoader::kpDocumentLoader(const QUrl &url, QWidget *dialogParent, QObject *parent)
+    : QObject(parent)
+    , d(new kpDocumentLoaderPrivate())
+{
+    d->url = url;
+    d->dialogParent = dialogParent;
+    d->status = Running;
+    d->decodeWatcher = nullptr;
+}
+
+//---------------------------------------------------------------------
+
+kpDocumentLoader::~kpDocumentLoader()
+{
+    if (d->job) {
+        d->job->kill(KJob::Quietly);
+    }
+
+    // Deleting the watcher does not wait for the decode to finish.
+    delete d->decodeWatcher;
+
+    delete d;
+}
+
+//---------------------------------------------------------------------
+
+// public
+QUrl kpDocumentLoader::url() const
+{
+    return d->url;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocumentLoader::start()
+{
+#if DEBUG_KP_DOCUMENT_LOADER
+    qCDebug(kpLogDocument) << "kpDocumentLoader::start(" << d->url << ")";
+#endif
+
+    Q_ASSERT(d->status == Running && !d->job && !d->decodeWatcher);
+
+    // A local file is mapped and decoded directly, without KIO.
+    if (d->url.isLocalFile()) {
+        startDecode(QByteArray());
+        return;
+    }
+
+    // Progress is shown by the caller, not by KIO.
+    d->job = KIO::storedGet(d->url, KIO::NoReload, KIO::HideProgressInfo);
+    KJobWidgets::setWindow(d->job, d->dialogParent);
+
+    connect(d->job, &KJob::percentChanged, this, &kpDocumentLoader::slotTransferPercentChanged);
+    connect(d->job, &KJob::result, this, &kpDocumentLoader::slotTransferResult);
+
+    Q_EMIT progress(0);
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocumentLoader::cancel()
+{
+#if DEBUG_KP_DOCUMENT_LOADER
+    qCDebug(kpLogDocument) << "kpDocumentLoader::cancel() status=" << d->status;
+#endif
+
+    if (d->status != Running) {
+        return;
+    }
+
+    if (d->job) {
+        d->job->kill(KJob::Quietly);
+    }
+
+    // The decode itself cannot be interrupted but we stop listening for it.
+    if (d->decodeWatcher) {
+        d->decodeWatcher->disconnect(this);
+    }
+
+    finish(Cancelled);
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpDocumentLoader::Status kpDocumentLoader::status() const
+{
+    return d->status;
+}
+
+//---------------------------------------------------------------------
+
+// public
+QImage kpDocumentLoader::image() const
+{
+    return d->result.image;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpTiledImage kpDocumentLoader::tiledImage() const
+{
+    return d->result.tiledImage;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpDocumentSaveOptions kpDocumentLoader::saveOptions() const
+{
+    return d->result.saveOptions;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpDocumentMetaInfo kpDocumentLoader::metaInfo() const
+{
+    return d->result.metaInfo;
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentLoader::slotTransferPercentChanged(KJob *job, unsigned long percent)
+{
+    Q_UNUSED(job);
+
+    if (d->status == Running) {
+        Q_EMIT progress(static_cast<int>(percent));
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentLoader::slotTransferResult(KJob *job)
+{
+#if DEBUG_KP_DOCUMENT_LOADER
+    qCDebug(kpLogDocument) << "kpDocumentLoader::slotTransferResult() error=" << job->error();
+#endif
+
+    if (d->status != Running) {
+        return;
+    }
+
+    if (job->error()) {
+        finish(TransferFailed);
+        return;
+    }
+
+    const QByteArray data = static_cast<KIO::StoredTransferJob *>(job)->data();
+
+    // (the job deletes itself)
+    d->job = nullptr;
+
+    startDecode(data);
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpDocumentLoader::startDecode(const QByteArray &data)
+{
+    Q_EMIT progress(-1);
+
+    d->decodeWatcher = new QFutureWatcher<DecodeResult>(this);
+    connect(d->decodeWatcher, &QFutureWatcher<DecodeResult>::finished, this, &kpDocumentLoader::slotDecodeFinished);
+
+    // (<data> is unused for local files, which are read on the thread pool)
+    if (d->url.isLocalFile()) {
+        d->decodeWatcher->setFuture(QtConcurrent::run(&DecodeLocalFile, d->url));
+    } else {
+        d->decodeWatcher->setFuture(QtConcurrent::run(&Decode, data, d->url));
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentLoader::slotDecodeFinished()
+{
+    if (d->status != Running) {
+        return;
+    }
+
+    d->result = d->decodeWatcher->result();
+
+#if DEBUG_KP_DOCUMENT_LOADER
+    qCDebug(kpLogDocument) << "kpDocumentLoader::slotDecodeFinished() image=" << d->result.image.size() << "tiledImage=" << d->result.tiledImage.size();
+#endif
+
+    if (!d->result.readOK) {
+        finish(TransferFailed);
+    } else if (d->result.tooBig) {
+        finish(TooBig);
+    } else {
+        finish((d->result.image.isNull() && d->result.tiledImage.isNull()) ? DecodeFailed : Succeeded);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpDocumentLoader::finish(Status status)
+{
+    d->status = status;
+
+    if (status != Succeeded) {
+        d->result = DecodeResult();
+    }
+
+    Q_EMIT finished();
+}
+
+//---------------------------------------------------------------------
+
+#include "moc_kpDocumentLoader.cpp"
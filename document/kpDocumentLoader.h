@@ -0,0 +1,96 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpDocumentLoader_H
+#define kpDocumentLoader_H
+
+#include <QImage>
+#include <QObject>
+#include <QUrl>
+
+#include "document/kpDocumentSaveOptions.h"
+#include "imagelib/kpDocumentMetaInfo.h"
+
+class QWidget;
+
+class KJob;
+
+class kpTiledImage;
+
+//
+// Loads an image from a URL without blocking the GUI thread.
+//
+// Local files are decoded straight from a memory mapping (see
+// kpDocument::decodeLocalFile()).  Other files are transferred by KIO
+// first.  The image is decoded and converted to
+// QImage::Format_ARGB32_Premultiplied by kpDocument::decodeImage() on a
+// thread pool thread.  Local files too big for memory (see
+// kpDocument::needsOutOfCore()) are decoded into an out of core
+// tiledImage() instead.  finished() is emitted exactly once, when the
+// image is ready, when loading fails or when cancel() is called.
+//
+// No dialogs are shown - the caller reports errors based on status().
+//
+
+class kpDocumentLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Status {
+        Running,
+        Succeeded,
+        Cancelled,
+        // The URL could not be read (e.g. it does not exist).
+        TransferFailed,
+        // The data could not be decoded as an image.
+        DecodeFailed,
+        // The image is too big for memory and its format cannot be read a
+        // part at a time, so it was not decoded at all.
+        TooBig
+    };
+
+    kpDocumentLoader(const QUrl &url, QWidget *dialogParent, QObject *parent = nullptr);
+    ~kpDocumentLoader() override;
+
+    QUrl url() const;
+
+    void start();
+
+    // If the image is still being decoded, the decode runs to completion
+    // but its result is discarded.
+    void cancel();
+
+    Status status() const;
+
+    // Only valid if status() == Succeeded.  Exactly one of image() and
+    // tiledImage() is not null.
+    QImage image() const;
+    kpTiledImage tiledImage() const;
+    kpDocumentSaveOptions saveOptions() const;
+    kpDocumentMetaInfo metaInfo() const;
+
+Q_SIGNALS:
+    // <percent> is in [0, 100] while transferring and -1 while decoding,
+    // where progress is not known.
+    void progress(int percent);
+
+    void finished();
+
+private Q_SLOTS:
+    void slotTransferPercentChanged(KJob *job, unsigned long percent);
+    void slotTransferResult(KJob *job);
+    void slotDecodeFinished();
+
+private:
+    void startDecode(const QByteArray &data);
+    void finish(Status status);
+
+    struct kpDocumentLoaderPrivate *d;
+};
+
+#endif // kpDocumentLoader_H
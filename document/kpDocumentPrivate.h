@@ -8,15 +8,64 @@
 #ifndef kpDocumentPrivate_H
 #define kpDocumentPrivate_H
 
+#include <QFutureWatcher>
+#include <QPoint>
+#include <QString>
+#include <QUrl>
+
+#include "document/kpDocumentSaveOptions.h"
+#include "imagelib/kpImagePyramid.h"
+#include "imagelib/kpTiledImage.h"
+
 class kpDocumentEnvironment;
 
+// The outcome of writing an image to a local file, possibly on another
+// thread (see kpDocument_Save.cpp).
+struct kpDocumentWriteResult {
+    enum Error {
+        NoError,
+        CouldNotCreateTemporaryFile,
+        CouldNotSave
+    };
+
+    Error error = NoError;
+    QString errorString;
+};
+
 struct kpDocumentPrivate {
     kpDocumentPrivate()
         : environ(nullptr)
+        , modificationCount(0)
+        , saveWatcher(nullptr)
+        , savingModificationCount(0)
     {
     }
 
     kpDocumentEnvironment *environ;
+
+    // The document's image if kpDocument::isTiled(), in which case
+    // kpDocument::m_image is null.
+    kpTiledImage tiledImage;
+
+    // The copy of the tiles handed out by beginDirectDraw() and where it
+    // goes back to.
+    kpImage directDrawImage;
+    QPoint directDrawOrigin;
+
+    // Smaller copies of the document's image for downsampledImage().
+    kpImagePyramid imagePyramid;
+
+    // Incremented by every setModified(true), even if the document was
+    // already modified.
+    quint64 modificationCount;
+
+    // The save running in the background, if any, and what to record
+    // when it succeeds.  <savingModificationCount> is the
+    // <modificationCount> at the time of the snapshot that is being saved.
+    QFutureWatcher<kpDocumentWriteResult> *saveWatcher;
+    QUrl savingURL;
+    kpDocumentSaveOptions savingSaveOptions;
+    quint64 savingModificationCount;
 };
 
 #endif // kpDocumentPrivate_H
@@ -14,6 +14,7 @@
 #include "imagelib/effects/kpEffectReduceColors.h"
 #include "imagelib/kpColor.h"
 #include "imagelib/kpDocumentMetaInfo.h"
+#include "imagelib/kpTiledImage.h"
 #include "kpDefs.h"
 #include "lgpl/generic/kpUrlFormatter.h"
 #include "pixmapfx/kpPixmapFX.h"
@@ -21,8 +22,11 @@
 #include "views/manager/kpViewManager.h"
 #include "widgets/toolbars/kpColorToolBar.h"
 
+#include <limits>
+
 #include <QBuffer>
 #include <QColor>
+#include <QFile>
 #include <QImage>
 #include <QImageReader>
 #include <QMimeDatabase>
@@ -75,10 +79,22 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url,
         return {};
     }
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url);
-    KJobWidgets::setWindow(job, parent);
+    QImage image;
+    bool readOK = false;
+
+    if (url.isLocalFile()) {
+        image = decodeLocalFile(url, saveOptions, metaInfo, &readOK);
+    } else {
+        KIO::StoredTransferJob *job = KIO::storedGet(url);
+        KJobWidgets::setWindow(job, parent);
+
+        readOK = job->exec();
+        if (readOK) {
+            image = decodeImage(job->data(), url, saveOptions, metaInfo);
+        }
+    }
 
-    if (!job->exec()) {
+    if (!readOK) {
         if (!suppressDoesntExistDialog) {
             // TODO: Use "Cannot" instead of "Could not" in all dialogs in KolourPaint.
             //       Or at least choose one consistently.
@@ -89,8 +105,23 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url,
 
         return {};
     }
-    QByteArray data = job->data();
 
+    if (image.isNull()) {
+        KMessageBox::error(parent,
+                           i18n("Could not open \"%1\" - unsupported image format.\n"
+                                "The file may be corrupt.",
+                                kpUrlFormatter::PrettyFilename(url)));
+        return {};
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QImage kpDocument::decodeImage(const QByteArray &data, const QUrl &url, kpDocumentSaveOptions *saveOptions, kpDocumentMetaInfo *metaInfo)
+{
     QMimeDatabase db;
     QMimeType mimeType = db.mimeTypeForFileNameAndData(url.fileName(), data);
 
@@ -103,7 +134,8 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url,
     qCDebug(kpLogDocument) << "\tsrc=" << url.path();
 #endif
 
-    QBuffer buffer(&data);
+    QBuffer buffer;
+    buffer.setData(data);
     buffer.open(QIODevice::ReadOnly);
     QImageReader reader(&buffer);
     reader.setAutoTransform(true);
@@ -117,10 +149,6 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url,
     reader.read(&image);
 
     if (image.isNull()) {
-        KMessageBox::error(parent,
-                           i18n("Could not open \"%1\" - unsupported image format.\n"
-                                "The file may be corrupt.",
-                                kpUrlFormatter::PrettyFilename(url)));
         return {};
     }
 
@@ -143,13 +171,186 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url,
 
 //---------------------------------------------------------------------
 
+// public static
+QImage kpDocument::decodeLocalFile(const QUrl &url, kpDocumentSaveOptions *saveOptions, kpDocumentMetaInfo *metaInfo, bool *readOK)
+{
+    Q_ASSERT(url.isLocalFile());
+
+    QFile file(url.toLocalFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+#if DEBUG_KP_DOCUMENT
+        qCDebug(kpLogDocument) << "kpDocument::decodeLocalFile(" << url << ") could not open:" << file.errorString();
+#endif
+        if (readOK) {
+            *readOK = false;
+        }
+        return {};
+    }
+
+    if (readOK) {
+        *readOK = true;
+    }
+
+    // Decode straight from a mapping of the file, rather than from a copy
+    // of it in memory.  map() fails for e.g. empty files and some special
+    // or network file systems, in which case we fall back to reading.
+    const qint64 size = file.size();
+    const uchar *mapped = (size > 0 && size <= std::numeric_limits<qsizetype>::max()) ? file.map(0, size) : nullptr;
+    if (mapped) {
+#if DEBUG_KP_DOCUMENT
+        qCDebug(kpLogDocument) << "kpDocument::decodeLocalFile(" << url << ") mapped" << size << "bytes";
+#endif
+        // (fromRawData() does not copy; <file> keeps the mapping alive
+        //  until we return)
+        return decodeImage(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<qsizetype>(size)), url, saveOptions, metaInfo);
+    }
+
+    return decodeImage(file.readAll(), url, saveOptions, metaInfo);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpDocument::needsOutOfCore(const QSize &size)
+{
+    // 1 GiB of pixels.  Most edits need a few copies of the image around
+    // (e.g. for undo), which would not fit in memory on most systems.
+    const qint64 MaxInCoreBytes = qint64(1) << 30;
+
+    return qint64(size.width()) * size.height() * 4 > MaxInCoreBytes;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QSize kpDocument::localFileImageSize(const QUrl &url)
+{
+    Q_ASSERT(url.isLocalFile());
+
+    // (only reads the header)
+    QImageReader reader(url.toLocalFile());
+    reader.setDecideFormatFromContent(true);
+    return reader.size();
+}
+
+//---------------------------------------------------------------------
+
+// public static
+kpTiledImage kpDocument::decodeLocalFileOutOfCore(const QUrl &url, kpDocumentSaveOptions *saveOptions, kpDocumentMetaInfo *metaInfo, bool *readOK, bool *tooBig)
+{
+    Q_ASSERT(url.isLocalFile());
+
+    if (tooBig) {
+        *tooBig = false;
+    }
+
+    QFile file(url.toLocalFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+#if DEBUG_KP_DOCUMENT
+        qCDebug(kpLogDocument) << "kpDocument::decodeLocalFileOutOfCore(" << url << ") could not open:" << file.errorString();
+#endif
+        if (readOK) {
+            *readOK = false;
+        }
+        return {};
+    }
+
+    if (readOK) {
+        *readOK = true;
+    }
+
+    QSize size;
+    QByteArray format;
+    bool canReadBands;
+    {
+        QImageReader reader(&file);
+        reader.setDecideFormatFromContent(true);
+
+        size = reader.size();
+        format = reader.format();
+        // (with a rotation, a band of the file is not a band of the image)
+        canReadBands = size.isValid() && reader.supportsOption(QImageIOHandler::ClipRect)
+            && reader.transformation() == QImageIOHandler::TransformationNone;
+    }
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::decodeLocalFileOutOfCore(" << url << ") size=" << size << "format=" << format
+                           << "canReadBands=" << canReadBands;
+#endif
+
+    if (!canReadBands) {
+        // It would have to be decoded all at once, which is exactly what
+        // opening it out of core is meant to avoid (e.g. Qt's PNG reader
+        // cannot read a part of an image).
+        if (tooBig) {
+            *tooBig = true;
+        }
+        return {};
+    }
+
+    if (saveOptions) {
+        file.seek(0);
+        QMimeDatabase db;
+        saveOptions->setMimeType(db.mimeTypeForFileNameAndData(url.fileName(), &file).name());
+    }
+
+    kpTiledImage tiledImage(size.width(), size.height(), 0);
+    tiledImage.setOutOfCore();
+
+    // Decode a band of rows at a time, which is written to the scratch
+    // file before the next one is decoded.
+    //
+    // An image handler can only be asked to read once, so every band needs
+    // a new reader and most handlers decode all of the rows above the clip
+    // rectangle again just to skip them.  Reading the image therefore costs
+    // about (number of bands) / 2 full decodes, so use as few bands as the
+    // memory allows rather than one per row of tiles.
+    const qint64 MaxBandBytes = qint64(256) << 20;
+    const qint64 bandTileRows = MaxBandBytes / (qint64(size.width()) * 4 * kpTiledImage::TileSize);
+    const int bandHeight = int(qBound(qint64(1), bandTileRows, qint64(size.height() / kpTiledImage::TileSize + 1))) * kpTiledImage::TileSize;
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "\tbandHeight=" << bandHeight;
+#endif
+
+    for (int y = 0; y < size.height(); y += bandHeight) {
+        file.seek(0);
+        QImageReader reader(&file, format);
+        reader.setClipRect(QRect(0, y, size.width(), qMin(bandHeight, size.height() - y)));
+
+        QImage band;
+        if (!reader.read(&band)) {
+            qCWarning(kpLogDocument) << "kpDocument::decodeLocalFileOutOfCore(" << url << ") could not read rows from" << y << ":"
+                                     << reader.errorString();
+            return {};
+        }
+
+        if (y == 0 && saveOptions && metaInfo) {
+            getDataFromImage(band, *saveOptions, *metaInfo);
+        }
+
+        // (converted one band at a time, like decodeImage(), and in place
+        //  where possible so that the band is not held twice)
+        band.convertTo(QImage::Format_ARGB32_Premultiplied);
+        tiledImage.setImageAt(band, QPoint(0, y));
+    }
+
+    return tiledImage;
+}
+
+//---------------------------------------------------------------------
+
 void kpDocument::openNew(const QUrl &url)
 {
 #if DEBUG_KP_DOCUMENT
     qCDebug(kpLogDocument) << "kpDocument::openNew (" << url << ")";
 #endif
 
-    m_image->fill(QColor(Qt::white).rgb());
+    if (isTiled()) {
+        d->tiledImage.fill(QColor(Qt::white).rgb());
+    } else {
+        m_image->fill(QColor(Qt::white).rgb());
+    }
 
     setURL(url, false /*not from url*/);
 
@@ -169,6 +370,8 @@ void kpDocument::openNew(const QUrl &url)
     *m_metaInfo = kpDocumentMetaInfo();
     m_modified = false;
 
+    d->imagePyramid.invalidate();
+
     Q_EMIT documentOpened();
 }
 
@@ -182,6 +385,35 @@ bool kpDocument::open(const QUrl &url, bool newDocSameNameIfNotExist)
 
     kpDocumentSaveOptions newSaveOptions;
     kpDocumentMetaInfo newMetaInfo;
+
+    if (url.isLocalFile() && needsOutOfCore(localFileImageSize(url))) {
+        bool readOK = false, tooBig = false;
+        const kpTiledImage newTiledImage = decodeLocalFileOutOfCore(url, &newSaveOptions, &newMetaInfo, &readOK, &tooBig);
+        if (!newTiledImage.isNull()) {
+            openImage(url, newTiledImage, newSaveOptions, newMetaInfo);
+            return true;
+        }
+
+        // Don't fall back to decoding the whole image into memory.
+        // (the error messages match getPixmapFromFile())
+        QWidget *parent = d->environ->dialogParent();
+        if (tooBig) {
+            KMessageBox::error(parent,
+                               i18n("Could not open \"%1\" - the image is too big.\n"
+                                    "Images this big can only be opened in formats that can be read a part at a time, such as JPEG.",
+                                    kpUrlFormatter::PrettyFilename(url)));
+        } else if (!readOK) {
+            KMessageBox::error(parent, i18n("Could not open \"%1\".", kpUrlFormatter::PrettyFilename(url)));
+        } else {
+            KMessageBox::error(parent,
+                               i18n("Could not open \"%1\" - unsupported image format.\n"
+                                    "The file may be corrupt.",
+                                    kpUrlFormatter::PrettyFilename(url)));
+        }
+
+        return false;
+    }
+
     QImage newPixmap = kpDocument::getPixmapFromFile(url,
                                                      newDocSameNameIfNotExist /*suppress "doesn't exist" dialog*/,
                                                      d->environ->dialogParent(),
@@ -189,15 +421,7 @@ bool kpDocument::open(const QUrl &url, bool newDocSameNameIfNotExist)
                                                      &newMetaInfo);
 
     if (!newPixmap.isNull()) {
-        delete m_image;
-        m_image = new kpImage(newPixmap);
-
-        setURL(url, true /*is from url*/);
-        *m_saveOptions = newSaveOptions;
-        *m_metaInfo = newMetaInfo;
-        m_modified = false;
-
-        Q_EMIT documentOpened();
+        openImage(url, newPixmap, newSaveOptions, newMetaInfo);
         return true;
     }
 
@@ -216,3 +440,64 @@ bool kpDocument::open(const QUrl &url, bool newDocSameNameIfNotExist)
 }
 
 //---------------------------------------------------------------------
+
+void kpDocument::openImage(const QUrl &url, const kpImage &image, const kpDocumentSaveOptions &saveOptions, const kpDocumentMetaInfo &metaInfo)
+{
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::openImage (" << url << ")";
+#endif
+
+    Q_ASSERT(!image.isNull());
+
+    // A document only starts out tiled so that it is cheap to create, so
+    // go back to one kpImage, unless it is meant to be out of core.
+    if (isOutOfCore()) {
+        openImage(url, kpTiledImage(image), saveOptions, metaInfo);
+        return;
+    }
+
+    delete m_image;
+    m_image = new kpImage(image);
+    d->tiledImage = kpTiledImage();
+
+    setURL(url, true /*is from url*/);
+    *m_saveOptions = saveOptions;
+    *m_metaInfo = metaInfo;
+    m_modified = false;
+
+    d->imagePyramid.invalidate();
+
+    Q_EMIT documentOpened();
+}
+
+//---------------------------------------------------------------------
+
+void kpDocument::openImage(const QUrl &url, const kpTiledImage &image, const kpDocumentSaveOptions &saveOptions, const kpDocumentMetaInfo &metaInfo)
+{
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::openImage (" << url << ") tiled outOfCore=" << image.isOutOfCore();
+#endif
+
+    Q_ASSERT(!image.isNull());
+
+    // Keep an out of core document out of core.
+    const bool outOfCore = isOutOfCore();
+
+    d->tiledImage = image;
+    *m_image = kpImage();
+
+    if (outOfCore) {
+        d->tiledImage.setOutOfCore();
+    }
+
+    setURL(url, true /*is from url*/);
+    *m_saveOptions = saveOptions;
+    *m_metaInfo = metaInfo;
+    m_modified = false;
+
+    d->imagePyramid.invalidate();
+
+    Q_EMIT documentOpened();
+}
+
+//---------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #include <QMimeDatabase>
 #include <QSaveFile>
 #include <QTemporaryFile>
+#include <QtConcurrentRun>
 
 #include "kpLogCategories.h"
 #include <KIO/FileCopyJob>
@@ -26,6 +27,7 @@
 #include "imagelib/effects/kpEffectReduceColors.h"
 #include "imagelib/kpColor.h"
 #include "imagelib/kpDocumentMetaInfo.h"
+#include "imagelib/kpPngWriter.h"
 #include "kpDefs.h"
 #include "lgpl/generic/kpUrlFormatter.h"
 #include "pixmapfx/kpPixmapFX.h"
@@ -34,7 +36,7 @@
 #include "widgets/toolbars/kpColorToolBar.h"
 #include "widgets/toolbars/kpToolToolBar.h"
 
-bool kpDocument::save(bool lossyPrompt)
+bool kpDocument::save(bool lossyPrompt, bool inBackground)
 {
 #if DEBUG_KP_DOCUMENT
     qCDebug(kpLogDocument) << "kpDocument::save("
@@ -53,7 +55,7 @@ bool kpDocument::save(bool lossyPrompt)
         return false;
     }
 
-    return saveAs(m_url, *m_saveOptions, lossyPrompt);
+    return saveAs(m_url, *m_saveOptions, lossyPrompt, inBackground);
 }
 
 //---------------------------------------------------------------------
@@ -192,7 +194,11 @@ bool kpDocument::savePixmapToDevice(const QImage &image,
 #if DEBUG_KP_DOCUMENT
     qCDebug(kpLogDocument) << "\tsaving";
 #endif
-    if (!imageToSave.save(device, type.toLatin1().constData(), quality)) {
+    // Large PNGs are compressed on several threads.
+    const bool savedOK = (type == QLatin1String("png") && kpPngWriter::isUsefulFor(imageToSave))
+        ? kpPngWriter::write(imageToSave, device, quality)
+        : imageToSave.save(device, type.toLatin1().constData(), quality);
+    if (!savedOK) {
 #if DEBUG_KP_DOCUMENT
         qCDebug(kpLogDocument) << "\tQImage::save() returned false";
 #endif
@@ -221,6 +227,101 @@ static void CouldNotSaveDialog(const QUrl &url, const QString &error, QWidget *p
 
 //---------------------------------------------------------------------
 
+// Writes <image> to the local file <filename> atomically.  Shows no
+// dialogs so that it can be run on any thread.
+static kpDocumentWriteResult WriteLocalFile(const QImage &image,
+                                            const QString &filename,
+                                            const kpDocumentSaveOptions &saveOptions,
+                                            const kpDocumentMetaInfo &metaInfo)
+{
+    kpDocumentWriteResult result;
+
+    // sync: All failure exit paths _must_ call QSaveFile::cancelWriting() or
+    //       else, the QSaveFile destructor will overwrite the file,
+    //       <filename>, despite the failure.
+    QSaveFile atomicFileWriter(filename);
+    {
+        if (!atomicFileWriter.open(QIODevice::WriteOnly)) {
+            // We probably don't need this as <filename> has not been
+            // opened.
+            atomicFileWriter.cancelWriting();
+
+#if DEBUG_KP_DOCUMENT
+            qCDebug(kpLogDocument) << "\treturning false because could not open QSaveFile"
+                                   << " error=" << atomicFileWriter.error();
+#endif
+            result.error = kpDocumentWriteResult::CouldNotCreateTemporaryFile;
+            return result;
+        }
+
+        // Write to local temporary file.
+        if (!kpDocument::savePixmapToDevice(image, &atomicFileWriter, saveOptions, metaInfo, false /*no lossy prompt*/, nullptr /*no dialogs*/)) {
+            atomicFileWriter.cancelWriting();
+
+#if DEBUG_KP_DOCUMENT
+            qCDebug(kpLogDocument) << "\treturning false because could not save pixmap to device";
+#endif
+            // (ReportWriteResult() supplies the message)
+            result.error = kpDocumentWriteResult::CouldNotSave;
+            return result;
+        }
+
+        // Atomically overwrite local file with the temporary file
+        // we saved to.
+        if (!atomicFileWriter.commit()) {
+            atomicFileWriter.cancelWriting();
+
+#if DEBUG_KP_DOCUMENT
+            qCDebug(kpLogDocument) << "\tcould not close QSaveFile";
+#endif
+            result.error = kpDocumentWriteResult::CouldNotSave;
+            result.errorString = atomicFileWriter.errorString();
+            return result;
+        }
+    } // sync QSaveFile.cancelWriting()
+
+    return result;
+}
+
+//---------------------------------------------------------------------
+
+// Returns whether <result> is a success, after reporting it if it is not.
+static bool ReportWriteResult(const kpDocumentWriteResult &result, const QUrl &url, QWidget *parent)
+{
+    switch (result.error) {
+    case kpDocumentWriteResult::NoError:
+        return true;
+    case kpDocumentWriteResult::CouldNotCreateTemporaryFile:
+        ::CouldNotCreateTemporaryFileDialog(parent);
+        return false;
+    case kpDocumentWriteResult::CouldNotSave:
+        ::CouldNotSaveDialog(url, result.errorString.isEmpty() ? i18n("Error saving image") : result.errorString, parent);
+        return false;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpDocument::writeLocalFile(const QImage &pixmap,
+                                const QString &filename,
+                                const kpDocumentSaveOptions &saveOptions,
+                                const kpDocumentMetaInfo &metaInfo,
+                                QString *errorString)
+{
+    const kpDocumentWriteResult result = ::WriteLocalFile(pixmap, filename, saveOptions, metaInfo);
+
+    if (errorString) {
+        *errorString = result.errorString;
+    }
+
+    return (result.error == kpDocumentWriteResult::NoError);
+}
+
+//---------------------------------------------------------------------
+
 // public static
 bool kpDocument::savePixmapToFile(const QImage &pixmap,
                                   const QUrl &url,
@@ -247,49 +348,9 @@ bool kpDocument::savePixmapToFile(const QImage &pixmap,
 
     // Local file?
     if (url.isLocalFile()) {
-        const QString filename = url.toLocalFile();
-
-        // sync: All failure exit paths _must_ call QSaveFile::cancelWriting() or
-        //       else, the QSaveFile destructor will overwrite the file,
-        //       <filename>, despite the failure.
-        QSaveFile atomicFileWriter(filename);
-        {
-            if (!atomicFileWriter.open(QIODevice::WriteOnly)) {
-                // We probably don't need this as <filename> has not been
-                // opened.
-                atomicFileWriter.cancelWriting();
-
-#if DEBUG_KP_DOCUMENT
-                qCDebug(kpLogDocument) << "\treturning false because could not open QSaveFile"
-                                       << " error=" << atomicFileWriter.error() << endl;
-#endif
-                ::CouldNotCreateTemporaryFileDialog(parent);
-                return false;
-            }
-
-            // Write to local temporary file.
-            if (!savePixmapToDevice(pixmap, &atomicFileWriter, saveOptions, metaInfo, false /*no lossy prompt*/, parent)) {
-                atomicFileWriter.cancelWriting();
-
-#if DEBUG_KP_DOCUMENT
-                qCDebug(kpLogDocument) << "\treturning false because could not save pixmap to device" << endl;
-#endif
-                ::CouldNotSaveDialog(url, i18n("Error saving image"), parent);
-                return false;
-            }
-
-            // Atomically overwrite local file with the temporary file
-            // we saved to.
-            if (!atomicFileWriter.commit()) {
-                atomicFileWriter.cancelWriting();
-
-#if DEBUG_KP_DOCUMENT
-                qCDebug(kpLogDocument) << "\tcould not close QSaveFile";
-#endif
-                ::CouldNotSaveDialog(url, atomicFileWriter.errorString(), parent);
-                return false;
-            }
-        } // sync QSaveFile.cancelWriting()
+        if (!::ReportWriteResult(::WriteLocalFile(pixmap, url.toLocalFile(), saveOptions, metaInfo), url, parent)) {
+            return false;
+        }
     }
     // Remote file?
     else {
@@ -348,24 +409,117 @@ bool kpDocument::savePixmapToFile(const QImage &pixmap,
 
 //---------------------------------------------------------------------
 
-bool kpDocument::saveAs(const QUrl &url, const kpDocumentSaveOptions &saveOptions, bool lossyPrompt)
+bool kpDocument::saveAs(const QUrl &url, const kpDocumentSaveOptions &saveOptions, bool lossyPrompt, bool inBackground)
 {
 #if DEBUG_KP_DOCUMENT
-    qCDebug(kpLogDocument) << "kpDocument::saveAs (" << url << "," << saveOptions.mimeType() << ")" << endl;
+    qCDebug(kpLogDocument) << "kpDocument::saveAs (" << url << "," << saveOptions.mimeType() << ",inBackground=" << inBackground << ")";
 #endif
 
-    if (kpDocument::savePixmapToFile(imageWithSelection(), url, saveOptions, *metaInfo(), lossyPrompt, d->environ->dialogParent())) {
-        setURL(url, true /*is from url*/);
-        *m_saveOptions = saveOptions;
-        m_modified = false;
+    // Saves must finish in the order they were started.
+    waitForSave();
+
+    // (cheap - the image is implicitly shared until the document is next
+    //  changed)
+    const kpImage image = imageWithSelection();
+    if (image.isNull()) {
+        // isOutOfCore()
+        KMessageBox::error(d->environ->dialogParent(), i18n("Could not save image - it is too big to put together in memory."));
+        return false;
+    }
+
+    const kpDocumentMetaInfo metaInfo = *this->metaInfo();
+    const quint64 modificationCount = d->modificationCount;
+
+    // Remote files are uploaded synchronously by KIO.
+    if (!inBackground || !url.isLocalFile()) {
+        Q_EMIT documentSaveStarted();
 
-        m_savedAtLeastOnceBefore = true;
+        if (!kpDocument::savePixmapToFile(image, url, saveOptions, metaInfo, lossyPrompt, d->environ->dialogParent())) {
+            return false;
+        }
 
-        Q_EMIT documentSaved();
+        saveFinished(url, saveOptions, modificationCount);
         return true;
     }
 
-    return false;
+    if (lossyPrompt && !lossyPromptContinue(image, saveOptions, d->environ->dialogParent())) {
+#if DEBUG_KP_DOCUMENT
+        qCDebug(kpLogDocument) << "\treturning false because of lossyPrompt";
+#endif
+        return false;
+    }
+
+    Q_EMIT documentSaveStarted();
+
+    d->savingURL = url;
+    d->savingSaveOptions = saveOptions;
+    d->savingModificationCount = modificationCount;
+
+    d->saveWatcher = new QFutureWatcher<kpDocumentWriteResult>(this);
+    connect(d->saveWatcher, &QFutureWatcher<kpDocumentWriteResult>::finished, this, &kpDocument::slotBackgroundSaveFinished);
+    d->saveWatcher->setFuture(QtConcurrent::run(&::WriteLocalFile, image, url.toLocalFile(), saveOptions, metaInfo));
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocument::waitForSave()
+{
+    if (!d->saveWatcher) {
+        return;
+    }
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::waitForSave()";
+#endif
+
+    d->saveWatcher->waitForFinished();
+    slotBackgroundSaveFinished();
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocument::slotBackgroundSaveFinished()
+{
+    QFutureWatcher<kpDocumentWriteResult> *watcher = d->saveWatcher;
+    if (!watcher) {
+        return;
+    }
+
+    d->saveWatcher = nullptr;
+    watcher->disconnect(this);
+    watcher->deleteLater();
+
+    const kpDocumentWriteResult result = watcher->result();
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::slotBackgroundSaveFinished() error=" << result.error;
+#endif
+
+    if (::ReportWriteResult(result, d->savingURL, d->environ->dialogParent())) {
+        saveFinished(d->savingURL, d->savingSaveOptions, d->savingModificationCount);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpDocument::saveFinished(const QUrl &url, const kpDocumentSaveOptions &saveOptions, quint64 modificationCount)
+{
+    setURL(url, true /*is from url*/);
+    *m_saveOptions = saveOptions;
+
+    // Changes made while saving in the background are not in the file.
+    if (d->modificationCount == modificationCount) {
+        m_modified = false;
+    }
+
+    m_savedAtLeastOnceBefore = true;
+
+    Q_EMIT documentSaved();
 }
 
 //---------------------------------------------------------------------
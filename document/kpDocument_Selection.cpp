@@ -12,6 +12,7 @@
 
 #include <QImage>
 #include <QPainter>
+#include <QPoint>
 #include <QRect>
 
 #include "kpLogCategories.h"
@@ -193,11 +194,17 @@ void kpDocument::imageSelectionPullFromDocument(const kpColor &backgroundColor)
     kpImage eraseImage(boundingRect.size(), QImage::Format_ARGB32_Premultiplied);
     eraseImage.fill(backgroundColor.toQRgb());
 
-    // only paint the region of the shape of the selection
-    QPainter painter(m_image);
-    painter.setClipRegion(imageSel->shapeRegion());
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    painter.drawImage(boundingRect.topLeft(), eraseImage);
+    QPoint origin;
+    kpImage *image = beginDirectDraw(boundingRect, &origin);
+    {
+        // only paint the region of the shape of the selection
+        QPainter painter(image);
+        painter.translate(-origin);
+        painter.setClipRegion(imageSel->shapeRegion());
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(boundingRect.topLeft(), eraseImage);
+    }
+    endDirectDraw();
     slotContentsChanged(boundingRect);
 
     d->environ->restoreQueueViewUpdates();
@@ -245,17 +252,23 @@ void kpDocument::selectionCopyOntoDocument(bool applySelTransparency)
     const QRect boundingRect = m_selection->boundingRect();
     Q_ASSERT(boundingRect.isValid());
 
+    QPoint origin;
+    kpImage *image = beginDirectDraw(boundingRect, &origin);
+    const QRect imageRect(origin, image->size());
+
     if (imageSelection()) {
         if (applySelTransparency) {
-            imageSelection()->paint(m_image, rect());
+            imageSelection()->paint(image, imageRect);
         } else {
-            imageSelection()->paintWithBaseImage(m_image, rect());
+            imageSelection()->paintWithBaseImage(image, imageRect);
         }
     } else {
         // (for antialiasing with background)
-        m_selection->paint(m_image, rect());
+        m_selection->paint(image, imageRect);
     }
 
+    endDirectDraw();
+
     slotContentsChanged(boundingRect);
 }
 
@@ -285,7 +298,10 @@ kpImage kpDocument::imageWithSelection() const
 #if DEBUG_KP_DOCUMENT && 1
         qCDebug(kpLogDocument) << "\tselection @ " << m_selection->boundingRect();
 #endif
-        kpImage output = *m_image;
+        kpImage output = image();
+        if (output.isNull()) {
+            return output;
+        }
 
         // (this is a NOP for image selections without content)
         m_selection->paint(&output, rect());
@@ -295,7 +311,7 @@ kpImage kpDocument::imageWithSelection() const
 #if DEBUG_KP_DOCUMENT && 1
         qCDebug(kpLogDocument) << "\tno selection";
 #endif
-        return *m_image;
+        return image();
     }
 }
 
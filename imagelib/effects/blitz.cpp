@@ -44,6 +44,7 @@ ImageMagick Studio.
 */
 
 #include "blitz.h"
+#include "kpEffectKernels.h"
 
 #include <QColor>
 #include <cmath>
@@ -581,66 +582,28 @@ QImage Blitz::emboss(QImage &img, float radius, float sigma)
 
 //--------------------------------------------------------------------------------
 
-QImage &Blitz::flatten(QImage &img, const QColor &ca, const QColor &cb)
+void Blitz::flatten(QRgb *data, int count, bool premultiplied, const QColor &ca, const QColor &cb)
 {
-    if (img.isNull()) {
-        return (img);
-    }
-
-    if (img.depth() == 1) {
-        img.setColor(0, ca.rgb());
-        img.setColor(1, cb.rgb());
-        return (img);
-    }
-
     int r1 = ca.red();
     int r2 = cb.red();
     int g1 = ca.green();
     int g2 = cb.green();
     int b1 = ca.blue();
     int b2 = cb.blue();
-    int min = 0, max = 255;
-
-    QRgb *data, *end;
-    QVector<QRgb> cTable;
-    if (img.format() == QImage::Format_Indexed8) {
-        cTable = img.colorTable();
-        data = static_cast<unsigned int *>(cTable.data());
-        end = data + img.colorCount();
 
-    } else {
-        data = reinterpret_cast<QRgb *>(img.scanLine(0));
-        end = data + (img.width() * img.height());
-    }
+    // The graylevel range used to be measured from the image but, as the
+    // measurement started from [0, 255], it always ended up as [0, 255].
+    const int min = 0, max = 255;
 
-    // get minimum and maximum graylevel
-    QRgb *ptr = data;
+    QRgb *end = data + count;
     int mean;
 
-    if (img.format() != QImage::Format_ARGB32_Premultiplied) {
-        while (ptr != end) {
-            mean = (qRed(*ptr) + qGreen(*ptr) + qBlue(*ptr)) / 3;
-            min = qMin(min, mean);
-            max = qMax(max, mean);
-            ++ptr;
-        }
-    } else {
-        QRgb pixel;
-        while (ptr != end) {
-            pixel = convertFromPremult(*ptr);
-            mean = (qRed(pixel) + qGreen(pixel) + qBlue(pixel)) / 3;
-            min = qMin(min, mean);
-            max = qMax(max, mean);
-            ++ptr;
-        }
-    }
-
     // conversion factors
     float sr = (static_cast<float>(r2 - r1) / (max - min));
     float sg = (static_cast<float>(g2 - g1) / (max - min));
     float sb = (static_cast<float>(b2 - b1) / (max - min));
 
-    if (img.format() != QImage::Format_ARGB32_Premultiplied) {
+    if (!premultiplied) {
         while (data != end) {
             mean = (qRed(*data) + qGreen(*data) + qBlue(*data)) / 3;
             *data = qRgba(static_cast<unsigned char>(sr * (mean - min) + r1 + 0.5f),
@@ -661,10 +624,34 @@ QImage &Blitz::flatten(QImage &img, const QColor &ca, const QColor &cb)
             ++data;
         }
     }
+}
+
+//--------------------------------------------------------------------------------
+
+QImage &Blitz::flatten(QImage &img, const QColor &ca, const QColor &cb)
+{
+    if (img.isNull()) {
+        return (img);
+    }
+
+    if (img.depth() == 1) {
+        img.setColor(0, ca.rgb());
+        img.setColor(1, cb.rgb());
+        return (img);
+    }
 
     if (img.format() == QImage::Format_Indexed8) {
+        QVector<QRgb> cTable = img.colorTable();
+        kpEffectKernels::flatten(cTable.data(), img.colorCount(), false, ca, cb);
         img.setColorTable(cTable);
+    } else {
+        kpEffectKernels::flatten(reinterpret_cast<QRgb *>(img.scanLine(0)),
+                                 img.width() * img.height(),
+                                 img.format() == QImage::Format_ARGB32_Premultiplied,
+                                 ca,
+                                 cb);
     }
+
     return (img);
 }
 
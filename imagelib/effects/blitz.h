@@ -17,6 +17,8 @@ QImage blur(QImage &img, int radius);
 QImage gaussianSharpen(QImage &img, float radius, float sigma);
 QImage emboss(QImage &img, float radius, float sigma);
 QImage &flatten(QImage &img, const QColor &ca, const QColor &cb);
+// (portable implementation of kpEffectKernels::flatten())
+void flatten(QRgb *data, int count, bool premultiplied, const QColor &ca, const QColor &cb);
 };
 
 #endif
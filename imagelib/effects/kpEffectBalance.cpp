@@ -70,28 +70,7 @@ kpImage kpEffectBalance::applyEffect(const kpImage &image, int channels, int bri
 #endif
 
     quint8 transformRed[256], transformGreen[256], transformBlue[256];
-
-    for (int i = 0; i < 256; i++) {
-        auto applied = static_cast<quint8>(brightnessContrastGamma(i, brightness, contrast, gamma));
-
-        if (channels & kpEffectBalance::Red) {
-            transformRed[i] = applied;
-        } else {
-            transformRed[i] = static_cast<quint8>(i);
-        }
-
-        if (channels & kpEffectBalance::Green) {
-            transformGreen[i] = applied;
-        } else {
-            transformGreen[i] = static_cast<quint8>(i);
-        }
-
-        if (channels & kpEffectBalance::Blue) {
-            transformBlue[i] = applied;
-        } else {
-            transformBlue[i] = static_cast<quint8>(i);
-        }
-    }
+    buildLookupTables(channels, brightness, contrast, gamma, transformRed, transformGreen, transformBlue);
 
 #if DEBUG_KP_EFFECT_BALANCE
     qCDebug(kpLogImagelib) << "\tbuild lookup=" << timer.restart();
@@ -125,3 +104,44 @@ kpImage kpEffectBalance::applyEffect(const kpImage &image, int channels, int bri
 
     return qimage;
 }
+
+// public static
+void kpEffectBalance::buildLookupTables(int channels,
+                                        int brightness,
+                                        int contrast,
+                                        int gamma,
+                                        quint8 transformRed[256],
+                                        quint8 transformGreen[256],
+                                        quint8 transformBlue[256])
+{
+    for (int i = 0; i < 256; i++) {
+        auto applied = static_cast<quint8>(brightnessContrastGamma(i, brightness, contrast, gamma));
+
+        if (channels & kpEffectBalance::Red) {
+            transformRed[i] = applied;
+        } else {
+            transformRed[i] = static_cast<quint8>(i);
+        }
+
+        if (channels & kpEffectBalance::Green) {
+            transformGreen[i] = applied;
+        } else {
+            transformGreen[i] = static_cast<quint8>(i);
+        }
+
+        if (channels & kpEffectBalance::Blue) {
+            transformBlue[i] = applied;
+        } else {
+            transformBlue[i] = static_cast<quint8>(i);
+        }
+    }
+}
+
+// public static
+void kpEffectBalance::applyEffect(QRgb *pixels, int count, const quint8 transformRed[256], const quint8 transformGreen[256], const quint8 transformBlue[256])
+{
+    for (int i = 0; i < count; i++) {
+        const QRgb rgb = pixels[i];
+        pixels[i] = qRgba(transformRed[qRed(rgb)], transformGreen[qGreen(rgb)], transformBlue[qBlue(rgb)], qAlpha(rgb));
+    }
+}
@@ -23,6 +23,18 @@ public:
 
     // (<brightness>, <contrast> & <gamma> are from -50 to 50)
     static kpImage applyEffect(const kpImage &image, int channels, int brightness, int contrast, int gamma);
+
+    // Fills in the per-channel lookup tables that applyEffect() uses.
+    static void buildLookupTables(int channels,
+                                  int brightness,
+                                  int contrast,
+                                  int gamma,
+                                  quint8 transformRed[256],
+                                  quint8 transformGreen[256],
+                                  quint8 transformBlue[256]);
+
+    // Applies the lookup tables to <count> 32-bit <pixels>.
+    static void applyEffect(QRgb *pixels, int count, const quint8 transformRed[256], const quint8 transformGreen[256], const quint8 transformBlue[256]);
 };
 
 #endif // kpEffectBalance_H
@@ -0,0 +1,234 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_EFFECT_CHAIN 0
+
+#include "kpEffectChain.h"
+
+#include "imagelib/effects/kpEffectBalance.h"
+#include "imagelib/effects/kpEffectFlatten.h"
+#include "imagelib/effects/kpEffectGrayscale.h"
+#include "imagelib/effects/kpEffectHSV.h"
+#include "imagelib/effects/kpEffectInvert.h"
+#include "kpLogCategories.h"
+
+#if DEBUG_KP_EFFECT_CHAIN
+#include <QElapsedTimer>
+#endif
+
+//---------------------------------------------------------------------
+
+struct kpEffectChain::Step {
+    enum Type {
+        Balance,
+        Flatten,
+        Grayscale,
+        HSV,
+        Invert
+    };
+
+    Type type;
+
+    // Balance
+    int brightness{0}, contrast{0}, gamma{0};
+    quint8 transformRed[256], transformGreen[256], transformBlue[256];
+
+    // Balance & Invert
+    int channels{0};
+
+    // Flatten
+    QColor color1, color2;
+
+    // HSV
+    double hue{0}, saturation{0}, value{0};
+};
+
+//---------------------------------------------------------------------
+
+kpEffectChain::kpEffectChain() = default;
+
+kpEffectChain::kpEffectChain(const kpEffectChain &rhs) = default;
+
+kpEffectChain &kpEffectChain::operator=(const kpEffectChain &rhs) = default;
+
+kpEffectChain::~kpEffectChain() = default;
+
+//---------------------------------------------------------------------
+
+// public
+void kpEffectChain::addBalance(int channels, int brightness, int contrast, int gamma)
+{
+    Step step;
+    step.type = Step::Balance;
+    step.channels = channels;
+    step.brightness = brightness;
+    step.contrast = contrast;
+    step.gamma = gamma;
+
+    kpEffectBalance::buildLookupTables(channels, brightness, contrast, gamma, step.transformRed, step.transformGreen, step.transformBlue);
+
+    m_steps.append(step);
+}
+
+// public
+void kpEffectChain::addFlatten(const QColor &color1, const QColor &color2)
+{
+    Step step;
+    step.type = Step::Flatten;
+    step.color1 = color1;
+    step.color2 = color2;
+
+    m_steps.append(step);
+}
+
+// public
+void kpEffectChain::addGrayscale()
+{
+    Step step;
+    step.type = Step::Grayscale;
+
+    m_steps.append(step);
+}
+
+// public
+void kpEffectChain::addHSV(double hue, double saturation, double value)
+{
+    Step step;
+    step.type = Step::HSV;
+    step.hue = hue;
+    step.saturation = saturation;
+    step.value = value;
+
+    m_steps.append(step);
+}
+
+// public
+void kpEffectChain::addInvert(int channels)
+{
+    Step step;
+    step.type = Step::Invert;
+    step.channels = channels;
+
+    m_steps.append(step);
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpEffectChain::isEmpty() const
+{
+    return m_steps.isEmpty();
+}
+
+// public
+int kpEffectChain::count() const
+{
+    return m_steps.count();
+}
+
+// public
+bool kpEffectChain::isInvertible() const
+{
+    for (const Step &step : m_steps) {
+        if (step.type != Step::Invert) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpEffectChain::applyEffectSlow(kpImage *image) const
+{
+    for (const Step &step : m_steps) {
+        switch (step.type) {
+        case Step::Balance:
+            *image = kpEffectBalance::applyEffect(*image, step.channels, step.brightness, step.contrast, step.gamma);
+            break;
+
+        case Step::Flatten:
+            kpEffectFlatten::applyEffect(image, step.color1, step.color2);
+            break;
+
+        case Step::Grayscale:
+            *image = kpEffectGrayscale::applyEffect(*image);
+            break;
+
+        case Step::HSV:
+            *image = kpEffectHSV::applyEffect(*image, step.hue, step.saturation, step.value);
+            break;
+
+        case Step::Invert:
+            kpEffectInvert::applyEffect(image, step.channels);
+            break;
+        }
+    }
+}
+
+// public
+kpImage kpEffectChain::applyEffect(const kpImage &image) const
+{
+#if DEBUG_KP_EFFECT_CHAIN
+    qCDebug(kpLogImagelib) << "kpEffectChain::applyEffect() steps=" << m_steps.count() << " image.format=" << image.format();
+    QElapsedTimer timer;
+    timer.start();
+#endif
+
+    kpImage qimage = image;
+
+    if (m_steps.isEmpty() || qimage.isNull()) {
+        return qimage;
+    }
+
+    // Images with a color table (and other unusual formats) are either tiny
+    // or rare so don't bother to fuse the effects for them.
+    if (qimage.format() != QImage::Format_RGB32 && qimage.format() != QImage::Format_ARGB32
+        && qimage.format() != QImage::Format_ARGB32_Premultiplied) {
+        applyEffectSlow(&qimage);
+        return qimage;
+    }
+
+    const bool premultiplied = (qimage.format() == QImage::Format_ARGB32_Premultiplied);
+    const int width = qimage.width();
+
+    for (int y = 0; y < qimage.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(qimage.scanLine(y));
+
+        for (const Step &step : m_steps) {
+            switch (step.type) {
+            case Step::Balance:
+                kpEffectBalance::applyEffect(line, width, step.transformRed, step.transformGreen, step.transformBlue);
+                break;
+
+            case Step::Flatten:
+                kpEffectFlatten::applyEffect(line, width, premultiplied, step.color1, step.color2);
+                break;
+
+            case Step::Grayscale:
+                kpEffectGrayscale::applyEffect(line, width);
+                break;
+
+            case Step::HSV:
+                kpEffectHSV::applyEffect(line, width, step.hue, step.saturation, step.value);
+                break;
+
+            case Step::Invert:
+                kpEffectInvert::applyEffect(line, width, step.channels, premultiplied);
+                break;
+            }
+        }
+    }
+
+#if DEBUG_KP_EFFECT_CHAIN
+    qCDebug(kpLogImagelib) << "\tfused pass took=" << timer.elapsed() << "ms";
+#endif
+
+    return qimage;
+}
@@ -0,0 +1,61 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpEffectChain_H
+#define kpEffectChain_H
+
+#include <QColor>
+#include <QList>
+
+#include "imagelib/kpImage.h"
+
+//
+// A sequence of per-pixel effects (Balance, Flatten, Grayscale, HSV and
+// Invert) that are applied together.
+//
+// applyEffect() gives the same result as applying each effect's own
+// applyEffect() in turn but makes a single pass over the image: every
+// effect is run on a scanline while it is still in the cache, before
+// moving on to the next one.
+//
+
+class kpEffectChain
+{
+public:
+    kpEffectChain();
+    kpEffectChain(const kpEffectChain &rhs);
+    kpEffectChain &operator=(const kpEffectChain &rhs);
+    ~kpEffectChain();
+
+    //
+    // Appends an effect to the chain.  The parameters are as for the
+    // corresponding kpEffect*::applyEffect().
+    //
+
+    void addBalance(int channels, int brightness, int contrast, int gamma);
+    void addFlatten(const QColor &color1, const QColor &color2);
+    void addGrayscale();
+    void addHSV(double hue, double saturation, double value);
+    void addInvert(int channels);
+
+    bool isEmpty() const;
+    int count() const;
+
+    // Returns true if applying the chain twice gives back the original
+    // image (only true if all the effects are inversions).
+    bool isInvertible() const;
+
+    kpImage applyEffect(const kpImage &image) const;
+
+private:
+    void applyEffectSlow(kpImage *image) const;
+
+    struct Step;
+    QList<Step> m_steps;
+};
+
+#endif // kpEffectChain_H
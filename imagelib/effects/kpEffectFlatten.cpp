@@ -6,6 +6,7 @@
 
 #include "kpEffectFlatten.h"
 #include "blitz.h"
+#include "kpEffectKernels.h"
 
 //--------------------------------------------------------------------------------
 // public static
@@ -22,6 +23,14 @@ void kpEffectFlatten::applyEffect(QImage *destImagePtr, const QColor &color1, co
 //--------------------------------------------------------------------------------
 // public static
 
+void kpEffectFlatten::applyEffect(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2)
+{
+    kpEffectKernels::flatten(pixels, count, premultiplied, color1, color2);
+}
+
+//--------------------------------------------------------------------------------
+// public static
+
 QImage kpEffectFlatten::applyEffect(const QImage &img, const QColor &color1, const QColor &color2)
 {
     QImage retImage = img;
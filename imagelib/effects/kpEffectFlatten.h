@@ -8,6 +8,8 @@
 #ifndef kpEffectFlatten_H
 #define kpEffectFlatten_H
 
+#include <QRgb>
+
 class QColor;
 class QImage;
 
@@ -16,6 +18,9 @@ class kpEffectFlatten
 public:
     static void applyEffect(QImage *destImagePtr, const QColor &color1, const QColor &color2);
     static QImage applyEffect(const QImage &img, const QColor &color1, const QColor &color2);
+
+    // Flattens <count> 32-bit <pixels> in place.
+    static void applyEffect(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2);
 };
 
 #endif // kpEffectFlatten_H
@@ -18,6 +18,9 @@ class kpEffectGrayscale
 {
 public:
     static kpImage applyEffect(const kpImage &image);
+
+    // Converts <count> 32-bit <pixels> in place.
+    static void applyEffect(QRgb *pixels, int count);
 };
 
 #endif // kpEffectGrayscale_H
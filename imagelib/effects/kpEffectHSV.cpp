@@ -136,3 +136,13 @@ kpImage kpEffectHSV::applyEffect(const kpImage &image, double hue, double satura
     ::AdjustHSV(&qimage, hue, saturation, value);
     return qimage;
 }
+
+// public static
+void kpEffectHSV::applyEffect(QRgb *pixels, int count, double hue, double saturation, double value)
+{
+    hue /= 360;
+
+    for (int i = 0; i < count; i++) {
+        pixels[i] = ::AdjustHSVInternal(pixels[i], hue, saturation, value);
+    }
+}
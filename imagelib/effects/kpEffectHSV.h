@@ -14,6 +14,9 @@ class kpEffectHSV
 {
 public:
     static kpImage applyEffect(const kpImage &image, double hue, double saturation, double value);
+
+    // Adjusts <count> 32-bit <pixels> in place.
+    static void applyEffect(QRgb *pixels, int count, double hue, double saturation, double value);
 };
 
 #endif // kpEffectHSV_H
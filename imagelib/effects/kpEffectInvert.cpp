@@ -11,6 +11,8 @@
 
 #include <QImage>
 
+#include "imagelib/effects/kpEffectKernels.h"
+
 #include "kpLogCategories.h"
 
 #include "pixmapfx/kpPixmapFX.h"
@@ -28,7 +30,12 @@ void kpEffectInvert::applyEffect(QImage *destImagePtr, int channels)
     qCDebug(kpLogImagelib) << "kpEffectInvert::applyEffect(channels=" << channels << ") mask=" << (int *)mask;
 #endif
 
-    if (destImagePtr->depth() > 8) {
+    if (destImagePtr->format() == QImage::Format_RGB32 || destImagePtr->format() == QImage::Format_ARGB32
+        || destImagePtr->format() == QImage::Format_ARGB32_Premultiplied) {
+        for (int y = 0; y < destImagePtr->height(); y++) {
+            kpEffectKernels::invert(reinterpret_cast<QRgb *>(destImagePtr->scanLine(y)), destImagePtr->width(), mask);
+        }
+    } else if (destImagePtr->depth() > 8) {
         // Above version works for Qt 3.2 at least.
         // But this version will always work (slower, though) and supports
         // inverting particular channels.
@@ -44,6 +51,22 @@ void kpEffectInvert::applyEffect(QImage *destImagePtr, int channels)
     }
 }
 
+// public static
+void kpEffectInvert::applyEffect(QRgb *pixels, int count, int channels, bool premultiplied)
+{
+    const QRgb mask = qRgba((channels & Red) ? 0xFF : 0, (channels & Green) ? 0xFF : 0, (channels & Blue) ? 0xFF : 0, 0 /*don't invert alpha*/);
+
+    // QImage::invertPixels() inverts the unpremultiplied colors,
+    // whereas inverting individual channels above works on the raw pixels.
+    if (channels == kpEffectInvert::RGB && premultiplied) {
+        for (int i = 0; i < count; i++) {
+            pixels[i] = qPremultiply(qUnpremultiply(pixels[i]) ^ mask);
+        }
+    } else {
+        kpEffectKernels::invert(pixels, count, mask);
+    }
+}
+
 // public static
 QImage kpEffectInvert::applyEffect(const QImage &img, int channels)
 {
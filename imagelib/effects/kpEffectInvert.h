@@ -8,6 +8,8 @@
 #ifndef kpEffectInvert_H
 #define kpEffectInvert_H
 
+#include <QRgb>
+
 class QImage;
 
 class kpEffectInvert
@@ -34,6 +36,10 @@ public:
 
     static void applyEffect(QImage *destImagePtr, int channels = RGB);
     static QImage applyEffect(const QImage &img, int channels = RGB);
+
+    // Inverts <count> 32-bit <pixels> in place, giving the same result as
+    // the above for an image with those pixels.
+    static void applyEffect(QRgb *pixels, int count, int channels, bool premultiplied);
 };
 
 #endif // kpEffectInvert_H
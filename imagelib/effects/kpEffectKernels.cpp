@@ -0,0 +1,637 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#include "kpEffectKernels.h"
+
+#include <QColor>
+
+#include "blitz.h"
+
+// The SIMD kernels are compiled for their instruction set with function
+// attributes, rather than for the whole file, so that the portable kernels
+// still run on any CPU.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KP_EFFECT_KERNELS_X86 1
+#include <immintrin.h>
+#define KP_TARGET_SSE2 __attribute__((target("sse2")))
+#define KP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define KP_EFFECT_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+//---------------------------------------------------------------------
+
+//
+// Constants shared by the kernels.
+//
+
+// kpEffectGrayscale's luminance weights (in millionths).
+static const int GrayRedWeight = 212671;
+static const int GrayGreenWeight = 715160;
+static const int GrayBlueWeight = 72169;
+
+// The weighted sum is at most 255 * 1000000 < 2^28.  For such sums,
+// (sum * GrayDivMagic) >> GrayDivShift == sum / 1000000 exactly, which
+// lets the SIMD kernels avoid integer division.
+static const unsigned int GrayDivMagic = 281474977u; // ceil (2^48 / 1000000)
+static const int GrayDivShift = 48;
+
+// For 0 <= x < 2^16, (x * ThirdMagic) >> 17 == x / 3.
+static const unsigned int ThirdMagic = 0xAAAB;
+
+// Returns Blitz::flatten()'s per-channel scale factor.
+static float FlattenScale(int from, int to)
+{
+    const int min = 0, max = 255;
+    return static_cast<float>(to - from) / (max - min);
+}
+
+//---------------------------------------------------------------------
+
+//
+// Portable kernels.
+//
+
+static void InvertScalar(QRgb *pixels, int count, QRgb mask)
+{
+    for (int i = 0; i < count; i++) {
+        pixels[i] ^= mask;
+    }
+}
+
+static QRgb ToGray(QRgb rgb)
+{
+    // naive way that doesn't preserve brightness
+    // int gray = (qRed (rgb) + qGreen (rgb) + qBlue (rgb)) / 3;
+
+    // over-exaggerates red & blue
+    // int gray = qGray (rgb);
+
+    int gray = (GrayRedWeight * qRed(rgb) + GrayGreenWeight * qGreen(rgb) + GrayBlueWeight * qBlue(rgb)) / 1000000;
+    return qRgba(gray, gray, gray, qAlpha(rgb));
+}
+
+static void GrayscaleScalar(QRgb *pixels, int count)
+{
+    for (int i = 0; i < count; i++) {
+        pixels[i] = ToGray(pixels[i]);
+    }
+}
+
+static void FlattenScalar(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2)
+{
+    Blitz::flatten(pixels, count, premultiplied, color1, color2);
+}
+
+//---------------------------------------------------------------------
+
+#if KP_EFFECT_KERNELS_X86
+
+//
+// SSE2 kernels (4 pixels at a time).
+//
+
+KP_TARGET_SSE2 static void InvertSSE2(QRgb *pixels, int count, QRgb mask)
+{
+    const __m128i maskVec = _mm_set1_epi32(static_cast<int>(mask));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), maskVec));
+    }
+
+    InvertScalar(pixels + i, count - i, mask);
+}
+
+// Returns <n> / 1000000 for each 32-bit lane, where n < 2^28.
+KP_TARGET_SSE2 static inline __m128i DivideByMillionSSE2(__m128i n)
+{
+    const __m128i magic = _mm_set1_epi32(static_cast<int>(GrayDivMagic));
+
+    // _mm_mul_epu32() only multiplies the even lanes, giving 64-bit products.
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(n, magic), GrayDivShift);
+    const __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(n, 32), magic), GrayDivShift);
+
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+// Returns the per-pixel sums of the 32-bit pairs produced by
+// _mm_madd_epi16() for pixels 0 & 1 (<lo>) and 2 & 3 (<hi>).
+KP_TARGET_SSE2 static inline __m128i SumPairsSSE2(__m128i lo, __m128i hi)
+{
+    const __m128 loF = _mm_castsi128_ps(lo), hiF = _mm_castsi128_ps(hi);
+    return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(loF, hiF, _MM_SHUFFLE(2, 0, 2, 0))),
+                         _mm_castps_si128(_mm_shuffle_ps(loF, hiF, _MM_SHUFFLE(3, 1, 3, 1))));
+}
+
+KP_TARGET_SSE2 static void GrayscaleSSE2(QRgb *pixels, int count)
+{
+    // SSE2 has no 32-bit multiply so the weighted sum is computed with
+    // 16-bit multiplies, splitting each weight into (high * 256 + low).
+    // In memory, a pixel is laid out as B, G, R, A.
+    const __m128i weightsHigh = _mm_setr_epi16(GrayBlueWeight >> 8,
+                                               GrayGreenWeight >> 8,
+                                               GrayRedWeight >> 8,
+                                               0,
+                                               GrayBlueWeight >> 8,
+                                               GrayGreenWeight >> 8,
+                                               GrayRedWeight >> 8,
+                                               0);
+    const __m128i weightsLow = _mm_setr_epi16(GrayBlueWeight & 0xFF,
+                                              GrayGreenWeight & 0xFF,
+                                              GrayRedWeight & 0xFF,
+                                              0,
+                                              GrayBlueWeight & 0xFF,
+                                              GrayGreenWeight & 0xFF,
+                                              GrayRedWeight & 0xFF,
+                                              0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        const __m128i rgba = _mm_loadu_si128(p);
+
+        const __m128i lo = _mm_unpacklo_epi8(rgba, zero);
+        const __m128i hi = _mm_unpackhi_epi8(rgba, zero);
+
+        const __m128i sumHigh = SumPairsSSE2(_mm_madd_epi16(lo, weightsHigh), _mm_madd_epi16(hi, weightsHigh));
+        const __m128i sumLow = SumPairsSSE2(_mm_madd_epi16(lo, weightsLow), _mm_madd_epi16(hi, weightsLow));
+
+        const __m128i gray = DivideByMillionSSE2(_mm_add_epi32(_mm_slli_epi32(sumHigh, 8), sumLow));
+
+        const __m128i result = _mm_or_si128(_mm_and_si128(rgba, alphaMask),
+                                            _mm_or_si128(gray, _mm_or_si128(_mm_slli_epi32(gray, 8), _mm_slli_epi32(gray, 16))));
+        _mm_storeu_si128(p, result);
+    }
+
+    GrayscaleScalar(pixels + i, count - i);
+}
+
+// Returns Blitz's (c * a + ((c * a) >> 8) + 0x80) >> 8 premultiplication
+// for each 32-bit lane, where c, a <= 255.
+KP_TARGET_SSE2 static inline __m128i PremultiplyChannelSSE2(__m128i c, __m128i a)
+{
+    // The product fits in the low 16 bits of each lane.
+    const __m128i t = _mm_mullo_epi16(c, a);
+    return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), _mm_set1_epi32(0x80)), 8);
+}
+
+// Blitz's convertFromPremult() for one channel: 255 * c / alpha, truncated,
+// or 0 if alpha is 0.  The single precision quotient always truncates to
+// the exact integer quotient, since 255 * c < 2^16.
+KP_TARGET_SSE2 static inline __m128i UnpremultiplyChannelSSE2(__m128i c, __m128 alphaF, __m128i alphaNonZero)
+{
+    const __m128 c255 = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_slli_epi32(c, 8), c));
+    return _mm_and_si128(_mm_and_si128(_mm_cvttps_epi32(_mm_div_ps(c255, alphaF)), _mm_set1_epi32(0xFF)), alphaNonZero);
+}
+
+// Blitz::flatten()'s sr * (mean - min) + r1 + 0.5f, with the same floating
+// point operations in the same order, truncated to a byte.
+KP_TARGET_SSE2 static inline __m128i FlattenChannelSSE2(__m128 mean, __m128 scale, __m128 from)
+{
+    return _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(scale, mean), from), _mm_set1_ps(0.5f))), _mm_set1_epi32(0xFF));
+}
+
+KP_TARGET_SSE2 static void FlattenSSE2(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2)
+{
+    const __m128 scaleRed = _mm_set1_ps(FlattenScale(color1.red(), color2.red()));
+    const __m128 scaleGreen = _mm_set1_ps(FlattenScale(color1.green(), color2.green()));
+    const __m128 scaleBlue = _mm_set1_ps(FlattenScale(color1.blue(), color2.blue()));
+
+    const __m128 red1 = _mm_set1_ps(static_cast<float>(color1.red()));
+    const __m128 green1 = _mm_set1_ps(static_cast<float>(color1.green()));
+    const __m128 blue1 = _mm_set1_ps(static_cast<float>(color1.blue()));
+
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i third = _mm_set1_epi32(static_cast<int>(ThirdMagic));
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto *p = reinterpret_cast<__m128i *>(pixels + i);
+        const __m128i rgba = _mm_loadu_si128(p);
+
+        const __m128i alpha = _mm_srli_epi32(rgba, 24);
+        __m128i red = _mm_and_si128(_mm_srli_epi32(rgba, 16), byteMask);
+        __m128i green = _mm_and_si128(_mm_srli_epi32(rgba, 8), byteMask);
+        __m128i blue = _mm_and_si128(rgba, byteMask);
+
+        if (premultiplied) {
+            const __m128 alphaF = _mm_cvtepi32_ps(alpha);
+            const __m128i alphaNonZero = _mm_xor_si128(_mm_cmpeq_epi32(alpha, zero), _mm_set1_epi32(-1));
+            red = UnpremultiplyChannelSSE2(red, alphaF, alphaNonZero);
+            green = UnpremultiplyChannelSSE2(green, alphaF, alphaNonZero);
+            blue = UnpremultiplyChannelSSE2(blue, alphaF, alphaNonZero);
+        }
+
+        // (r + g + b) / 3, using a 16-bit multiply since the sum < 2^16
+        const __m128i sum = _mm_add_epi32(_mm_add_epi32(red, green), blue);
+        const __m128 mean = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_mulhi_epu16(sum, third), 1));
+
+        __m128i newRed = FlattenChannelSSE2(mean, scaleRed, red1);
+        __m128i newGreen = FlattenChannelSSE2(mean, scaleGreen, green1);
+        __m128i newBlue = FlattenChannelSSE2(mean, scaleBlue, blue1);
+
+        if (premultiplied) {
+            newRed = _mm_and_si128(PremultiplyChannelSSE2(newRed, alpha), byteMask);
+            newGreen = _mm_and_si128(PremultiplyChannelSSE2(newGreen, alpha), byteMask);
+            newBlue = _mm_and_si128(PremultiplyChannelSSE2(newBlue, alpha), byteMask);
+        }
+
+        const __m128i result =
+            _mm_or_si128(_mm_or_si128(_mm_slli_epi32(alpha, 24), _mm_slli_epi32(newRed, 16)), _mm_or_si128(_mm_slli_epi32(newGreen, 8), newBlue));
+        _mm_storeu_si128(p, result);
+    }
+
+    FlattenScalar(pixels + i, count - i, premultiplied, color1, color2);
+}
+
+//---------------------------------------------------------------------
+
+//
+// AVX2 kernels (8 pixels at a time).
+//
+
+KP_TARGET_AVX2 static void InvertAVX2(QRgb *pixels, int count, QRgb mask)
+{
+    const __m256i maskVec = _mm256_set1_epi32(static_cast<int>(mask));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), maskVec));
+    }
+
+    InvertScalar(pixels + i, count - i, mask);
+}
+
+// Returns <n> / 1000000 for each 32-bit lane, where n < 2^28.
+KP_TARGET_AVX2 static inline __m256i DivideByMillionAVX2(__m256i n)
+{
+    const __m256i magic = _mm256_set1_epi32(static_cast<int>(GrayDivMagic));
+
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(n, magic), GrayDivShift);
+    const __m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(n, 32), magic), GrayDivShift);
+
+    return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+KP_TARGET_AVX2 static void GrayscaleAVX2(QRgb *pixels, int count)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    const __m256i redWeight = _mm256_set1_epi32(GrayRedWeight);
+    const __m256i greenWeight = _mm256_set1_epi32(GrayGreenWeight);
+    const __m256i blueWeight = _mm256_set1_epi32(GrayBlueWeight);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        const __m256i rgba = _mm256_loadu_si256(p);
+
+        const __m256i red = _mm256_and_si256(_mm256_srli_epi32(rgba, 16), byteMask);
+        const __m256i green = _mm256_and_si256(_mm256_srli_epi32(rgba, 8), byteMask);
+        const __m256i blue = _mm256_and_si256(rgba, byteMask);
+
+        const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(red, redWeight), _mm256_mullo_epi32(green, greenWeight)),
+                                             _mm256_mullo_epi32(blue, blueWeight));
+        const __m256i gray = DivideByMillionAVX2(sum);
+
+        const __m256i result = _mm256_or_si256(_mm256_and_si256(rgba, alphaMask),
+                                               _mm256_or_si256(gray, _mm256_or_si256(_mm256_slli_epi32(gray, 8), _mm256_slli_epi32(gray, 16))));
+        _mm256_storeu_si256(p, result);
+    }
+
+    GrayscaleScalar(pixels + i, count - i);
+}
+
+KP_TARGET_AVX2 static inline __m256i PremultiplyChannelAVX2(__m256i c, __m256i a)
+{
+    const __m256i t = _mm256_mullo_epi16(c, a);
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(t, _mm256_srli_epi32(t, 8)), _mm256_set1_epi32(0x80)), 8);
+}
+
+KP_TARGET_AVX2 static inline __m256i UnpremultiplyChannelAVX2(__m256i c, __m256 alphaF, __m256i alphaNonZero)
+{
+    const __m256 c255 = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_slli_epi32(c, 8), c));
+    return _mm256_and_si256(_mm256_and_si256(_mm256_cvttps_epi32(_mm256_div_ps(c255, alphaF)), _mm256_set1_epi32(0xFF)), alphaNonZero);
+}
+
+KP_TARGET_AVX2 static inline __m256i FlattenChannelAVX2(__m256 mean, __m256 scale, __m256 from)
+{
+    return _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(scale, mean), from), _mm256_set1_ps(0.5f))),
+                            _mm256_set1_epi32(0xFF));
+}
+
+KP_TARGET_AVX2 static void FlattenAVX2(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2)
+{
+    const __m256 scaleRed = _mm256_set1_ps(FlattenScale(color1.red(), color2.red()));
+    const __m256 scaleGreen = _mm256_set1_ps(FlattenScale(color1.green(), color2.green()));
+    const __m256 scaleBlue = _mm256_set1_ps(FlattenScale(color1.blue(), color2.blue()));
+
+    const __m256 red1 = _mm256_set1_ps(static_cast<float>(color1.red()));
+    const __m256 green1 = _mm256_set1_ps(static_cast<float>(color1.green()));
+    const __m256 blue1 = _mm256_set1_ps(static_cast<float>(color1.blue()));
+
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i third = _mm256_set1_epi32(static_cast<int>(ThirdMagic));
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        auto *p = reinterpret_cast<__m256i *>(pixels + i);
+        const __m256i rgba = _mm256_loadu_si256(p);
+
+        const __m256i alpha = _mm256_srli_epi32(rgba, 24);
+        __m256i red = _mm256_and_si256(_mm256_srli_epi32(rgba, 16), byteMask);
+        __m256i green = _mm256_and_si256(_mm256_srli_epi32(rgba, 8), byteMask);
+        __m256i blue = _mm256_and_si256(rgba, byteMask);
+
+        if (premultiplied) {
+            const __m256 alphaF = _mm256_cvtepi32_ps(alpha);
+            const __m256i alphaNonZero = _mm256_xor_si256(_mm256_cmpeq_epi32(alpha, zero), _mm256_set1_epi32(-1));
+            red = UnpremultiplyChannelAVX2(red, alphaF, alphaNonZero);
+            green = UnpremultiplyChannelAVX2(green, alphaF, alphaNonZero);
+            blue = UnpremultiplyChannelAVX2(blue, alphaF, alphaNonZero);
+        }
+
+        const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(red, green), blue);
+        const __m256 mean = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_mulhi_epu16(sum, third), 1));
+
+        __m256i newRed = FlattenChannelAVX2(mean, scaleRed, red1);
+        __m256i newGreen = FlattenChannelAVX2(mean, scaleGreen, green1);
+        __m256i newBlue = FlattenChannelAVX2(mean, scaleBlue, blue1);
+
+        if (premultiplied) {
+            newRed = _mm256_and_si256(PremultiplyChannelAVX2(newRed, alpha), byteMask);
+            newGreen = _mm256_and_si256(PremultiplyChannelAVX2(newGreen, alpha), byteMask);
+            newBlue = _mm256_and_si256(PremultiplyChannelAVX2(newBlue, alpha), byteMask);
+        }
+
+        const __m256i result = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(alpha, 24), _mm256_slli_epi32(newRed, 16)),
+                                               _mm256_or_si256(_mm256_slli_epi32(newGreen, 8), newBlue));
+        _mm256_storeu_si256(p, result);
+    }
+
+    FlattenScalar(pixels + i, count - i, premultiplied, color1, color2);
+}
+
+#endif // KP_EFFECT_KERNELS_X86
+
+//---------------------------------------------------------------------
+
+#if KP_EFFECT_KERNELS_NEON
+
+//
+// NEON kernels (4 pixels at a time).
+//
+
+static void InvertNEON(QRgb *pixels, int count, QRgb mask)
+{
+    const uint32x4_t maskVec = vdupq_n_u32(mask);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(pixels + i, veorq_u32(vld1q_u32(pixels + i), maskVec));
+    }
+
+    InvertScalar(pixels + i, count - i, mask);
+}
+
+static void GrayscaleNEON(QRgb *pixels, int count)
+{
+    const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+    const uint32x4_t alphaMask = vdupq_n_u32(0xFF000000);
+    const uint32x2_t magic = vdup_n_u32(GrayDivMagic);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t rgba = vld1q_u32(pixels + i);
+
+        const uint32x4_t red = vandq_u32(vshrq_n_u32(rgba, 16), byteMask);
+        const uint32x4_t green = vandq_u32(vshrq_n_u32(rgba, 8), byteMask);
+        const uint32x4_t blue = vandq_u32(rgba, byteMask);
+
+        uint32x4_t sum = vmulq_n_u32(red, GrayRedWeight);
+        sum = vmlaq_n_u32(sum, green, GrayGreenWeight);
+        sum = vmlaq_n_u32(sum, blue, GrayBlueWeight);
+
+        const uint32x2_t grayLow = vmovn_u64(vshrq_n_u64(vmull_u32(vget_low_u32(sum), magic), GrayDivShift));
+        const uint32x2_t grayHigh = vmovn_u64(vshrq_n_u64(vmull_u32(vget_high_u32(sum), magic), GrayDivShift));
+        const uint32x4_t gray = vcombine_u32(grayLow, grayHigh);
+
+        vst1q_u32(pixels + i, vorrq_u32(vandq_u32(rgba, alphaMask), vmulq_n_u32(gray, 0x010101)));
+    }
+
+    GrayscaleScalar(pixels + i, count - i);
+}
+
+static inline uint32x4_t PremultiplyChannelNEON(uint32x4_t c, uint32x4_t a)
+{
+    const uint32x4_t t = vmulq_u32(c, a);
+    return vshrq_n_u32(vaddq_u32(vaddq_u32(t, vshrq_n_u32(t, 8)), vdupq_n_u32(0x80)), 8);
+}
+
+static inline uint32x4_t UnpremultiplyChannelNEON(uint32x4_t c, float32x4_t alphaF, uint32x4_t alphaNonZero)
+{
+    const float32x4_t c255 = vcvtq_f32_u32(vmulq_n_u32(c, 255));
+    return vandq_u32(vandq_u32(vcvtq_u32_f32(vdivq_f32(c255, alphaF)), vdupq_n_u32(0xFF)), alphaNonZero);
+}
+
+// Separate multiplies and adds, never fused, to match Blitz
+// (see -ffp-contract=off in CMakeLists.txt).
+static inline uint32x4_t FlattenChannelNEON(float32x4_t mean, float32x4_t scale, float32x4_t from)
+{
+    return vandq_u32(vcvtq_u32_f32(vaddq_f32(vaddq_f32(vmulq_f32(scale, mean), from), vdupq_n_f32(0.5f))), vdupq_n_u32(0xFF));
+}
+
+static void FlattenNEON(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2)
+{
+    const float32x4_t scaleRed = vdupq_n_f32(FlattenScale(color1.red(), color2.red()));
+    const float32x4_t scaleGreen = vdupq_n_f32(FlattenScale(color1.green(), color2.green()));
+    const float32x4_t scaleBlue = vdupq_n_f32(FlattenScale(color1.blue(), color2.blue()));
+
+    const float32x4_t red1 = vdupq_n_f32(static_cast<float>(color1.red()));
+    const float32x4_t green1 = vdupq_n_f32(static_cast<float>(color1.green()));
+    const float32x4_t blue1 = vdupq_n_f32(static_cast<float>(color1.blue()));
+
+    const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t rgba = vld1q_u32(pixels + i);
+
+        const uint32x4_t alpha = vshrq_n_u32(rgba, 24);
+        uint32x4_t red = vandq_u32(vshrq_n_u32(rgba, 16), byteMask);
+        uint32x4_t green = vandq_u32(vshrq_n_u32(rgba, 8), byteMask);
+        uint32x4_t blue = vandq_u32(rgba, byteMask);
+
+        if (premultiplied) {
+            const float32x4_t alphaF = vcvtq_f32_u32(alpha);
+            const uint32x4_t alphaNonZero = vtstq_u32(alpha, alpha);
+            red = UnpremultiplyChannelNEON(red, alphaF, alphaNonZero);
+            green = UnpremultiplyChannelNEON(green, alphaF, alphaNonZero);
+            blue = UnpremultiplyChannelNEON(blue, alphaF, alphaNonZero);
+        }
+
+        const uint32x4_t sum = vaddq_u32(vaddq_u32(red, green), blue);
+        const float32x4_t mean = vcvtq_f32_u32(vshrq_n_u32(vmulq_n_u32(sum, ThirdMagic), 17));
+
+        uint32x4_t newRed = FlattenChannelNEON(mean, scaleRed, red1);
+        uint32x4_t newGreen = FlattenChannelNEON(mean, scaleGreen, green1);
+        uint32x4_t newBlue = FlattenChannelNEON(mean, scaleBlue, blue1);
+
+        if (premultiplied) {
+            newRed = vandq_u32(PremultiplyChannelNEON(newRed, alpha), byteMask);
+            newGreen = vandq_u32(PremultiplyChannelNEON(newGreen, alpha), byteMask);
+            newBlue = vandq_u32(PremultiplyChannelNEON(newBlue, alpha), byteMask);
+        }
+
+        const uint32x4_t result =
+            vorrq_u32(vorrq_u32(vshlq_n_u32(alpha, 24), vshlq_n_u32(newRed, 16)), vorrq_u32(vshlq_n_u32(newGreen, 8), newBlue));
+        vst1q_u32(pixels + i, result);
+    }
+
+    FlattenScalar(pixels + i, count - i, premultiplied, color1, color2);
+}
+
+#endif // KP_EFFECT_KERNELS_NEON
+
+//---------------------------------------------------------------------
+
+// public static
+kpEffectKernels::InstructionSet kpEffectKernels::bestInstructionSet()
+{
+    static const InstructionSet best = []() {
+        if (isSupported(AVX2)) {
+            return AVX2;
+        }
+        if (isSupported(SSE2)) {
+            return SSE2;
+        }
+        if (isSupported(NEON)) {
+            return NEON;
+        }
+        return Scalar;
+    }();
+
+    return best;
+}
+
+// public static
+bool kpEffectKernels::isSupported(InstructionSet set)
+{
+    switch (set) {
+    case Scalar:
+        return true;
+
+#if KP_EFFECT_KERNELS_X86
+    case SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+
+    case AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+
+#if KP_EFFECT_KERNELS_NEON
+    case NEON:
+        // (always present on AArch64)
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpEffectKernels::invert(QRgb *pixels, int count, QRgb mask, InstructionSet set)
+{
+    switch (set) {
+#if KP_EFFECT_KERNELS_X86
+    case SSE2:
+        InvertSSE2(pixels, count, mask);
+        return;
+
+    case AVX2:
+        InvertAVX2(pixels, count, mask);
+        return;
+#endif
+
+#if KP_EFFECT_KERNELS_NEON
+    case NEON:
+        InvertNEON(pixels, count, mask);
+        return;
+#endif
+
+    default:
+        InvertScalar(pixels, count, mask);
+        return;
+    }
+}
+
+// public static
+void kpEffectKernels::grayscale(QRgb *pixels, int count, InstructionSet set)
+{
+    switch (set) {
+#if KP_EFFECT_KERNELS_X86
+    case SSE2:
+        GrayscaleSSE2(pixels, count);
+        return;
+
+    case AVX2:
+        GrayscaleAVX2(pixels, count);
+        return;
+#endif
+
+#if KP_EFFECT_KERNELS_NEON
+    case NEON:
+        GrayscaleNEON(pixels, count);
+        return;
+#endif
+
+    default:
+        GrayscaleScalar(pixels, count);
+        return;
+    }
+}
+
+// public static
+void kpEffectKernels::flatten(QRgb *pixels, int count, bool premultiplied, const QColor &color1, const QColor &color2, InstructionSet set)
+{
+    switch (set) {
+#if KP_EFFECT_KERNELS_X86
+    case SSE2:
+        FlattenSSE2(pixels, count, premultiplied, color1, color2);
+        return;
+
+    case AVX2:
+        FlattenAVX2(pixels, count, premultiplied, color1, color2);
+        return;
+#endif
+
+#if KP_EFFECT_KERNELS_NEON
+    case NEON:
+        FlattenNEON(pixels, count, premultiplied, color1, color2);
+        return;
+#endif
+
+    default:
+        FlattenScalar(pixels, count, premultiplied, color1, color2);
+        return;
+    }
+}
@@ -0,0 +1,57 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpEffectKernels_H
+#define kpEffectKernels_H
+
+#include <QRgb>
+
+class QColor;
+
+//
+// Scanline kernels for simple per-pixel effects.
+//
+// Each kernel has a portable implementation and, where the compiler and
+// CPU support it, SIMD implementations that give exactly the same
+// results.  By default, the best instruction set supported by the
+// running CPU is used.
+//
+// The kernels work on 32-bit pixels (QImage::Format_RGB32, Format_ARGB32
+// and Format_ARGB32_Premultiplied) or on color tables.
+//
+
+class kpEffectKernels
+{
+public:
+    enum InstructionSet {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    // Returns the best instruction set that both this build and the
+    // running CPU support.  This is determined only once.
+    static InstructionSet bestInstructionSet();
+    static bool isSupported(InstructionSet set);
+
+    // XORs each pixel with <mask>.
+    static void invert(QRgb *pixels, int count, QRgb mask, InstructionSet set = bestInstructionSet());
+
+    // Same as kpEffectGrayscale::applyEffect().
+    static void grayscale(QRgb *pixels, int count, InstructionSet set = bestInstructionSet());
+
+    // Same as Blitz::flatten().
+    static void flatten(QRgb *pixels,
+                        int count,
+                        bool premultiplied,
+                        const QColor &color1,
+                        const QColor &color2,
+                        InstructionSet set = bestInstructionSet());
+};
+
+#endif // kpEffectKernels_H
@@ -0,0 +1,325 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_IMAGE_PYRAMID 0
+
+#include "kpImagePyramid.h"
+
+#include <algorithm>
+
+#include <QtMath>
+
+#include "imagelib/kpTiledImage.h"
+#include "kpLogCategories.h"
+
+//---------------------------------------------------------------------
+
+// Returns the rect of level <level> covering <rect> of level 0.
+static QRect LevelRect(const QRect &rect, int level)
+{
+    const int left = rect.left() >> level, top = rect.top() >> level;
+    const int right = rect.right() >> level, bottom = rect.bottom() >> level;
+    return {left, top, right - left + 1, bottom - top + 1};
+}
+
+//---------------------------------------------------------------------
+
+// Recomputes <childRect> of a level from the 2x2 blocks of the parent
+// level (of size <parentSize>) that it covers, which <src> holds from
+// <srcOrigin> onwards.  <child> holds the level from <childOrigin>
+// onwards.  At odd right or bottom edges, the last parent column or row
+// stands in for the missing one.
+static void Downsample(const QImage &src,
+                       const QPoint &srcOrigin,
+                       const QSize &parentSize,
+                       QImage *child,
+                       const QPoint &childOrigin,
+                       const QRect &childRect)
+{
+    const int parentRight = parentSize.width() - 1;
+    const int parentBottom = parentSize.height() - 1;
+
+    for (int y = childRect.top(); y <= childRect.bottom(); y++) {
+        const int y0 = 2 * y;
+        const int y1 = qMin(y0 + 1, parentBottom);
+        const auto *line0 = reinterpret_cast<const QRgb *>(src.constScanLine(y0 - srcOrigin.y()));
+        const auto *line1 = reinterpret_cast<const QRgb *>(src.constScanLine(y1 - srcOrigin.y()));
+        auto *childLine = reinterpret_cast<QRgb *>(child->scanLine(y - childOrigin.y())) - childOrigin.x();
+
+        for (int x = childRect.left(); x <= childRect.right(); x++) {
+            const int x0 = 2 * x - srcOrigin.x();
+            const int x1 = qMin(2 * x + 1, parentRight) - srcOrigin.x();
+
+            const QRgb p[4] = {line0[x0], line0[x1], line1[x0], line1[x1]};
+            int a = 2, r = 2, g = 2, b = 2;
+            for (const QRgb q : p) {
+                a += qAlpha(q);
+                r += qRed(q);
+                g += qGreen(q);
+                b += qBlue(q);
+            }
+
+            childLine[x] = qRgba(r >> 2, g >> 2, b >> 2, a >> 2);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+static void Downsample(const QImage &parent, QImage *child, const QRect &childRect)
+{
+    const QRect parentRect = QRect(childRect.x() * 2, childRect.y() * 2, childRect.width() * 2, childRect.height() * 2) & parent.rect();
+    if (parentRect.isEmpty()) {
+        return;
+    }
+
+    // Only ever true for level 0, which is the caller's image.
+    if (parent.format() != QImage::Format_ARGB32_Premultiplied) {
+        const QImage src = parent.copy(parentRect).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        ::Downsample(src, parentRect.topLeft(), parent.size(), child, QPoint(0, 0), childRect);
+    } else {
+        ::Downsample(parent, QPoint(0, 0), parent.size(), child, QPoint(0, 0), childRect);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// The deepest level that DownsampleTiled() can compute.  Up to this
+// level, every block of level 0 pixels that is averaged into one pixel
+// is within a single tile.
+static const int TileLevels = 8;
+static_assert((1 << TileLevels) == kpTiledImage::TileSize, "TileLevels must match kpTiledImage::TileSize");
+
+// levelAt() does not build levels of a tiled image bigger than this.
+static const qint64 MaxCachedLevelBytes = qint64(64) << 20;
+
+// Recomputes <childRect> of level <level> (at most TileLevels) straight
+// from the tiles of level 0, one tile at a time, into <child>, which holds
+// the level from <childOrigin> onwards.  This gives the same pixels as
+// going through each level in between but without keeping those levels,
+// which can be as big as the image itself.
+static void DownsampleTiled(const kpTiledImage &base, int level, QImage *child, const QPoint &childOrigin, const QRect &childRect)
+{
+    Q_ASSERT(level >= 1 && level <= TileLevels);
+
+    const QRect baseRect = QRect(childRect.x() << level, childRect.y() << level, childRect.width() << level, childRect.height() << level) & base.rect();
+    if (baseRect.isEmpty()) {
+        return;
+    }
+
+    const int size = kpTiledImage::TileSize;
+    for (int row = baseRect.top() / size; row <= baseRect.bottom() / size; row++) {
+        for (int column = baseRect.left() / size; column <= baseRect.right() / size; column++) {
+            const int i = base.tileIndexAt(column * size, row * size);
+            const QRect tileRect = base.tileRect(i);
+            const QRect tileChildRect = ::LevelRect(tileRect, level) & childRect;
+
+            if (base.isTileSolid(i)) {
+                // (the average of equal pixels is that pixel)
+                const QRgb color = base.tileColor(i);
+                for (int y = tileChildRect.top(); y <= tileChildRect.bottom(); y++) {
+                    auto *childLine = reinterpret_cast<QRgb *>(child->scanLine(y - childOrigin.y())) + (tileChildRect.left() - childOrigin.x());
+                    std::fill(childLine, childLine + tileChildRect.width(), color);
+                }
+                continue;
+            }
+
+            // Halve the tile until just before <level>...
+            QImage src = base.tileImage(i);
+            QPoint srcOrigin = tileRect.topLeft();
+            for (int k = 1; k < level; k++) {
+                const QRect levelTileRect = ::LevelRect(tileRect, k);
+                QImage dest(levelTileRect.size(), QImage::Format_ARGB32_Premultiplied);
+                ::Downsample(src, srcOrigin, kpImagePyramid::levelSize(base.size(), k - 1), &dest, levelTileRect.topLeft(), levelTileRect);
+
+                src = dest;
+                srcOrigin = levelTileRect.topLeft();
+            }
+
+            // ...and then into <child>.
+            ::Downsample(src, srcOrigin, kpImagePyramid::levelSize(base.size(), level - 1), child, childOrigin, tileChildRect);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpImagePyramid::invalidate(const QRect &rect)
+{
+    for (int i = 0; i < m_levels.count(); i++) {
+        m_dirtyRects[i] |= ::LevelRect(rect, i + 1) & m_levels[i].rect();
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpImagePyramid::invalidate()
+{
+    m_levels.clear();
+    m_dirtyRects.clear();
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpImagePyramid::level(const kpImage &base, int level)
+{
+    if (level <= 0 || base.isNull()) {
+        return base;
+    }
+
+    setBaseSize(base.size());
+
+    for (int i = 0; i < level; i++) {
+        allocateLevel(i + 1);
+
+        if (!m_dirtyRects[i].isEmpty()) {
+#if DEBUG_KP_IMAGE_PYRAMID
+            qCDebug(kpLogImagelib) << "kpImagePyramid::level() updating level" << i + 1 << "rect=" << m_dirtyRects[i];
+#endif
+            ::Downsample((i == 0) ? base : m_levels[i - 1], &m_levels[i], m_dirtyRects[i]);
+            m_dirtyRects[i] = QRect();
+        }
+    }
+
+    return m_levels[level - 1];
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpImagePyramid::level(const kpTiledImage &base, int level)
+{
+    if (base.isNull()) {
+        return {};
+    }
+
+    if (level <= 0) {
+        return base.toImage();
+    }
+
+    setBaseSize(base.size());
+
+    // The levels before this one are skipped.
+    const int tiledLevel = qMin(level, TileLevels);
+    allocateLevel(tiledLevel);
+
+    if (!m_dirtyRects[tiledLevel - 1].isEmpty()) {
+#if DEBUG_KP_IMAGE_PYRAMID
+        qCDebug(kpLogImagelib) << "kpImagePyramid::level() updating level" << tiledLevel << "from tiles rect=" << m_dirtyRects[tiledLevel - 1];
+#endif
+        ::DownsampleTiled(base, tiledLevel, &m_levels[tiledLevel - 1], QPoint(0, 0), m_dirtyRects[tiledLevel - 1]);
+        m_dirtyRects[tiledLevel - 1] = QRect();
+    }
+
+    for (int i = tiledLevel; i < level; i++) {
+        allocateLevel(i + 1);
+
+        if (!m_dirtyRects[i].isEmpty()) {
+#if DEBUG_KP_IMAGE_PYRAMID
+            qCDebug(kpLogImagelib) << "kpImagePyramid::level() updating level" << i + 1 << "rect=" << m_dirtyRects[i];
+#endif
+            ::Downsample(m_levels[i - 1], &m_levels[i], m_dirtyRects[i]);
+            m_dirtyRects[i] = QRect();
+        }
+    }
+
+    return m_levels[level - 1];
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpImagePyramid::levelAt(const kpTiledImage &base, int level, const QRect &levelRect)
+{
+    const QSize size = levelSize(base.size(), level);
+    if (level <= 0 || level > TileLevels || qint64(size.width()) * size.height() * 4 <= MaxCachedLevelBytes) {
+        return this->level(base, level).copy(levelRect);
+    }
+
+#if DEBUG_KP_IMAGE_PYRAMID
+    qCDebug(kpLogImagelib) << "kpImagePyramid::levelAt() computing level" << level << "rect=" << levelRect << "from tiles";
+#endif
+
+    // (same as QImage::copy())
+    kpImage ret(levelRect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (ret.isNull()) {
+        return ret;
+    }
+
+    const QRect rect = levelRect & QRect(QPoint(0, 0), size);
+    if (rect != levelRect) {
+        ret.fill(0);
+    }
+
+    if (!rect.isEmpty()) {
+        ::DownsampleTiled(base, level, &ret, levelRect.topLeft(), rect);
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpImagePyramid::setBaseSize(const QSize &baseSize)
+{
+    // Resized behind our back?
+    if (baseSize != m_baseSize) {
+        invalidate();
+        m_baseSize = baseSize;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpImagePyramid::allocateLevel(int level)
+{
+    while (m_levels.count() < level) {
+        m_levels.append(kpImage());
+        m_dirtyRects.append(QRect());
+    }
+
+    if (m_levels[level - 1].isNull()) {
+        const QSize size = levelSize(m_baseSize, level);
+#if DEBUG_KP_IMAGE_PYRAMID
+        qCDebug(kpLogImagelib) << "kpImagePyramid::level() building level" << level << "size=" << size;
+#endif
+        m_levels[level - 1] = kpImage(size, QImage::Format_ARGB32_Premultiplied);
+        m_dirtyRects[level - 1] = QRect(QPoint(0, 0), size);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QSize kpImagePyramid::levelSize(const QSize &baseSize, int level)
+{
+    QSize size = baseSize;
+    for (int i = 0; i < level; i++) {
+        size = QSize(qMax(1, (size.width() + 1) / 2), qMax(1, (size.height() + 1) / 2));
+    }
+    return size;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+int kpImagePyramid::levelForScale(double scale)
+{
+    if (scale >= 1 || scale <= 0) {
+        return 0;
+    }
+
+    // Don't go further than needed for a 1x1 thumbnail of a huge image.
+    return qMin(30, int(std::floor(std::log2(1.0 / scale))));
+}
+
+//---------------------------------------------------------------------
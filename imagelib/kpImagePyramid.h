@@ -0,0 +1,80 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpImagePyramid_H
+#define kpImagePyramid_H
+
+#include <QList>
+#include <QRect>
+
+#include "imagelib/kpImage.h"
+
+class kpTiledImage;
+
+//
+// A cache of successively halved copies of an image (a "mipmap pyramid"),
+// for drawing it smaller than 100% without downsampling the full
+// resolution image each time.
+//
+// Level 0 is the image itself, level 1 is half its width and height,
+// level 2 is a quarter and so on.  Each pixel of level <n> is the average
+// of the 2x2 pixels of level <n - 1> that it covers.
+//
+// Levels are only built when first asked for.  After invalidate(rect),
+// only the pixels covering <rect> are recomputed.
+//
+
+class kpImagePyramid
+{
+public:
+    // Marks <rect> of the base image as changed.
+    void invalidate(const QRect &rect);
+    // Marks the entire base image as changed (e.g. because it was replaced
+    // or resized).
+    void invalidate();
+
+    // Returns level <level> of <base>, building or updating it and the
+    // levels below it first if necessary.  <base> must be the image that
+    // all calls to invalidate() have described.
+    //
+    // The returned image is in QImage::Format_ARGB32_Premultiplied,
+    // unless <level> is 0 (which just returns <base>).
+    kpImage level(const kpImage &base, int level);
+    // Same for a tiled <base>, except that the levels in between are not
+    // kept, as they might not fit in memory.  <level> is computed from the
+    // tiles directly, one tile at a time (or level 8 is, for deeper
+    // levels), so the full resolution image is never put together unless
+    // <level> is 0.
+    kpImage level(const kpTiledImage &base, int level);
+    // Same as level(<base>, <level>).copy(<levelRect>), except that a level
+    // too big to keep in memory is not built - <levelRect> of it is
+    // computed from the tiles each time instead.
+    kpImage levelAt(const kpTiledImage &base, int level, const QRect &levelRect);
+
+    // Returns the size of level <level> of an image of size <baseSize>.
+    static QSize levelSize(const QSize &baseSize, int level);
+
+    // Returns the smallest level that is still at least <scale> times the
+    // size of the base image (0 if <scale> >= 1).
+    static int levelForScale(double scale);
+
+private:
+    // Invalidates everything if the base image is not <baseSize>.
+    void setBaseSize(const QSize &baseSize);
+    // Makes sure that level <level> exists, marking all of it as out of
+    // date if it is new.
+    void allocateLevel(int level);
+
+    QSize m_baseSize;
+    // m_levels[i] is level i + 1, or null if it has not been built.
+    QList<kpImage> m_levels;
+    // m_dirtyRects[i] is the part of m_levels[i] that is out of date,
+    // in that level's coordinates.
+    QList<QRect> m_dirtyRects;
+};
+
+#endif // kpImagePyramid_H
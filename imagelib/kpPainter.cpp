@@ -13,6 +13,7 @@
 #include "tools/flow/kpToolFlowBase.h"
 #include "tools/kpTool.h"
 
+#include <algorithm>
 #include <cstdio>
 
 #include <QPainter>
@@ -46,195 +47,173 @@ QList<QPoint> kpPainter::interpolatePoints(const QPoint &startPoint, const QPoin
     const int probabilityTimes1000 = qRound(probability * 1000);
 #define SHOULD_DRAW() ((probabilityTimes1000 == 1000) /*avoid QRandomGenerator call*/ || (QRandomGenerator::global()->bounded(1000) < probabilityTimes1000))
 
-    // Derived from the zSprite2 Graphics Engine.
-    // "MODIFIED" comment shows deviation from zSprite2 and Bresenham's line
-    // algorithm.
-
-    const int x1 = startPoint.x(), y1 = startPoint.y(), x2 = endPoint.x(), y2 = endPoint.y();
-
-    // Difference of x and y values
-    const int dx = x2 - x1;
-    const int dy = y2 - y1;
-
-    // Absolute values of differences
-    const int ix = qAbs(dx);
-    const int iy = qAbs(dy);
+    kpPainter::forEachInterpolatedPoint(startPoint, endPoint, cardinalAdjacency, [&](const QPoint &p) {
+        if (SHOULD_DRAW()) {
+            ret.append(p);
+        }
+    });
 
-    // Larger of the x and y differences
-    const int inc = ix > iy ? ix : iy;
+#undef SHOULD_DRAW
 
-    // Plot location
-    int plotx = x1;
-    int ploty = y1;
+    return ret;
+}
 
-    int x = 0;
-    int y = 0;
+//---------------------------------------------------------------------
 
-    if (SHOULD_DRAW()) {
-        ret.append(QPoint(plotx, ploty));
-    }
+// public static
+void kpPainter::fillRect(kpImage *image, int x, int y, int width, int height, const kpColor &color)
+{
+    kpPixmapFX::fillRect(image, x, y, width, height, color);
+}
 
-    for (int i = 0; i <= inc; i++) {
-        // oldplotx is equally as valid but would look different
-        // (but nobody will notice which one it is)
-        const int oldploty = ploty;
-        int plot = 0;
+//---------------------------------------------------------------------
 
-        x += ix;
-        y += iy;
+struct WashPack {
+    QPoint startPoint, endPoint;
+    kpColor color;
+    int penWidth{}, penHeight{};
+    kpColor colorToReplace;
+    int processedColorSimilarity{};
 
-        if (x > inc) {
-            plot++;
-            x -= inc;
+    // <colorToReplace>, unpacked for WashPixelIsSimilar().
+    bool colorToReplaceIsValid{};
+    QRgb colorToReplaceRgba{};
 
-            if (dx < 0) {
-                plotx--;
-            } else {
-                plotx++;
-            }
-        }
+    kpImage *image{};
 
-        if (y > inc) {
-            plot++;
-            y -= inc;
+    // The pixels that are compared with <colorToReplace>, which cover
+    // <readableImageRect> of <image>.  This is <image> itself if the wash
+    // is done in place (see Wash()), otherwise it is a copy whose top-left
+    // pixel is at <readableImageOrigin> in <image>.
+    QRect readableImageRect;
+    const QImage *readableImage{};
+    QPoint readableImageOrigin;
+    QImage readableImageCopy;
 
-            if (dy < 0) {
-                ploty--;
-            } else {
-                ploty++;
-            }
-        }
+    // Only active if the wash is not done in place.
+    QPainter painter;
+};
 
-        if (plot) {
-            if (cardinalAdjacency && plot == 2) {
-                // MODIFIED: Every point is
-                // horizontally or vertically adjacent to another point (if there
-                // is more than 1 point, of course).  This is in contrast to the
-                // ordinary line algorithm which can create diagonal adjacencies.
+//---------------------------------------------------------------------
 
-                if (SHOULD_DRAW()) {
-                    ret.append(QPoint(plotx, oldploty));
-                }
-            }
+// Returns whether <rgba>, a pixel exactly as stored in the image (as
+// QImage::pixel() returns it, so premultiplied for
+// Format_ARGB32_Premultiplied), is similar to <pack->colorToReplace> -
+// exactly as kpColor::isSimilarTo() decides for
+// kpPixmapFX::getColorAtPixel() but without constructing a kpColor.
+static inline bool WashPixelIsSimilar(QRgb rgba, const WashPack *pack)
+{
+    if (!pack->colorToReplaceIsValid) {
+        return false;
+    }
 
-            if (SHOULD_DRAW()) {
-                ret.append(QPoint(plotx, ploty));
-            }
-        }
+    const QRgb colorToReplace = pack->colorToReplaceRgba;
+    if (rgba == colorToReplace) {
+        return true;
     }
 
-#undef SHOULD_DRAW
+    if (pack->processedColorSimilarity == kpColor::Exact) {
+        return false;
+    }
 
-    return ret;
+    const int dr = qRed(rgba) - qRed(colorToReplace);
+    const int dg = qGreen(rgba) - qGreen(colorToReplace);
+    const int db = qBlue(rgba) - qBlue(colorToReplace);
+    return (dr * dr + dg * dg + db * db <= pack->processedColorSimilarity);
 }
 
 //---------------------------------------------------------------------
 
-// public static
-void kpPainter::fillRect(kpImage *image, int x, int y, int width, int height, const kpColor &color)
+// Replaces the run of pixels (x1, y) to (x2, y) of <pack->image> with
+// <pack->color>.
+static void WashFillRun(WashPack *pack, int y, int x1, int x2)
 {
-    kpPixmapFX::fillRect(image, x, y, width, height, color);
+    if (pack->painter.isActive()) {
+        if (x1 == x2) {
+            pack->painter.drawPoint(x1, y);
+        } else {
+            pack->painter.drawLine(x1, y, x2, y);
+        }
+        return;
+    }
+
+    QRgb *pixels = reinterpret_cast<QRgb *>(pack->image->scanLine(y));
+    std::fill(pixels + x1, pixels + x2 + 1, pack->color.toQRgb());
 }
 
 //---------------------------------------------------------------------
 
-// <rgbPainter> are operating on the original image
-// (the original image is not passed to this function).
+// Washes the pixels of <drawRect>, in document coordinates, that are
+// similar to <pack->colorToReplace>.  Each row is scanned for runs of
+// similar pixels, which are then filled in one go.
 //
-// <image> = subset of the original image containing all the pixels in
-//           <imageRect>
-// <drawRect> = the rectangle, relative to the painters, whose pixels we
-//              want to change
-static bool ReadableImageWashRect(QPainter *rgbPainter,
-                                  const QImage &image,
-                                  const kpColor &colorToReplace,
-                                  const QRect &imageRect,
-                                  const QRect &drawRect,
-                                  int processedColorSimilarity)
+// Returns whether any pixels were washed.
+static bool WashRect(WashPack *pack, const QRect &drawRect)
 {
     bool didSomething = false;
 
 #if DEBUG_KP_PAINTER && 0
-    qCDebug(kpLogImagelib) << "kppixmapfx.cpp:WashRect(imageRect=" << imageRect << ",drawRect=" << drawRect << ")" << endl;
+    qCDebug(kpLogImagelib) << "kppixmapfx.cpp:WashRect(readableImageRect=" << pack->readableImageRect << ",drawRect=" << drawRect << ")" << endl;
 #endif
 
-    // If you're going to pass painter pointers, those painters had better be
-    // active (i.e. QPainter::begin() has been called).
-    Q_ASSERT(!rgbPainter || rgbPainter->isActive());
-
-// make use of scanline coherence
-#define FLUSH_LINE()                                                                                                                                           \
-    {                                                                                                                                                          \
-        if (rgbPainter) {                                                                                                                                      \
-            if (startDrawX == x - 1)                                                                                                                           \
-                rgbPainter->drawPoint(startDrawX + imageRect.x(), y + imageRect.y());                                                                          \
-            else                                                                                                                                               \
-                rgbPainter->drawLine(startDrawX + imageRect.x(), y + imageRect.y(), x - 1 + imageRect.x(), y + imageRect.y());                                 \
-        }                                                                                                                                                      \
-        didSomething = true;                                                                                                                                   \
-        startDrawX = -1;                                                                                                                                       \
+    // Pixels outside the image are never washed.
+    const QRect rect = drawRect & pack->readableImageRect & pack->image->rect();
+    if (rect.isEmpty()) {
+        return false;
     }
 
-    const int maxY = drawRect.bottom() - imageRect.top();
+    const QImage *image = pack->readableImage;
+    const QPoint offset = pack->readableImageOrigin;
+
+    const QImage::Format format = image->format();
+    const bool canReadScanLines = (format == QImage::Format_ARGB32_Premultiplied || format == QImage::Format_ARGB32 || format == QImage::Format_RGB32);
 
-    const int minX = drawRect.left() - imageRect.left();
-    const int maxX = drawRect.right() - imageRect.left();
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        const QRgb *pixels = canReadScanLines ? reinterpret_cast<const QRgb *>(image->constScanLine(y - offset.y())) : nullptr;
+
+        // Neighboring pixels are often the same, so remember the last
+        // answer.
+        QRgb lastPixel = 0;
+        bool lastPixelIsSimilar = false, haveLastPixel = false;
 
-    for (int y = drawRect.top() - imageRect.top(); y <= maxY; y++) {
         int startDrawX = -1;
 
-        int x; // for FLUSH_LINE()
-        for (x = minX; x <= maxX; x++) {
-#if DEBUG_KP_PAINTER && 0
-            fprintf(stderr,
-                    "y=%i x=%i colorAtPixel=%08X colorToReplace=%08X ... ",
-                    y,
-                    x,
-                    kpPixmapFX::getColorAtPixel(image, QPoint(x, y)).toQRgb(),
-                    colorToReplace.toQRgb());
-#endif
-            if (kpPixmapFX::getColorAtPixel(image, QPoint(x, y)).isSimilarTo(colorToReplace, processedColorSimilarity)) {
-#if DEBUG_KP_PAINTER && 0
-                fprintf(stderr, "similar\n");
-#endif
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            QRgb pixel;
+            if (pixels) {
+                pixel = pixels[x - offset.x()];
+            } else {
+                pixel = image->pixel(x - offset.x(), y - offset.y());
+            }
+
+            if (!haveLastPixel || pixel != lastPixel) {
+                lastPixel = pixel;
+                lastPixelIsSimilar = ::WashPixelIsSimilar(pixel, pack);
+                haveLastPixel = true;
+            }
+
+            if (lastPixelIsSimilar) {
                 if (startDrawX < 0) {
                     startDrawX = x;
                 }
-            } else {
-#if DEBUG_KP_PAINTER && 0
-                fprintf(stderr, "different\n");
-#endif
-                if (startDrawX >= 0) {
-                    FLUSH_LINE();
-                }
+            } else if (startDrawX >= 0) {
+                ::WashFillRun(pack, y, startDrawX, x - 1);
+                didSomething = true;
+                startDrawX = -1;
             }
         }
 
         if (startDrawX >= 0) {
-            FLUSH_LINE();
+            ::WashFillRun(pack, y, startDrawX, rect.right());
+            didSomething = true;
         }
     }
 
-#undef FLUSH_LINE
-
     return didSomething;
 }
 
 //---------------------------------------------------------------------
 
-struct WashPack {
-    QPoint startPoint, endPoint;
-    kpColor color;
-    int penWidth{}, penHeight{};
-    kpColor colorToReplace;
-    int processedColorSimilarity{};
-
-    QRect readableImageRect;
-    QImage readableImage;
-};
-
-//---------------------------------------------------------------------
-
 static QRect Wash(kpImage *image,
                   const QPoint &startPoint,
                   const QPoint &endPoint,
@@ -243,7 +222,7 @@ static QRect Wash(kpImage *image,
                   int penHeight,
                   const kpColor &colorToReplace,
                   int processedColorSimilarity,
-                  QRect (*drawFunc)(QPainter * /*rgbPainter*/, void * /*data*/))
+                  QRect (*drawFunc)(WashPack * /*pack*/))
 {
     WashPack pack;
     pack.startPoint = startPoint;
@@ -253,35 +232,44 @@ static QRect Wash(kpImage *image,
     pack.penHeight = penHeight;
     pack.colorToReplace = colorToReplace;
     pack.processedColorSimilarity = processedColorSimilarity;
+    pack.colorToReplaceIsValid = colorToReplace.isValid();
+    pack.colorToReplaceRgba = pack.colorToReplaceIsValid ? colorToReplace.toQRgb() : 0;
+    pack.image = image;
 
-    // Get the rectangle that bounds the changes and the pixmap for that
-    // rectangle.
+    // Get the rectangle that bounds the changes.
     const QRect normalizedRect = kpPainter::normalizedRect(pack.startPoint, pack.endPoint);
     pack.readableImageRect = kpTool::neededRect(normalizedRect, qMax(pack.penWidth, pack.penHeight));
 #if DEBUG_KP_PAINTER
     qCDebug(kpLogImagelib) << "kppainter.cpp:Wash() startPoint=" << startPoint << " endPoint=" << endPoint << " --> normalizedRect=" << normalizedRect
                            << " readableImageRect=" << pack.readableImageRect << endl;
 #endif
-    pack.readableImage = kpPixmapFX::getPixmapAt(*image, pack.readableImageRect);
-
-    QPainter painter(image);
-    return (*drawFunc)(&painter, &pack);
-}
-
-//---------------------------------------------------------------------
 
-void WashHelperSetup(QPainter *rgbPainter, const WashPack *pack)
-{
-    // Set the drawing colors for the painters.
-
-    if (rgbPainter) {
-        rgbPainter->setPen(pack->color.toQColor());
+    // An opaque color is simply written over the pixels it washes.  Washing
+    // a pixel again then writes the same color, so reading the pixels
+    // being washed gives the same result as reading the original pixels
+    // and no copy is needed.
+    //
+    // Otherwise, the color is drawn by QPainter and may blend with the
+    // pixels, so washing must only read the original pixels.
+    const bool inPlace = (image->format() == QImage::Format_ARGB32_Premultiplied && color.isValid() && qAlpha(color.toQRgb()) == 255);
+    if (inPlace) {
+        pack.readableImageRect = pack.readableImageRect & image->rect();
+        pack.readableImage = image;
+    } else {
+        pack.readableImageCopy = kpPixmapFX::getPixmapAt(*image, pack.readableImageRect);
+        pack.readableImage = &pack.readableImageCopy;
+        pack.readableImageOrigin = pack.readableImageRect.topLeft();
+
+        pack.painter.begin(image);
+        pack.painter.setPen(pack.color.toQColor());
     }
+
+    return (*drawFunc)(&pack);
 }
 
 //---------------------------------------------------------------------
 
-static QRect WashLineHelper(QPainter *rgbPainter, void *data)
+static QRect WashLineHelper(WashPack *pack)
 {
 #if DEBUG_KP_PAINTER && 0
     qCDebug(kpLogImagelib) << "Washing pixmap (w=" << rect.width() << ",h=" << rect.height() << ")" << endl;
@@ -289,30 +277,19 @@ static QRect WashLineHelper(QPainter *rgbPainter, void *data)
     int convAndWashTime;
 #endif
 
-    auto *pack = static_cast<WashPack *>(data);
-
-    // Setup painters.
-    ::WashHelperSetup(rgbPainter, pack);
-
     bool didSomething = false;
 
-    const QList<QPoint> points = kpPainter::interpolatePoints(pack->startPoint, pack->endPoint);
-    for (const QPoint &p : points) {
+    kpPainter::forEachInterpolatedPoint(pack->startPoint, pack->endPoint, false /*no cardinal adjacency*/, [&](const QPoint &p) {
         // OPT: This may be reading and possibly writing pixels that were
         //      visited on a previous iteration, since the pen is usually
         //      bigger than 1 pixel.  Maybe we could use QRegion to determine
         //      all the non-intersecting regions and only wash each region once.
         //
         //      Profiling needs to be done as QRegion is known to be a CPU hog.
-        if (::ReadableImageWashRect(rgbPainter,
-                                    pack->readableImage,
-                                    pack->colorToReplace,
-                                    pack->readableImageRect,
-                                    kpToolFlowBase::hotRectForMousePointAndBrushWidthHeight(p, pack->penWidth, pack->penHeight),
-                                    pack->processedColorSimilarity)) {
+        if (::WashRect(pack, kpToolFlowBase::hotRectForMousePointAndBrushWidthHeight(p, pack->penWidth, pack->penHeight))) {
             didSomething = true;
         }
-    }
+    });
 
 #if DEBUG_KP_PAINTER && 0
     int ms = timer.restart();
@@ -345,23 +322,19 @@ QRect kpPainter::washLine(kpImage *image,
 
 //---------------------------------------------------------------------
 
-static QRect WashRectHelper(QPainter *rgbPainter, void *data)
+static QRect WashRectHelper(WashPack *pack)
 {
-    auto *pack = static_cast<WashPack *>(data);
 #if DEBUG_KP_PAINTER && 0
     qCDebug(kpLogImagelib) << "Washing pixmap (w=" << rect.width() << ",h=" << rect.height() << ")" << endl;
     QTime timer;
     int convAndWashTime;
 #endif
 
-    // Setup painters.
-    ::WashHelperSetup(rgbPainter, pack);
-
     const QRect drawRect(pack->startPoint, pack->endPoint);
 
     bool didSomething = false;
 
-    if (::ReadableImageWashRect(rgbPainter, pack->readableImage, pack->colorToReplace, pack->readableImageRect, drawRect, pack->processedColorSimilarity)) {
+    if (::WashRect(pack, drawRect)) {
         didSomething = true;
     }
 
@@ -400,6 +373,48 @@ QRect kpPainter::washRect(kpImage *image,
 
 //---------------------------------------------------------------------
 
+// Returns the next number from a xorshift generator that is seeded once
+// per thread.  This is much cheaper than QRandomGenerator::global(), which
+// is plenty for deciding where spray paint lands.
+static quint32 SprayRandom()
+{
+    thread_local quint32 state = QRandomGenerator::global()->generate() | 1 /*must not be 0*/;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Returns the offsets of the <spraycanSize> x <spraycanSize> square that
+// are within the circle of the spray.  A dot is sprayed at a random
+// element of the square, which only lands if it is one of these.
+static const QList<QPoint> &SprayOffsets(int spraycanSize)
+{
+    thread_local int tableSpraycanSize = 0;
+    thread_local QList<QPoint> table;
+
+    if (spraycanSize != tableSpraycanSize) {
+        const int radius = spraycanSize / 2;
+
+        table.clear();
+        for (int dy = -radius; dy < spraycanSize - radius; dy++) {
+            for (int dx = -radius; dx < spraycanSize - radius; dx++) {
+                // Make it look circular.
+                // TODO: Can be done better by doing a random vector angle & length
+                //       but would sin and cos be too slow?
+                if ((dx * dx) + (dy * dy) <= (radius * radius)) {
+                    table.append(QPoint(dx, dy));
+                }
+            }
+        }
+
+        tableSpraycanSize = spraycanSize;
+    }
+
+    return table;
+}
+
 // public static
 void kpPainter::sprayPoints(kpImage *image, const QList<QPoint> &points, const kpColor &color, int spraycanSize)
 {
@@ -409,28 +424,40 @@ void kpPainter::sprayPoints(kpImage *image, const QList<QPoint> &points, const k
 
     Q_ASSERT(spraycanSize > 0);
 
-    QPainter painter(image);
-    const int radius = spraycanSize / 2;
+    const QList<QPoint> &offsets = ::SprayOffsets(spraycanSize);
+    const quint32 squareArea = spraycanSize * spraycanSize;
 
-    // Set the drawing colors for the painters.
+    // Opaque dots on the usual document format are written straight into
+    // the scanlines.  Anything else is left to QPainter, whose blending
+    // rules are then kept.
+    const bool writePixels = (image->format() == QImage::Format_ARGB32_Premultiplied && color.isValid() && qAlpha(color.toQRgb()) == 255);
 
-    painter.setPen(color.toQColor());
+    QPainter painter;
+    if (!writePixels) {
+        painter.begin(image);
+        painter.setPen(color.toQColor());
+    }
+
+    const QRgb rgb = writePixels ? color.toQRgb() : 0;
+    const int width = image->width(), height = image->height();
 
     for (const auto &p : points) {
         for (int i = 0; i < 10; i++) {
-            const int dx = (QRandomGenerator::global()->generate() % spraycanSize) - radius;
-            const int dy = (QRandomGenerator::global()->generate() % spraycanSize) - radius;
-
-            // Make it look circular.
-            // TODO: Can be done better by doing a random vector angle & length
-            //       but would sin and cos be too slow?
-            if ((dx * dx) + (dy * dy) > (radius * radius)) {
+            // Pick one of the <squareArea> positions without a division.
+            const quint32 index = quint32((quint64(::SprayRandom()) * squareArea) >> 32);
+            if (index >= quint32(offsets.size())) {
                 continue;
             }
 
-            const QPoint p2(p.x() + dx, p.y() + dy);
+            const QPoint p2 = p + offsets[index];
 
-            painter.drawPoint(p2);
+            if (writePixels) {
+                if (p2.x() >= 0 && p2.x() < width && p2.y() >= 0 && p2.y() < height) {
+                    reinterpret_cast<QRgb *>(image->scanLine(p2.y()))[p2.x()] = rgb;
+                }
+            } else {
+                painter.drawPoint(p2);
+            }
         }
     }
 }
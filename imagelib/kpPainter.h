@@ -66,8 +66,24 @@ public:
     // a point at 'c'.
     //
     // ASSUMPTION: <probability> is between 0.0 and 1.0 inclusive.
+    //
+    // This allocates the returned list - see forEachInterpolatedPoint() for
+    // code that is run on every mouse move.
     static QList<QPoint> interpolatePoints(const QPoint &startPoint, const QPoint &endPoint, bool cardinalAdjacency = false, double probability = 1.0);
 
+    // Calls <visit>(const QPoint &) for each point, in order, that
+    // interpolatePoints() would return for a <probability> of 1.0, without
+    // allocating any memory.
+    template<typename Visitor>
+    static void forEachInterpolatedPoint(const QPoint &startPoint, const QPoint &endPoint, bool cardinalAdjacency, Visitor &&visit);
+
+    // Like forEachInterpolatedPoint() but calls <visit>(int y, int x1, int x2)
+    // once for each horizontal run of consecutive points, where x1 <= x2.
+    // For instance, a brush stamped at every point of a run covers the
+    // rectangle spanned by the stamps at (x1, y) and (x2, y).
+    template<typename Visitor>
+    static void forEachInterpolatedRun(const QPoint &startPoint, const QPoint &endPoint, bool cardinalAdjacency, Visitor &&visit);
+
     static void fillRect(kpImage *image, int x, int y, int width, int height, const kpColor &color);
 
     // Replaces all pixels of <colorToReplace> on the line
@@ -101,4 +117,108 @@ public:
     static void sprayPoints(kpImage *image, const QList<QPoint> &points, const kpColor &color, int spraycanSize);
 };
 
+//---------------------------------------------------------------------
+
+// public static
+template<typename Visitor>
+void kpPainter::forEachInterpolatedPoint(const QPoint &startPoint, const QPoint &endPoint, bool cardinalAdjacency, Visitor &&visit)
+{
+    // Derived from the zSprite2 Graphics Engine.
+    // "MODIFIED" comment shows deviation from zSprite2 and Bresenham's line
+    // algorithm.
+
+    const int x1 = startPoint.x(), y1 = startPoint.y(), x2 = endPoint.x(), y2 = endPoint.y();
+
+    // Difference of x and y values
+    const int dx = x2 - x1;
+    const int dy = y2 - y1;
+
+    // Absolute values of differences
+    const int ix = qAbs(dx);
+    const int iy = qAbs(dy);
+
+    // Larger of the x and y differences
+    const int inc = ix > iy ? ix : iy;
+
+    // Plot location
+    int plotx = x1;
+    int ploty = y1;
+
+    int x = 0;
+    int y = 0;
+
+    visit(QPoint(plotx, ploty));
+
+    for (int i = 0; i <= inc; i++) {
+        // oldplotx is equally as valid but would look different
+        // (but nobody will notice which one it is)
+        const int oldploty = ploty;
+        int plot = 0;
+
+        x += ix;
+        y += iy;
+
+        if (x > inc) {
+            plot++;
+            x -= inc;
+
+            if (dx < 0) {
+                plotx--;
+            } else {
+                plotx++;
+            }
+        }
+
+        if (y > inc) {
+            plot++;
+            y -= inc;
+
+            if (dy < 0) {
+                ploty--;
+            } else {
+                ploty++;
+            }
+        }
+
+        if (plot) {
+            if (cardinalAdjacency && plot == 2) {
+                // MODIFIED: Every point is
+                // horizontally or vertically adjacent to another point (if there
+                // is more than 1 point, of course).  This is in contrast to the
+                // ordinary line algorithm which can create diagonal adjacencies.
+
+                visit(QPoint(plotx, oldploty));
+            }
+
+            visit(QPoint(plotx, ploty));
+        }
+    }
+}
+
+// public static
+template<typename Visitor>
+void kpPainter::forEachInterpolatedRun(const QPoint &startPoint, const QPoint &endPoint, bool cardinalAdjacency, Visitor &&visit)
+{
+    // The points of a line only move in one x direction so a run is
+    // extended from whichever end is adjacent to the next point.
+    int runY = startPoint.y(), runX1 = startPoint.x(), runX2 = startPoint.x();
+
+    forEachInterpolatedPoint(startPoint, endPoint, cardinalAdjacency, [&](const QPoint &p) {
+        if (p.y() == runY && p.x() >= runX1 - 1 && p.x() <= runX2 + 1) {
+            runX1 = qMin(runX1, p.x());
+            runX2 = qMax(runX2, p.x());
+            return;
+        }
+
+        visit(runY, runX1, runX2);
+
+        runY = p.y();
+        runX1 = runX2 = p.x();
+    });
+
+    visit(runY, runX1, runX2);
+}
+
+//---------------------------------------------------------------------
+
 #endif // KP_PAINTER_H
@@ -0,0 +1,482 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_PNG_WRITER 0
+
+#include "imagelib/kpPngWriter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <QByteArray>
+#include <QColorSpace>
+#include <QIODevice>
+#include <QImage>
+#include <QList>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "kpLogCategories.h"
+
+#if HAVE_ZLIB
+
+//---------------------------------------------------------------------
+
+// Rows are filtered and compressed in chunks of at least this many bytes.
+static const int ChunkBytes = 256 * 1024;
+
+// Smaller images are left to QImage::save().
+static const qint64 MinPixels = 1024 * 1024;
+
+// The deflate window size.
+static const int DictionaryBytes = 32768;
+
+namespace
+{
+struct Chunk {
+    int firstRow = 0, endRow = 0;
+
+    QByteArray filtered;
+    uLong adler = 0;
+
+    QByteArray compressed;
+    bool ok = true;
+};
+
+// Filter types (PNG specification 9.2).
+enum {
+    FilterNone,
+    FilterSub,
+    FilterUp,
+    FilterAverage,
+    FilterPaeth,
+    FilterCount
+};
+}
+
+//---------------------------------------------------------------------
+
+static void AppendUInt32(QByteArray *data, quint32 value)
+{
+    data->append(static_cast<char>(value >> 24));
+    data->append(static_cast<char>(value >> 16));
+    data->append(static_cast<char>(value >> 8));
+    data->append(static_cast<char>(value));
+}
+
+//---------------------------------------------------------------------
+
+// Writes a PNG chunk of type <type> containing <data>.
+static bool WritePngChunk(QIODevice *device, const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    chunk.reserve(12 + data.size());
+
+    AppendUInt32(&chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+
+    // (the CRC covers the type and data)
+    const uLong crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef *>(chunk.constData() + 4), static_cast<uInt>(4 + data.size()));
+    AppendUInt32(&chunk, static_cast<quint32>(crc));
+
+    return device->write(chunk) == chunk.size();
+}
+
+//---------------------------------------------------------------------
+
+// Converts row <y> of <image> (Format_ARGB32 or Format_RGB32) to PNG
+// samples with <channels> bytes per pixel.
+static void RowToSamples(const QImage &image, int y, int channels, uchar *samples)
+{
+    const auto *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+
+    for (int x = 0; x < image.width(); x++) {
+        const QRgb pixel = pixels[x];
+
+        *samples++ = static_cast<uchar>(qRed(pixel));
+        *samples++ = static_cast<uchar>(qGreen(pixel));
+        *samples++ = static_cast<uchar>(qBlue(pixel));
+        if (channels == 4) {
+            *samples++ = static_cast<uchar>(qAlpha(pixel));
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+static inline int Paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    if (pb <= pc) {
+        return b;
+    }
+    return c;
+}
+
+//---------------------------------------------------------------------
+
+// Filters <row> with <filter>, given the previous row <prev>, into <out>.
+// Returns the sum of the absolute values of <out> as signed bytes, which
+// is the heuristic libpng uses to choose between filters.
+static quint64 FilterRow(int filter, const uchar *row, const uchar *prev, int rowBytes, int bpp, uchar *out)
+{
+    quint64 sum = 0;
+
+    for (int i = 0; i < rowBytes; i++) {
+        const int a = (i >= bpp) ? row[i - bpp] : 0;
+        const int b = prev[i];
+        const int c = (i >= bpp) ? prev[i - bpp] : 0;
+
+        int predictor = 0;
+        switch (filter) {
+        case FilterSub:
+            predictor = a;
+            break;
+        case FilterUp:
+            predictor = b;
+            break;
+        case FilterAverage:
+            predictor = (a + b) / 2;
+            break;
+        case FilterPaeth:
+            predictor = Paeth(a, b, c);
+            break;
+        }
+
+        const auto value = static_cast<uchar>(row[i] - predictor);
+        out[i] = value;
+        sum += static_cast<quint64>(std::abs(static_cast<int>(static_cast<signed char>(value))));
+    }
+
+    return sum;
+}
+
+//---------------------------------------------------------------------
+
+// Fills in <chunk>'s filtered rows and their Adler-32 checksum.
+static void FilterChunk(Chunk *chunk, const QImage &image, int channels)
+{
+    const int rowBytes = image.width() * channels;
+
+    chunk->filtered.resize(static_cast<qsizetype>(chunk->endRow - chunk->firstRow) * (1 + rowBytes));
+    auto *out = reinterpret_cast<uchar *>(chunk->filtered.data());
+
+    // The row above the chunk is needed for the Up, Average and Paeth
+    // filters of the chunk's first row.
+    std::vector<uchar> prev(rowBytes, 0), row(rowBytes);
+    if (chunk->firstRow > 0) {
+        RowToSamples(image, chunk->firstRow - 1, channels, prev.data());
+    }
+
+    std::vector<uchar> trial(rowBytes);
+
+    for (int y = chunk->firstRow; y < chunk->endRow; y++) {
+        RowToSamples(image, y, channels, row.data());
+
+        uchar *filterTypeOut = out++;
+
+        quint64 bestSum = 0;
+        for (int filter = FilterNone; filter < FilterCount; filter++) {
+            const quint64 sum = FilterRow(filter, row.data(), prev.data(), rowBytes, channels, trial.data());
+            if (filter == FilterNone || sum < bestSum) {
+                bestSum = sum;
+                *filterTypeOut = static_cast<uchar>(filter);
+                std::copy(trial.begin(), trial.end(), out);
+            }
+        }
+
+        out += rowBytes;
+        std::swap(prev, row);
+    }
+
+    chunk->adler = adler32(adler32(0, nullptr, 0), reinterpret_cast<const Bytef *>(chunk->filtered.constData()), static_cast<uInt>(chunk->filtered.size()));
+}
+
+//---------------------------------------------------------------------
+
+// Fills in <chunk>'s raw deflate output.  <previous> is the previous
+// chunk's filtered data (if any) to prime the compressor with.  If not
+// <isLast>, the output ends with a sync flush rather than a final block.
+static void DeflateChunk(Chunk *chunk, const QByteArray *previous, int level, bool isLast)
+{
+    z_stream stream{};
+
+    // (negative window bits: no zlib header or trailer)
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_FILTERED) != Z_OK) {
+        chunk->ok = false;
+        return;
+    }
+
+    if (previous && !previous->isEmpty()) {
+        const int dictionarySize = static_cast<int>(std::min<qsizetype>(previous->size(), DictionaryBytes));
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(previous->constData() + previous->size() - dictionarySize), static_cast<uInt>(dictionarySize));
+    }
+
+    stream.next_in = reinterpret_cast<Bytef *>(chunk->filtered.data());
+    stream.avail_in = static_cast<uInt>(chunk->filtered.size());
+
+    // (+ room for the sync flush's empty stored block)
+    chunk->compressed.resize(static_cast<qsizetype>(deflateBound(&stream, stream.avail_in)) + 16);
+
+    const int flush = isLast ? Z_FINISH : Z_SYNC_FLUSH;
+    for (;;) {
+        stream.next_out = reinterpret_cast<Bytef *>(chunk->compressed.data()) + stream.total_out;
+        stream.avail_out = static_cast<uInt>(chunk->compressed.size() - static_cast<qsizetype>(stream.total_out));
+
+        const int ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR) {
+            chunk->ok = false;
+            break;
+        }
+
+        const bool done = isLast ? (ret == Z_STREAM_END) : (stream.avail_out > 0);
+        if (done) {
+            break;
+        }
+
+        chunk->compressed.resize(chunk->compressed.size() * 2);
+    }
+
+    chunk->compressed.resize(static_cast<qsizetype>(stream.total_out));
+    deflateEnd(&stream);
+}
+
+//---------------------------------------------------------------------
+
+// Returns the second byte of the zlib header, which must agree with
+// <level> (RFC 1950).
+static char ZlibHeaderFlags(int level)
+{
+    if (level <= 1) {
+        return '\x01';
+    }
+    if (level <= 5) {
+        return '\x5e';
+    }
+    if (level == 6) {
+        return '\x9c';
+    }
+    return '\xda';
+}
+
+//---------------------------------------------------------------------
+
+static bool WriteTextChunks(QIODevice *device, const QImage &image)
+{
+    const QStringList keys = image.textKeys();
+    for (const QString &key : keys) {
+        // PNG keywords are 1-79 Latin-1 characters.
+        const QByteArray keyword = key.left(79).toLatin1();
+        if (keyword.isEmpty()) {
+            continue;
+        }
+
+        const QString text = image.text(key);
+        const QByteArray latin1Text = text.toLatin1();
+
+        QByteArray data = keyword;
+        data.append('\0');
+
+        if (QString::fromLatin1(latin1Text) == text) {
+            data.append(latin1Text);
+            if (!WritePngChunk(device, "tEXt", data)) {
+                return false;
+            }
+        } else {
+            // Uncompressed, no language tag, no translated keyword.
+            data.append('\0');
+            data.append('\0');
+            data.append('\0');
+            data.append('\0');
+            data.append(text.toUtf8());
+            if (!WritePngChunk(device, "iTXt", data)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif // HAVE_ZLIB
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPngWriter::isUsefulFor(const QImage &image)
+{
+#if HAVE_ZLIB
+    if (image.format() != QImage::Format_ARGB32_Premultiplied && image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_RGB32) {
+        return false;
+    }
+
+    // Other color spaces need an embedded ICC profile - leave it to Qt.
+    if (image.colorSpace().isValid() && image.colorSpace() != QColorSpace::SRgb) {
+        return false;
+    }
+
+    return static_cast<qint64>(image.width()) * image.height() >= MinPixels && QThreadPool::globalInstance()->maxThreadCount() > 1;
+#else
+    Q_UNUSED(image);
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPngWriter::write(const QImage &image, QIODevice *device, int quality)
+{
+#if HAVE_ZLIB
+#if DEBUG_KP_PNG_WRITER
+    qCDebug(kpLogImagelib) << "kpPngWriter::write(" << image.size() << ", quality=" << quality << ")";
+#endif
+
+    if (image.isNull()) {
+        return false;
+    }
+
+    // PNG stores unpremultiplied samples.
+    const int channels = image.hasAlphaChannel() ? 4 : 3;
+    const QImage source = image.convertToFormat(channels == 4 ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+    // Same mapping as QImage::save().
+    int level = Z_DEFAULT_COMPRESSION;
+    if (quality >= 0) {
+        level = (100 - qMin(quality, 100)) * 9 / 91;
+    }
+    const int headerLevel = (level == Z_DEFAULT_COMPRESSION) ? 6 : level;
+
+    //
+    // Filter and deflate
+    //
+
+    const int rowBytes = source.width() * channels;
+    const int rowsPerChunk = qMax(1, ChunkBytes / (1 + rowBytes));
+
+    QList<Chunk> chunks;
+    for (int y = 0; y < source.height(); y += rowsPerChunk) {
+        Chunk chunk;
+        chunk.firstRow = y;
+        chunk.endRow = qMin(y + rowsPerChunk, source.height());
+        chunks.append(chunk);
+    }
+
+    QList<int> chunkIndexes;
+    for (int i = 0; i < chunks.size(); i++) {
+        chunkIndexes.append(i);
+    }
+
+    // (so that the threads don't detach <chunks>)
+    Chunk *chunkData = chunks.data();
+    const int lastChunk = static_cast<int>(chunks.size()) - 1;
+
+    QtConcurrent::blockingMap(chunkIndexes, [&](int i) {
+        FilterChunk(&chunkData[i], source, channels);
+    });
+
+    // (each chunk needs the previous chunk's filtered data, so this cannot
+    //  be merged with the above)
+    QtConcurrent::blockingMap(chunkIndexes, [&](int i) {
+        DeflateChunk(&chunkData[i], i > 0 ? &chunkData[i - 1].filtered : nullptr, level, i == lastChunk);
+    });
+
+    //
+    // Write
+    //
+
+    static const char Signature[] = "\x89PNG\r\n\x1a\n";
+    if (device->write(Signature, 8) != 8) {
+        return false;
+    }
+
+    QByteArray header;
+    AppendUInt32(&header, static_cast<quint32>(source.width()));
+    AppendUInt32(&header, static_cast<quint32>(source.height()));
+    header.append('\x08'); // bit depth
+    header.append(channels == 4 ? '\x06' : '\x02'); // RGBA or RGB
+    header.append('\0'); // compression method
+    header.append('\0'); // filter method
+    header.append('\0'); // no interlacing
+    if (!WritePngChunk(device, "IHDR", header)) {
+        return false;
+    }
+
+    if (image.colorSpace().isValid()) {
+        // (only sRGB gets here - see isUsefulFor())
+        if (!WritePngChunk(device, "sRGB", QByteArray(1, '\0') /*perceptual*/)) {
+            return false;
+        }
+    }
+
+    if (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) {
+        QByteArray physical;
+        AppendUInt32(&physical, static_cast<quint32>(image.dotsPerMeterX()));
+        AppendUInt32(&physical, static_cast<quint32>(image.dotsPerMeterY()));
+        physical.append('\x01'); // meters
+        if (!WritePngChunk(device, "pHYs", physical)) {
+            return false;
+        }
+    }
+
+    if (!image.offset().isNull()) {
+        QByteArray offset;
+        AppendUInt32(&offset, static_cast<quint32>(image.offset().x()));
+        AppendUInt32(&offset, static_cast<quint32>(image.offset().y()));
+        offset.append('\0'); // pixels
+        if (!WritePngChunk(device, "oFFs", offset)) {
+            return false;
+        }
+    }
+
+    if (!WriteTextChunks(device, image)) {
+        return false;
+    }
+
+    uLong adler = adler32(0, nullptr, 0);
+    for (int i = 0; i <= lastChunk; i++) {
+        const Chunk &chunk = chunks.at(i);
+        if (!chunk.ok) {
+            return false;
+        }
+
+        adler = adler32_combine(adler, chunk.adler, static_cast<z_off_t>(chunk.filtered.size()));
+
+        QByteArray data;
+        if (i == 0) {
+            data.append('\x78');
+            data.append(ZlibHeaderFlags(headerLevel));
+        }
+        data.append(chunk.compressed);
+        if (i == lastChunk) {
+            AppendUInt32(&data, static_cast<quint32>(adler));
+        }
+
+        if (!WritePngChunk(device, "IDAT", data)) {
+            return false;
+        }
+    }
+
+    return WritePngChunk(device, "IEND", QByteArray());
+#else
+    Q_UNUSED(image);
+    Q_UNUSED(device);
+    Q_UNUSED(quality);
+    return false;
+#endif
+}
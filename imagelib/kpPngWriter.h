@@ -0,0 +1,39 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpPngWriter_H
+#define kpPngWriter_H
+
+class QImage;
+class QIODevice;
+
+//
+// PNG writer for large 32-bit images that filters and compresses the
+// image data on several threads.
+//
+// The rows are split into chunks that are filtered and then deflated
+// independently, each chunk being primed with the last 32KB of the
+// previous chunk.  All but the last chunk end with a sync flush, so their
+// outputs concatenate into a single valid zlib stream.
+//
+// This is only available if KolourPaint was built with zlib.
+//
+
+class kpPngWriter
+{
+public:
+    // Returns whether write() supports <image> and is expected to be faster
+    // than QImage::save() for it.
+    static bool isUsefulFor(const QImage &image);
+
+    // Writes <image> as an 8-bit RGBA PNG (or RGB, if it has no alpha
+    // channel) to <device>, including its text, dots per meter and offset.
+    // <quality> is interpreted as by QImage::save().
+    static bool write(const QImage &image, QIODevice *device, int quality = -1);
+};
+
+#endif // kpPngWriter_H
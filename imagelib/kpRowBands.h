@@ -0,0 +1,54 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpRowBands_H
+#define kpRowBands_H
+
+#include <QList>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+//
+// Splits the rows of an image operation into bands that are processed on
+// the global thread pool.
+//
+
+class kpRowBands
+{
+public:
+    // Calls <func>(firstRow, endRow) for consecutive bands of <bandSize> of
+    // the <rows> rows.  The bands are spread across threads only if the
+    // operation covers at least <minPixelsForThreads> <pixels>, since
+    // starting threads costs more than it saves for small images.
+    //
+    // <func> must be safe to call for different bands at the same time.
+    template<typename Func>
+    static void forEach(int rows, int bandSize, qint64 pixels, qint64 minPixelsForThreads, const Func &func);
+};
+
+//---------------------------------------------------------------------
+
+// public static
+template<typename Func>
+void kpRowBands::forEach(int rows, int bandSize, qint64 pixels, qint64 minPixelsForThreads, const Func &func)
+{
+    if (pixels < minPixelsForThreads || QThreadPool::globalInstance()->maxThreadCount() <= 1) {
+        func(0, rows);
+        return;
+    }
+
+    QList<int> bandStarts;
+    for (int y = 0; y < rows; y += bandSize) {
+        bandStarts.append(y);
+    }
+
+    QtConcurrent::blockingMap(bandStarts, [&func, rows, bandSize](int y) {
+        func(y, qMin(y + bandSize, rows));
+    });
+}
+
+#endif // kpRowBands_H
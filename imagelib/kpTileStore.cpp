@@ -0,0 +1,217 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_TILE_STORE 0
+
+#include "kpTileStore.h"
+
+#include "imagelib/kpTiledImage.h"
+
+#include <cstring>
+
+#include <QDir>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+#include "kpLogCategories.h"
+
+//---------------------------------------------------------------------
+
+// Every slot holds a full size tile, even for the smaller tiles at the
+// right and bottom edges, so that slots can be reused for any tile.
+// (This is a multiple of every page size, as QFile::map() needs.)
+static const qint64 SlotBytes = qint64(kpTiledImage::TileSize) * kpTiledImage::TileSize * 4;
+
+// The file grows by this many slots at a time.
+static const qint64 GrowSlots = 64;
+
+namespace
+{
+struct Mapping {
+    QSharedPointer<const kpStoredTile> tile;
+    uchar *address;
+};
+}
+
+//---------------------------------------------------------------------
+
+kpStoredTile::kpStoredTile(const QSharedPointer<kpTileStore> &store, qint64 slot, const QSize &size)
+    : m_store(store)
+    , m_slot(slot)
+    , m_size(size)
+{
+}
+
+//---------------------------------------------------------------------
+
+kpStoredTile::~kpStoredTile()
+{
+    m_store->release(m_slot);
+}
+
+//---------------------------------------------------------------------
+
+// public
+QSize kpStoredTile::size() const
+{
+    return m_size;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpStoredTile::image() const
+{
+    uchar *address = m_store->map(m_slot);
+    if (!address) {
+        // Probably out of address space.  Rather than crash, show
+        // the tile as transparent.
+        qCWarning(kpLogImagelib) << "kpStoredTile::image() could not map slot" << m_slot;
+        kpImage image(m_size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(0);
+        return image;
+    }
+
+    // (the const data makes the image copy itself before being written to)
+    return kpImage(const_cast<const uchar *>(address),
+                   m_size.width(),
+                   m_size.height(),
+                   m_size.width() * 4,
+                   QImage::Format_ARGB32_Premultiplied,
+                   &kpStoredTile::unmapImage,
+                   new Mapping{sharedFromThis(), address});
+}
+
+//---------------------------------------------------------------------
+
+// private static
+void kpStoredTile::unmapImage(void *info)
+{
+    auto *mapping = static_cast<Mapping *>(info);
+    mapping->tile->m_store->unmap(mapping->address);
+    // (may release the slot, if the tile is no longer used)
+    delete mapping;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QSharedPointer<kpTileStore> kpTileStore::create()
+{
+    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (dirPath.isEmpty() || !QDir().mkpath(dirPath)) {
+        qCWarning(kpLogImagelib) << "kpTileStore::create() could not create cache directory" << dirPath << "- using" << QDir::tempPath();
+        dirPath = QDir::tempPath();
+    }
+
+    QSharedPointer<kpTileStore> store(new kpTileStore(dirPath));
+    if (!store->m_file.open()) {
+        qCWarning(kpLogImagelib) << "kpTileStore::create() could not create" << store->m_file.fileTemplate() << ":" << store->m_file.errorString();
+        return {};
+    }
+
+#if DEBUG_KP_TILE_STORE
+    qCDebug(kpLogImagelib) << "kpTileStore::create() file=" << store->m_file.fileName();
+#endif
+
+    return store;
+}
+
+//---------------------------------------------------------------------
+
+kpTileStore::kpTileStore(const QString &dirPath)
+    : m_file(dirPath + QLatin1String("/kolourpaint-tiles-XXXXXX"))
+    , m_slotCount(0)
+{
+}
+
+//---------------------------------------------------------------------
+
+kpTileStore::~kpTileStore() = default;
+
+//---------------------------------------------------------------------
+
+// public
+QSharedPointer<kpStoredTile> kpTileStore::store(const kpImage &image)
+{
+    Q_ASSERT(image.format() == QImage::Format_ARGB32_Premultiplied);
+    Q_ASSERT(image.width() <= kpTiledImage::TileSize && image.height() <= kpTiledImage::TileSize);
+
+    qint64 slot;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_freeSlots.isEmpty()) {
+            if (!m_file.resize((m_slotCount + GrowSlots) * SlotBytes)) {
+                qCWarning(kpLogImagelib) << "kpTileStore::store() could not grow" << m_file.fileName() << ":" << m_file.errorString();
+                return {};
+            }
+
+#if DEBUG_KP_TILE_STORE
+            qCDebug(kpLogImagelib) << "kpTileStore::store() grew to" << m_slotCount + GrowSlots << "slots";
+#endif
+            for (qint64 i = m_slotCount + GrowSlots - 1; i >= m_slotCount; i--) {
+                m_freeSlots.append(i);
+            }
+            m_slotCount += GrowSlots;
+        }
+
+        slot = m_freeSlots.takeLast();
+    }
+
+    uchar *address = map(slot);
+    if (!address) {
+        release(slot);
+        return {};
+    }
+
+    const int bytesPerLine = image.width() * 4;
+    for (int y = 0; y < image.height(); y++) {
+        std::memcpy(address + y * bytesPerLine, image.constScanLine(y), bytesPerLine);
+    }
+    unmap(address);
+
+    return QSharedPointer<kpStoredTile>(new kpStoredTile(sharedFromThis(), slot, image.size()));
+}
+
+//---------------------------------------------------------------------
+
+// public
+qint64 kpTileStore::fileSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slotCount * SlotBytes;
+}
+
+//---------------------------------------------------------------------
+
+// private
+uchar *kpTileStore::map(qint64 slot)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.map(slot * SlotBytes, SlotBytes);
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTileStore::unmap(uchar *address)
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.unmap(address);
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTileStore::release(qint64 slot)
+{
+    QMutexLocker locker(&m_mutex);
+    m_freeSlots.append(slot);
+}
+
+//---------------------------------------------------------------------
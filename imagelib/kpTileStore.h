@@ -0,0 +1,102 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpTileStore_H
+#define kpTileStore_H
+
+#include <QEnableSharedFromThis>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QSize>
+#include <QTemporaryFile>
+
+#include "imagelib/kpImage.h"
+
+class kpTileStore;
+
+//
+// The pixels of one tile, written to a kpTileStore.  They never change,
+// so every copy of the tile shares them.  Their space in the scratch file
+// is reused once the last copy, and the last image() of it, is gone.
+//
+
+class kpStoredTile : public QEnableSharedFromThis<kpStoredTile>
+{
+public:
+    ~kpStoredTile();
+
+    kpStoredTile(const kpStoredTile &) = delete;
+    kpStoredTile &operator=(const kpStoredTile &) = delete;
+
+    QSize size() const;
+
+    // Maps the pixels into memory for as long as the returned image, or
+    // a copy of it, exists.  Writing to the image copies it into memory
+    // first, leaving the stored pixels as they are.
+    kpImage image() const;
+
+private:
+    friend class kpTileStore;
+    kpStoredTile(const QSharedPointer<kpTileStore> &store, qint64 slot, const QSize &size);
+
+    // The cleanup function of the images returned by image().  Each image
+    // keeps the tile alive, so the slot is not reused under it.
+    static void unmapImage(void *info);
+
+    QSharedPointer<kpTileStore> m_store;
+    qint64 m_slot;
+    QSize m_size;
+};
+
+//
+// A scratch file holding the pixels of kpTiledImage tiles, for images
+// that do not fit in memory.  Each tile takes up one fixed size slot,
+// which is mapped into memory only while it is being read, so the
+// operating system pages tiles in and out as needed.
+//
+// This can be used from any thread.
+//
+
+class kpTileStore : public QEnableSharedFromThis<kpTileStore>
+{
+public:
+    // Creates a store backed by a new file in the user's cache directory
+    // (QStandardPaths::CacheLocation) - rather than in QDir::tempPath(),
+    // which is often in memory - and deletes it with the store.  Returns
+    // null if the file cannot be created.
+    static QSharedPointer<kpTileStore> create();
+
+    ~kpTileStore();
+
+    kpTileStore(const kpTileStore &) = delete;
+    kpTileStore &operator=(const kpTileStore &) = delete;
+
+    // Writes <image>, which must be in QImage::Format_ARGB32_Premultiplied
+    // and no bigger than kpTiledImage::TileSize in either dimension, to a
+    // free slot.  Returns null if the file cannot grow (e.g. because the
+    // disk is full).
+    QSharedPointer<kpStoredTile> store(const kpImage &image);
+
+    // Returns the size of the scratch file in bytes.
+    qint64 fileSize() const;
+
+private:
+    friend class kpStoredTile;
+    explicit kpTileStore(const QString &dirPath);
+
+    uchar *map(qint64 slot);
+    void unmap(uchar *address);
+    void release(qint64 slot);
+
+    mutable QMutex m_mutex;
+    QTemporaryFile m_file;
+    qint64 m_slotCount;
+    QList<qint64> m_freeSlots;
+};
+
+#endif // kpTileStore_H
@@ -0,0 +1,457 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_TILED_IMAGE 0
+
+#include "kpTiledImage.h"
+
+#include "imagelib/kpTileStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "kpLogCategories.h"
+
+//---------------------------------------------------------------------
+
+// Returns whether every pixel of <rect> of <image> is the same and if
+// so, sets <pixel> to it.
+static bool IsSolid(const QImage &image, const QRect &rect, uint *pixel)
+{
+    const uint first = reinterpret_cast<const uint *>(image.constScanLine(rect.top()))[rect.left()];
+
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        const auto *line = reinterpret_cast<const uint *>(image.constScanLine(y)) + rect.left();
+        if (std::any_of(line, line + rect.width(), [first](uint p) {
+                return p != first;
+            })) {
+            return false;
+        }
+    }
+
+    *pixel = first;
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+static void FillRows(QImage *dest, const QRect &destRect, uint pixel)
+{
+    for (int y = destRect.top(); y <= destRect.bottom(); y++) {
+        auto *line = reinterpret_cast<uint *>(dest->scanLine(y)) + destRect.left();
+        std::fill(line, line + destRect.width(), pixel);
+    }
+}
+
+//---------------------------------------------------------------------
+
+static void CopyRows(const QImage &src, const QRect &srcRect, QImage *dest, const QPoint &destAt)
+{
+    for (int y = 0; y < srcRect.height(); y++) {
+        std::memcpy(reinterpret_cast<uint *>(dest->scanLine(destAt.y() + y)) + destAt.x(),
+                    reinterpret_cast<const uint *>(src.constScanLine(srcRect.top() + y)) + srcRect.left(),
+                    srcRect.width() * sizeof(uint));
+    }
+}
+
+//---------------------------------------------------------------------
+
+kpTiledImage::kpTiledImage()
+    : m_width(0)
+    , m_height(0)
+    , m_columns(0)
+    , m_rows(0)
+{
+}
+
+//---------------------------------------------------------------------
+
+kpTiledImage::kpTiledImage(int width, int height, uint pixel)
+    : m_width(qMax(0, width))
+    , m_height(qMax(0, height))
+    , m_columns((m_width + TileSize - 1) / TileSize)
+    , m_rows((m_height + TileSize - 1) / TileSize)
+{
+    Tile tile;
+    tile.color = pixel;
+    m_tiles.fill(tile, m_columns * m_rows);
+}
+
+//---------------------------------------------------------------------
+
+kpTiledImage::kpTiledImage(const kpImage &image)
+    : kpTiledImage(image.width(), image.height(), 0)
+{
+    setImageAt(image, QPoint(0, 0));
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpTiledImage::isNull() const
+{
+    return m_tiles.isEmpty();
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpTiledImage::isOutOfCore() const
+{
+    return !m_store.isNull();
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpTiledImage::setOutOfCore(bool yes)
+{
+    if (yes == isOutOfCore()) {
+        return true;
+    }
+
+    if (yes) {
+        m_store = kpTileStore::create();
+        if (!m_store) {
+            return false;
+        }
+    } else {
+        m_store.reset();
+    }
+
+#if DEBUG_KP_TILED_IMAGE
+    qCDebug(kpLogImagelib) << "kpTiledImage::setOutOfCore(" << yes << ") moving" << tileCount() - allocatedTileCount() << "tiles";
+#endif
+
+    for (Tile &tile : m_tiles) {
+        if (!isSolid(tile)) {
+            // (a deep copy, rather than a mapping of the scratch file)
+            setPixels(&tile, yes ? tile.image : pixels(tile).copy());
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// private static
+bool kpTiledImage::isSolid(const Tile &tile)
+{
+    return tile.image.isNull() && tile.stored.isNull();
+}
+
+//---------------------------------------------------------------------
+
+// private static
+kpImage kpTiledImage::pixels(const Tile &tile)
+{
+    return tile.stored ? tile.stored->image() : tile.image;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTiledImage::setPixels(Tile *tile, const kpImage &image) const
+{
+    if (m_store) {
+        tile->stored = m_store->store(image);
+        if (tile->stored) {
+            tile->image = kpImage();
+            return;
+        }
+
+        // Out of disk space - keep the tile in memory instead.
+    }
+
+    tile->stored.reset();
+    tile->image = image;
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTiledImage::width() const
+{
+    return m_width;
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTiledImage::height() const
+{
+    return m_height;
+}
+
+//---------------------------------------------------------------------
+
+// public
+QSize kpTiledImage::size() const
+{
+    return {m_width, m_height};
+}
+
+//---------------------------------------------------------------------
+
+// public
+QRect kpTiledImage::rect() const
+{
+    return {0, 0, m_width, m_height};
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpTiledImage::copy(const QRect &rect) const
+{
+    // (same as QImage::copy())
+    const QRect copyRect = rect.isNull() ? this->rect() : rect;
+
+    kpImage ret(copyRect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (ret.isNull()) {
+        return ret;
+    }
+
+    if (!this->rect().contains(copyRect)) {
+        ret.fill(0);
+    }
+
+    const QRect readRect = copyRect & this->rect();
+    if (readRect.isEmpty()) {
+        return ret;
+    }
+
+    for (int row = readRect.top() / TileSize; row <= readRect.bottom() / TileSize; row++) {
+        for (int column = readRect.left() / TileSize; column <= readRect.right() / TileSize; column++) {
+            const int i = row * m_columns + column;
+            const QRect tileRect = this->tileRect(i);
+            const QRect part = tileRect & readRect;
+            const Tile &tile = m_tiles[i];
+
+            if (isSolid(tile)) {
+                ::FillRows(&ret, part.translated(-copyRect.topLeft()), tile.color);
+            } else {
+                ::CopyRows(pixels(tile), part.translated(-tileRect.topLeft()), &ret, part.topLeft() - copyRect.topLeft());
+            }
+        }
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpTiledImage::toImage() const
+{
+    if (isNull()) {
+        return {};
+    }
+
+    return copy(rect());
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpTiledImage::setImageAt(const kpImage &image, const QPoint &at)
+{
+    const QRect destRect = QRect(at, image.size()) & rect();
+    if (destRect.isEmpty()) {
+        return;
+    }
+
+    const kpImage src = (image.format() == QImage::Format_ARGB32_Premultiplied) ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    for (int row = destRect.top() / TileSize; row <= destRect.bottom() / TileSize; row++) {
+        for (int column = destRect.left() / TileSize; column <= destRect.right() / TileSize; column++) {
+            const int i = row * m_columns + column;
+            const QRect tileRect = this->tileRect(i);
+            const QRect part = tileRect & destRect;
+            const QRect srcPart = part.translated(-at);
+            Tile &tile = m_tiles[i];
+
+            uint pixel;
+            const bool srcPartIsSolid = ::IsSolid(src, srcPart, &pixel);
+
+            if (part == tileRect) {
+                if (srcPartIsSolid) {
+                    tile.image = kpImage();
+                    tile.stored.reset();
+                    tile.color = pixel;
+                } else {
+                    setPixels(&tile, src.copy(srcPart));
+                }
+                continue;
+            }
+
+            kpImage image;
+            if (isSolid(tile)) {
+                if (srcPartIsSolid && pixel == tile.color) {
+                    continue;
+                }
+
+                image = kpImage(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+                image.fill(tile.color);
+            } else {
+                // (moved out so that, if it is not shared, it is changed in
+                //  place)
+                image = tile.stored ? tile.stored->image() : std::move(tile.image);
+            }
+
+            if (srcPartIsSolid) {
+                ::FillRows(&image, part.translated(-tileRect.topLeft()), pixel);
+            } else {
+                ::CopyRows(src, srcPart, &image, part.topLeft() - tileRect.topLeft());
+            }
+
+            setPixels(&tile, image);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpTiledImage::fill(uint pixel)
+{
+    Tile tile;
+    tile.color = pixel;
+    m_tiles.fill(tile);
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpTiledImage::resize(int width, int height, uint pixel)
+{
+#if DEBUG_KP_TILED_IMAGE
+    qCDebug(kpLogImagelib) << "kpTiledImage::resize(" << size() << "->" << width << "x" << height << ")";
+#endif
+
+    if (width == m_width && height == m_height) {
+        return;
+    }
+
+    const kpTiledImage old = *this;
+    *this = kpTiledImage(width, height, pixel);
+    m_store = old.m_store;
+
+    // As the tiles of both are aligned to (0,0), the part of each new tile
+    // that was in the old image comes from the old tile in the same place.
+    for (int i = 0; i < m_tiles.count(); i++) {
+        const QRect tileRect = this->tileRect(i);
+        const QRect oldPart = tileRect & old.rect();
+        if (oldPart.isEmpty()) {
+            continue;
+        }
+
+        const int oldIndex = old.tileIndexAt(tileRect.x(), tileRect.y());
+        const Tile &oldTile = old.m_tiles[oldIndex];
+        Tile &tile = m_tiles[i];
+
+        if (old.tileRect(oldIndex) == tileRect) {
+            tile = oldTile;
+        } else if (isSolid(oldTile)) {
+            if (oldPart == tileRect || oldTile.color == pixel) {
+                tile.color = oldTile.color;
+            } else {
+                kpImage image(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+                image.fill(pixel);
+                ::FillRows(&image, oldPart.translated(-tileRect.topLeft()), oldTile.color);
+                setPixels(&tile, image);
+            }
+        } else {
+            kpImage image(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+            if (oldPart != tileRect) {
+                image.fill(pixel);
+            }
+            ::CopyRows(pixels(oldTile), oldPart.translated(-tileRect.topLeft()), &image, QPoint(0, 0));
+            setPixels(&tile, image);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+uint kpTiledImage::pixel(int x, int y) const
+{
+    Q_ASSERT(rect().contains(x, y));
+
+    const int i = tileIndexAt(x, y);
+    const Tile &tile = m_tiles[i];
+    if (isSolid(tile)) {
+        return tile.color;
+    }
+
+    const QPoint tileTopLeft = tileRect(i).topLeft();
+    return reinterpret_cast<const uint *>(pixels(tile).constScanLine(y - tileTopLeft.y()))[x - tileTopLeft.x()];
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTiledImage::tileCount() const
+{
+    return m_tiles.count();
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTiledImage::tileIndexAt(int x, int y) const
+{
+    return (y / TileSize) * m_columns + (x / TileSize);
+}
+
+//---------------------------------------------------------------------
+
+// public
+QRect kpTiledImage::tileRect(int tileIndex) const
+{
+    const int x = (tileIndex % m_columns) * TileSize;
+    const int y = (tileIndex / m_columns) * TileSize;
+    return {x, y, qMin(int(TileSize), m_width - x), qMin(int(TileSize), m_height - y)};
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpTiledImage::isTileSolid(int tileIndex) const
+{
+    return isSolid(m_tiles[tileIndex]);
+}
+
+//---------------------------------------------------------------------
+
+// public
+uint kpTiledImage::tileColor(int tileIndex) const
+{
+    return m_tiles[tileIndex].color;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpTiledImage::tileImage(int tileIndex) const
+{
+    return pixels(m_tiles[tileIndex]);
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTiledImage::allocatedTileCount() const
+{
+    return int(std::count_if(m_tiles.cbegin(), m_tiles.cend(), [](const Tile &tile) {
+        return !tile.image.isNull();
+    }));
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,119 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpTiledImage_H
+#define kpTiledImage_H
+
+#include <QList>
+#include <QRect>
+#include <QSharedPointer>
+
+#include "imagelib/kpImage.h"
+
+class kpStoredTile;
+class kpTileStore;
+
+//
+// An image stored as a grid of TileSize x TileSize tiles, for documents
+// too big to copy around as a single kpImage.
+//
+// Tiles are implicitly shared, so copying a kpTiledImage (e.g. to keep
+// it for undo) is cheap and only the tiles that are then written to are
+// copied.  A tile whose pixels are all the same is stored as just that
+// pixel value (see isTileSolid()).
+//
+// If isOutOfCore(), the other tiles are kept in a kpTileStore scratch
+// file instead of in memory and are paged in while they are read.
+//
+// The pixels are always in QImage::Format_ARGB32_Premultiplied.  copy(),
+// setImageAt() and resize() behave like kpPixmapFX::getPixmapAt(),
+// kpPixmapFX::setPixmapAt() and kpPixmapFX::resize() on a kpImage.
+//
+
+class kpTiledImage
+{
+public:
+    enum {
+        TileSize = 256
+    };
+
+    // Constructs a null image.
+    kpTiledImage();
+    // Constructs a <width>x<height> image filled with <pixel>, which does
+    // not allocate any tiles.
+    kpTiledImage(int width, int height, uint pixel);
+    // Splits <image> into tiles.
+    explicit kpTiledImage(const kpImage &image);
+
+    bool isNull() const;
+
+    bool isOutOfCore() const;
+    // Moves the tiles into a new scratch file or back into memory.
+    // Returns false if the scratch file cannot be created.
+    bool setOutOfCore(bool yes = true);
+
+    int width() const;
+    int height() const;
+    QSize size() const;
+    QRect rect() const;
+
+    // Returns <rect> of the image, with any part outside the image being
+    // transparent.
+    kpImage copy(const QRect &rect) const;
+    // Returns the entire image as one kpImage.
+    kpImage toImage() const;
+
+    // Replaces the pixels at <at> with <image>.
+    void setImageAt(const kpImage &image, const QPoint &at);
+
+    // Sets every pixel to <pixel>, freeing all tiles.
+    void fill(uint pixel);
+
+    // Crops or extends the image to <width>x<height>.  New areas are
+    // filled with <pixel>.
+    void resize(int width, int height, uint pixel);
+
+    uint pixel(int x, int y) const;
+
+    //
+    // Tiles, in row-major order
+    //
+
+    int tileCount() const;
+    int tileIndexAt(int x, int y) const;
+    QRect tileRect(int tileIndex) const;
+
+    // Returns whether every pixel of the tile is tileColor().  If not,
+    // tileImage() holds its pixels.
+    bool isTileSolid(int tileIndex) const;
+    uint tileColor(int tileIndex) const;
+    kpImage tileImage(int tileIndex) const;
+
+    // Returns the number of tiles that are not solid and are in memory.
+    int allocatedTileCount() const;
+
+private:
+    struct Tile {
+        // If both are null, the tile is solid.
+        kpImage image;
+        QSharedPointer<kpStoredTile> stored;
+        uint color = 0;
+    };
+
+    static bool isSolid(const Tile &tile);
+    static kpImage pixels(const Tile &tile);
+    // Makes <image> the pixels of <tile>, writing them to the scratch file
+    // if out of core.
+    void setPixels(Tile *tile, const kpImage &image) const;
+
+    int m_width, m_height;
+    int m_columns, m_rows;
+    QList<Tile> m_tiles;
+    QSharedPointer<kpTileStore> m_store;
+};
+
+#endif // kpTiledImage_H
@@ -43,6 +43,10 @@
 #include <KMessageBox>
 
 #include <QImage>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <vector>
 
 //---------------------------------------------------------------------
 
@@ -67,8 +71,14 @@ public:
     kpColor averageColor() const;
     bool isSingleColor() const;
 
+    // Calculates all 4 borders of the same image at once, in one pass over
+    // the image (split across threads for big images).
+    //
     // (returns true on success (even if no rect) or false on error)
-    bool calculate(int isX, int dir);
+    static bool calculate(kpTransformAutoCropBorder *leftBorder,
+                          kpTransformAutoCropBorder *rightBorder,
+                          kpTransformAutoCropBorder *topBorder,
+                          kpTransformAutoCropBorder *botBorder);
 
     bool fillsEntireImage() const;
     bool exists() const;
@@ -80,7 +90,7 @@ private:
 
     QRect m_rect;
     kpColor m_referenceColor;
-    int m_redSum, m_greenSum, m_blueSum;
+    qint64 m_redSum, m_greenSum, m_blueSum;
     bool m_isSingleColor;
 };
 
@@ -157,10 +167,10 @@ kpColor kpTransformAutoCropBorder::averageColor() const
     if (m_processedColorSimilarity == 0)
         return m_referenceColor;
 
-    int numPixels = (m_rect.width() * m_rect.height());
+    const qint64 numPixels = qint64(m_rect.width()) * m_rect.height();
     Q_ASSERT(numPixels > 0);
 
-    return kpColor(m_redSum / numPixels, m_greenSum / numPixels, m_blueSum / numPixels);
+    return kpColor(int(m_redSum / numPixels), int(m_greenSum / numPixels), int(m_blueSum / numPixels));
 }
 
 //---------------------------------------------------------------------
@@ -172,84 +182,293 @@ bool kpTransformAutoCropBorder::isSingleColor() const
 
 //---------------------------------------------------------------------
 
-// public
-bool kpTransformAutoCropBorder::calculate(int isX, int dir)
+// Below this many pixels, starting threads costs more than it saves.
+static const qint64 AutoCropMinPixelsForThreads = 1024 * 1024;
+
+// Rows are split across threads in bands of this many rows.
+static const int AutoCropRowBandSize = 256;
+
+// Same as "kpColor(lhs).isSimilarTo(kpColor(rhs), processedSimilarity)".
+static inline bool IsSimilar(QRgb lhs, QRgb rhs, int processedSimilarity)
 {
-#if DEBUG_KP_TOOL_AUTO_CROP && 1
-    qCDebug(kpLogImagelib) << "kpTransformAutoCropBorder::calculate() CALLED!";
-#endif
-    int maxX = m_imagePtr->width() - 1;
-    int maxY = m_imagePtr->height() - 1;
-
-    QImage qimage = *m_imagePtr;
-    Q_ASSERT(!qimage.isNull());
-
-    // (sync both branches)
-    if (isX) {
-        int numCols = 0;
-        int startX = (dir > 0) ? 0 : maxX;
-
-        kpColor col = kpPixmapFX::getColorAtPixel(qimage, startX, 0);
-        for (int x = startX; x >= 0 && x <= maxX; x += dir) {
-            int y;
-            for (y = 0; y <= maxY; y++) {
-                if (!kpPixmapFX::getColorAtPixel(qimage, x, y).isSimilarTo(col, m_processedColorSimilarity))
-                    break;
-            }
+    if (lhs == rhs) {
+        return true;
+    }
 
-            if (y <= maxY)
+    if (processedSimilarity == kpColor::Exact) {
+        return false;
+    }
+
+    const int dr = qRed(lhs) - qRed(rhs), dg = qGreen(lhs) - qGreen(rhs), db = qBlue(lhs) - qBlue(rhs);
+    return dr * dr + dg * dg + db * db <= processedSimilarity;
+}
+
+// The sums of the colors of a set of pixels that are similar to a
+// border's reference color, for kpTransformAutoCropBorder::averageColor()
+// and isSingleColor().
+struct AutoCropColorSum {
+    qint64 red = 0, green = 0, blue = 0;
+    // Number of pixels not exactly equal to the reference color.
+    qint64 numInexact = 0;
+
+    void add(QRgb rgba, QRgb reference)
+    {
+        red += qRed(rgba);
+        green += qGreen(rgba);
+        blue += qBlue(rgba);
+        numInexact += (rgba != reference);
+    }
+
+    void add(const AutoCropColorSum &rhs)
+    {
+        red += rhs.red;
+        green += rhs.green;
+        blue += rhs.blue;
+        numInexact += rhs.numInexact;
+    }
+};
+
+// What one band of rows [firstRow, endRow) says about the borders.
+struct AutoCropBand {
+    int firstRow = 0, endRow = 0;
+
+    // The fewest leading (left) / trailing (right) pixels of any row in
+    // the band, similar to the left / right reference colors.
+    int leftCols = 0, rightCols = 0;
+    // The first row in the band not entirely similar to the top reference
+    // color (or the image height) and the last row not entirely similar
+    // to the bottom reference color (or -1).
+    int firstNonTopRow = 0, lastNonBotRow = 0;
+
+    // Only if averaging: the sums of the band's pixels in the left and
+    // right borders of the whole image (see SumAutoCropBandColumns()).
+    AutoCropColorSum leftSum, rightSum;
+};
+
+// Scans <band> of <image> (QImage::Format_ARGB32 or
+// Format_ARGB32_Premultiplied; OR-ing each pixel with <alphaMask>) in
+// row-major order.  If <average>, also adds each row entirely similar to
+// the top / bottom reference color into <topRowSums> / <botRowSums>.
+static void ScanAutoCropBand(const QImage &image,
+                             QRgb alphaMask,
+                             const QRgb refs[4],
+                             int processedSimilarity,
+                             bool average,
+                             AutoCropBand *band,
+                             AutoCropColorSum *topRowSums,
+                             AutoCropColorSum *botRowSums)
+{
+    enum {
+        Left,
+        Right,
+        Top,
+        Bot
+    };
+
+    const int width = image.width();
+
+    band->leftCols = band->rightCols = width;
+    band->firstNonTopRow = image.height();
+    band->lastNonBotRow = -1;
+
+    // Returns the number of leading (<step> = 1, starting at line[0]) or
+    // trailing (<step> = -1, starting at line[width - 1]) pixels of <line>,
+    // up to <max>, similar to <ref>.
+    const auto run = [&](const QRgb *line, int max, QRgb ref, int step) {
+        const QRgb *p = (step > 0) ? line : line + width - 1;
+        int i = 0;
+
+        // Most border pixels are exactly the reference color, so first
+        // skip whole blocks of those (this inner loop vectorizes).
+        while (i + 8 <= max) {
+            QRgb diff = 0;
+            for (int j = 0; j < 8; j++) {
+                diff |= (p[(i + j) * step] | alphaMask) ^ ref;
+            }
+            if (diff) {
                 break;
-            else
-                numCols++;
+            }
+            i += 8;
         }
 
-        if (numCols) {
-            m_rect = kpPainter::normalizedRect(QPoint(startX, 0), QPoint(startX + (numCols - 1) * dir, maxY));
-            m_referenceColor = col;
+        while (i < max && ::IsSimilar(p[i * step] | alphaMask, ref, processedSimilarity)) {
+            i++;
+        }
+        return i;
+    };
+    const auto leadingRun = [&](const QRgb *line, int max, QRgb ref) {
+        return run(line, max, ref, +1);
+    };
+
+    for (int y = band->firstRow; y < band->endRow; y++) {
+        const auto *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+
+        // Rows past the top border can't be part of it.
+        const int topRun = (y < band->firstNonTopRow) ? leadingRun(line, width, refs[Top]) : -1;
+        if (topRun >= 0 && topRun < width) {
+            band->firstNonTopRow = y;
         }
-    } else {
-        int numRows = 0;
-        int startY = (dir > 0) ? 0 : maxY;
-
-        kpColor col = kpPixmapFX::getColorAtPixel(qimage, 0, startY);
-        for (int y = startY; y >= 0 && y <= maxY; y += dir) {
-            int x;
-            for (x = 0; x <= maxX; x++) {
-                if (!kpPixmapFX::getColorAtPixel(qimage, x, y).isSimilarTo(col, m_processedColorSimilarity))
-                    break;
-            }
 
-            if (x <= maxX)
-                break;
-            else
-                numRows++;
+        // (the reference colors are usually the same, so reuse scans)
+        const int botRun = (refs[Bot] == refs[Top] && topRun >= 0) ? topRun : leadingRun(line, width, refs[Bot]);
+        if (botRun < width) {
+            band->lastNonBotRow = y;
+        }
+
+        if (refs[Left] == refs[Top] && topRun >= 0) {
+            band->leftCols = qMin(band->leftCols, topRun);
+        } else if (refs[Left] == refs[Bot]) {
+            band->leftCols = qMin(band->leftCols, botRun);
+        } else {
+            band->leftCols = leadingRun(line, band->leftCols, refs[Left]);
         }
 
-        if (numRows) {
-            m_rect = kpPainter::normalizedRect(QPoint(0, startY), QPoint(maxX, startY + (numRows - 1) * dir));
-            m_referenceColor = col;
+        band->rightCols = run(line, band->rightCols, refs[Right], -1);
+
+        if (average && (topRun == width || botRun == width)) {
+            for (int x = 0; x < width; x++) {
+                if (topRun == width) {
+                    topRowSums[y].add(line[x] | alphaMask, refs[Top]);
+                }
+                if (botRun == width) {
+                    botRowSums[y].add(line[x] | alphaMask, refs[Bot]);
+                }
+            }
         }
     }
+}
 
-    if (m_rect.isValid()) {
-        m_isSingleColor = true;
+// Once the whole image has been scanned and the left and right borders
+// are known to be <leftCols> and <rightCols> wide, sums the pixels of
+// <band> in them into <band>->leftSum and rightSum.
+//
+// (The borders of the whole image are only known after every band has
+// been scanned, so summing them in ScanAutoCropBand() would need a sum
+// per column per band.)
+static void SumAutoCropBandColumns(const QImage &image, QRgb alphaMask, const QRgb refs[4], int leftCols, int rightCols, AutoCropBand *band)
+{
+    const int width = image.width();
 
-        if (m_processedColorSimilarity != 0) {
-            for (int y = m_rect.top(); y <= m_rect.bottom(); y++) {
-                for (int x = m_rect.left(); x <= m_rect.right(); x++) {
-                    kpColor colAtPixel = kpPixmapFX::getColorAtPixel(qimage, x, y);
+    for (int y = band->firstRow; y < band->endRow; y++) {
+        const auto *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
 
-                    if (m_isSingleColor && colAtPixel != m_referenceColor)
-                        m_isSingleColor = false;
+        for (int x = 0; x < leftCols; x++) {
+            band->leftSum.add(line[x] | alphaMask, refs[0]);
+        }
+        for (int x = width - rightCols; x < width; x++) {
+            band->rightSum.add(line[x] | alphaMask, refs[1]);
+        }
+    }
+}
 
-                    m_redSum += colAtPixel.red();
-                    m_greenSum += colAtPixel.green();
-                    m_blueSum += colAtPixel.blue();
-                }
+// public static
+bool kpTransformAutoCropBorder::calculate(kpTransformAutoCropBorder *leftBorder,
+                                          kpTransformAutoCropBorder *rightBorder,
+                                          kpTransformAutoCropBorder *topBorder,
+                                          kpTransformAutoCropBorder *botBorder)
+{
+#if DEBUG_KP_TOOL_AUTO_CROP && 1
+    qCDebug(kpLogImagelib) << "kpTransformAutoCropBorder::calculate() CALLED!";
+#endif
+    Q_ASSERT(leftBorder->m_imagePtr == topBorder->m_imagePtr && rightBorder->m_imagePtr == topBorder->m_imagePtr
+             && botBorder->m_imagePtr == topBorder->m_imagePtr);
+
+    const QImage &sourceImage = *topBorder->m_imagePtr;
+    Q_ASSERT(!sourceImage.isNull());
+
+    const int processedColorSimilarity = topBorder->m_processedColorSimilarity;
+    const bool average = (processedColorSimilarity != 0);
+
+    const int width = sourceImage.width(), height = sourceImage.height();
+    const int maxX = width - 1, maxY = height - 1;
+
+    // Read the same pixel values as kpPixmapFX::getColorAtPixel() would,
+    // but straight out of the scanlines.
+    QImage image = sourceImage;
+    QRgb alphaMask = 0;
+    if (image.format() == QImage::Format_RGB32) {
+        alphaMask = 0xFF000000;
+    } else if (image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    const auto pixelAt = [&](int x, int y) {
+        return reinterpret_cast<const QRgb *>(image.constScanLine(y))[x] | alphaMask;
+    };
+    const QRgb refs[4] = {pixelAt(0, 0), pixelAt(maxX, 0), pixelAt(0, 0), pixelAt(0, maxY)};
+
+    QList<AutoCropBand> bands;
+    const int bandSize = (qint64(width) * height < AutoCropMinPixelsForThreads) ? height : AutoCropRowBandSize;
+    for (int y = 0; y < height; y += bandSize) {
+        AutoCropBand band;
+        band.firstRow = y;
+        band.endRow = qMin(y + bandSize, height);
+        bands.append(band);
+    }
+
+    std::vector<AutoCropColorSum> topRowSums(average ? height : 0), botRowSums(average ? height : 0);
+
+    const bool useThreads = (bands.count() > 1 && QThreadPool::globalInstance()->maxThreadCount() > 1);
+    const auto forEachBand = [&](const auto &func) {
+        if (useThreads) {
+            QtConcurrent::blockingMap(bands, func);
+        } else {
+            for (AutoCropBand &band : bands) {
+                func(band);
             }
         }
+    };
+
+    forEachBand([&](AutoCropBand &band) {
+        ::ScanAutoCropBand(image, alphaMask, refs, processedColorSimilarity, average, &band, topRowSums.data(), botRowSums.data());
+    });
+
+    int leftCols = width, rightCols = width;
+    int firstNonTopRow = height, lastNonBotRow = -1;
+    for (const AutoCropBand &band : std::as_const(bands)) {
+        leftCols = qMin(leftCols, band.leftCols);
+        rightCols = qMin(rightCols, band.rightCols);
+        firstNonTopRow = qMin(firstNonTopRow, band.firstNonTopRow);
+        lastNonBotRow = qMax(lastNonBotRow, band.lastNonBotRow);
+    }
+
+    AutoCropColorSum leftSum, rightSum, topSum, botSum;
+    if (average) {
+        forEachBand([&](AutoCropBand &band) {
+            ::SumAutoCropBandColumns(image, alphaMask, refs, leftCols, rightCols, &band);
+        });
+
+        for (const AutoCropBand &band : std::as_const(bands)) {
+            leftSum.add(band.leftSum);
+            rightSum.add(band.rightSum);
+        }
+        for (int y = 0; y < firstNonTopRow; y++) {
+            topSum.add(topRowSums[y]);
+        }
+        for (int y = lastNonBotRow + 1; y < height; y++) {
+            botSum.add(botRowSums[y]);
+        }
     }
 
+    const auto setBorder = [&](kpTransformAutoCropBorder *border, const QRect &rect, QRgb ref, const AutoCropColorSum &sum) {
+        border->invalidate();
+        if (rect.isEmpty()) {
+            return;
+        }
+
+        border->m_rect = rect;
+        border->m_referenceColor = kpColor(ref);
+        border->m_isSingleColor = (sum.numInexact == 0);
+        border->m_redSum = sum.red;
+        border->m_greenSum = sum.green;
+        border->m_blueSum = sum.blue;
+    };
+
+    setBorder(leftBorder, QRect(0, 0, leftCols, height), refs[0], leftSum);
+    setBorder(rightBorder, QRect(width - rightCols, 0, rightCols, height), refs[1], rightSum);
+    setBorder(topBorder, QRect(0, 0, width, firstNonTopRow), refs[2], topSum);
+    setBorder(botBorder, QRect(0, lastNonBotRow + 1, width, maxY - lastNonBotRow), refs[3], botSum);
+
     return true;
 }
 
@@ -275,6 +494,99 @@ void kpTransformAutoCropBorder::invalidate()
     m_isSingleColor = false;
 }
 
+// Finds the borders of an image that Autocrop removes.  The borders must
+// all have been constructed with the same image and color similarity.
+//
+// (returns false if there is nothing to autocrop)
+static bool FindAutoCropBorders(kpTransformAutoCropBorder *leftBorder,
+                                kpTransformAutoCropBorder *rightBorder,
+                                kpTransformAutoCropBorder *topBorder,
+                                kpTransformAutoCropBorder *botBorder)
+{
+    const int processedColorSimilarity = topBorder->processedColorSimilarity();
+
+    // TODO: With Colour Similarity, a lot of weird (and wonderful) things can
+    //       happen resulting in a huge number of code paths.  Needs refactoring
+    //       and regression testing.
+    //
+    // TODO: e.g. When the top fills entire rect but bot doesn't we could
+    //       invalidate top and continue autocrop.
+    int numRegions = 0;
+    if (!kpTransformAutoCropBorder::calculate(leftBorder, rightBorder, topBorder, botBorder) || leftBorder->fillsEntireImage()
+        || rightBorder->fillsEntireImage() || topBorder->fillsEntireImage() || botBorder->fillsEntireImage()
+        || ((numRegions = leftBorder->exists() + rightBorder->exists() + topBorder->exists() + botBorder->exists()) == 0)) {
+#if DEBUG_KP_TOOL_AUTO_CROP
+        qCDebug(kpLogImagelib) << "\tcan't find border; leftBorder.rect=" << leftBorder->rect() << " rightBorder.rect=" << rightBorder->rect()
+                               << " topBorder.rect=" << topBorder->rect() << " botBorder.rect=" << botBorder->rect();
+#endif
+        return false;
+    }
+
+#if DEBUG_KP_TOOL_AUTO_CROP
+    qCDebug(kpLogImagelib) << "\tnumRegions=" << numRegions;
+    qCDebug(kpLogImagelib) << "\t\tleft=" << leftBorder->rect() << " refCol=" << (leftBorder->exists() ? (int *)leftBorder->referenceColor().toQRgb() : nullptr)
+                           << " avgCol=" << (leftBorder->exists() ? (int *)leftBorder->averageColor().toQRgb() : nullptr);
+    qCDebug(kpLogImagelib) << "\t\tright=" << rightBorder->rect()
+                           << " refCol=" << (rightBorder->exists() ? (int *)rightBorder->referenceColor().toQRgb() : nullptr)
+                           << " avgCol=" << (rightBorder->exists() ? (int *)rightBorder->averageColor().toQRgb() : nullptr);
+    qCDebug(kpLogImagelib) << "\t\ttop=" << topBorder->rect() << " refCol=" << (topBorder->exists() ? (int *)topBorder->referenceColor().toQRgb() : nullptr)
+                           << " avgCol=" << (topBorder->exists() ? (int *)topBorder->averageColor().toQRgb() : nullptr);
+    qCDebug(kpLogImagelib) << "\t\tbot=" << botBorder->rect() << " refCol=" << (botBorder->exists() ? (int *)botBorder->referenceColor().toQRgb() : nullptr)
+                           << " avgCol=" << (botBorder->exists() ? (int *)botBorder->averageColor().toQRgb() : nullptr);
+#endif
+
+    // In case e.g. the user pastes a solid, colored-in rectangle,
+    // we favor killing the bottom and right regions
+    // (these regions probably contain the unwanted whitespace due
+    //  to the doc being bigger than the pasted selection to start with).
+    //
+    // We also kill if they kiss or even overlap.
+
+    if (leftBorder->exists() && rightBorder->exists()) {
+        const kpColor leftCol = leftBorder->averageColor();
+        const kpColor rightCol = rightBorder->averageColor();
+
+        if ((numRegions == 2 && !leftCol.isSimilarTo(rightCol, processedColorSimilarity))
+            || leftBorder->right() >= rightBorder->left() - 1) // kissing or overlapping
+        {
+#if DEBUG_KP_TOOL_AUTO_CROP
+            qCDebug(kpLogImagelib) << "\tignoring left border";
+#endif
+            leftBorder->invalidate();
+        }
+    }
+
+    if (topBorder->exists() && botBorder->exists()) {
+        const kpColor topCol = topBorder->averageColor();
+        const kpColor botCol = botBorder->averageColor();
+
+        if ((numRegions == 2 && !topCol.isSimilarTo(botCol, processedColorSimilarity)) || topBorder->bottom() >= botBorder->top() - 1) // kissing or overlapping
+        {
+#if DEBUG_KP_TOOL_AUTO_CROP
+            qCDebug(kpLogImagelib) << "\tignoring top border";
+#endif
+            topBorder->invalidate();
+        }
+    }
+
+    return true;
+}
+
+// Returns the part of an image of size <imageRect> that is left after
+// removing the existing borders.
+static QRect AutoCropContentsRect(const QRect &imageRect,
+                                  const kpTransformAutoCropBorder &leftBorder,
+                                  const kpTransformAutoCropBorder &rightBorder,
+                                  const kpTransformAutoCropBorder &topBorder,
+                                  const kpTransformAutoCropBorder &botBorder)
+{
+    QPoint topLeft(leftBorder.exists() ? leftBorder.rect().right() + 1 : 0, topBorder.exists() ? topBorder.rect().bottom() + 1 : 0);
+    QPoint botRight(rightBorder.exists() ? rightBorder.rect().left() - 1 : imageRect.width() - 1,
+                    botBorder.exists() ? botBorder.rect().top() - 1 : imageRect.height() - 1);
+
+    return {topLeft, botRight};
+}
+
 struct kpTransformAutoCropCommandPrivate {
     bool actOnSelection{};
     kpTransformAutoCropBorder leftBorder, rightBorder, topBorder, botBorder;
@@ -502,11 +814,7 @@ QRect kpTransformAutoCropCommand::contentsRect() const
 {
     const kpImage image = document()->image(d->actOnSelection);
 
-    QPoint topLeft(d->leftBorder.exists() ? d->leftBorder.rect().right() + 1 : 0, d->topBorder.exists() ? d->topBorder.rect().bottom() + 1 : 0);
-    QPoint botRight(d->rightBorder.exists() ? d->rightBorder.rect().left() - 1 : image.width() - 1,
-                    d->botBorder.exists() ? d->botBorder.rect().top() - 1 : image.height() - 1);
-
-    return {topLeft, botRight};
+    return ::AutoCropContentsRect(image.rect(), d->leftBorder, d->rightBorder, d->topBorder, d->botBorder);
 }
 
 static void ShowNothingToAutocropMessage(kpMainWindow *mainWindow, bool actOnSelection)
@@ -553,74 +861,27 @@ bool kpTransformAutoCrop(kpMainWindow *mainWindow)
 
     mainWindow->colorToolBar()->flashColorSimilarityToolBarItem();
 
-    // TODO: With Colour Similarity, a lot of weird (and wonderful) things can
-    //       happen resulting in a huge number of code paths.  Needs refactoring
-    //       and regression testing.
-    //
-    // TODO: e.g. When the top fills entire rect but bot doesn't we could
-    //       invalidate top and continue autocrop.
-    int numRegions = 0;
-    if (!leftBorder.calculate(true /*x*/, +1 /*going right*/) || leftBorder.fillsEntireImage() || !rightBorder.calculate(true /*x*/, -1 /*going left*/)
-        || rightBorder.fillsEntireImage() || !topBorder.calculate(false /*y*/, +1 /*going down*/) || topBorder.fillsEntireImage()
-        || !botBorder.calculate(false /*y*/, -1 /*going up*/) || botBorder.fillsEntireImage()
-        || ((numRegions = leftBorder.exists() + rightBorder.exists() + topBorder.exists() + botBorder.exists()) == 0)) {
-#if DEBUG_KP_TOOL_AUTO_CROP
-        qCDebug(kpLogImagelib) << "\tcan't find border; leftBorder.rect=" << leftBorder.rect() << " rightBorder.rect=" << rightBorder.rect()
-                               << " topBorder.rect=" << topBorder.rect() << " botBorder.rect=" << botBorder.rect();
-#endif
+    if (!::FindAutoCropBorders(&leftBorder, &rightBorder, &topBorder, &botBorder)) {
         ::ShowNothingToAutocropMessage(mainWindow, static_cast<bool>(doc->selection()));
         return false;
     }
 
-#if DEBUG_KP_TOOL_AUTO_CROP
-    qCDebug(kpLogImagelib) << "\tnumRegions=" << numRegions;
-    qCDebug(kpLogImagelib) << "\t\tleft=" << leftBorder.rect() << " refCol=" << (leftBorder.exists() ? (int *)leftBorder.referenceColor().toQRgb() : nullptr)
-                           << " avgCol=" << (leftBorder.exists() ? (int *)leftBorder.averageColor().toQRgb() : nullptr);
-    qCDebug(kpLogImagelib) << "\t\tright=" << rightBorder.rect()
-                           << " refCol=" << (rightBorder.exists() ? (int *)rightBorder.referenceColor().toQRgb() : nullptr)
-                           << " avgCol=" << (rightBorder.exists() ? (int *)rightBorder.averageColor().toQRgb() : nullptr);
-    qCDebug(kpLogImagelib) << "\t\ttop=" << topBorder.rect() << " refCol=" << (topBorder.exists() ? (int *)topBorder.referenceColor().toQRgb() : nullptr)
-                           << " avgCol=" << (topBorder.exists() ? (int *)topBorder.averageColor().toQRgb() : nullptr);
-    qCDebug(kpLogImagelib) << "\t\tbot=" << botBorder.rect() << " refCol=" << (botBorder.exists() ? (int *)botBorder.referenceColor().toQRgb() : nullptr)
-                           << " avgCol=" << (botBorder.exists() ? (int *)botBorder.averageColor().toQRgb() : nullptr);
-#endif
-
-    // In case e.g. the user pastes a solid, colored-in rectangle,
-    // we favor killing the bottom and right regions
-    // (these regions probably contain the unwanted whitespace due
-    //  to the doc being bigger than the pasted selection to start with).
-    //
-    // We also kill if they kiss or even overlap.
+    mainWindow->addImageOrSelectionCommand(
+        new kpTransformAutoCropCommand(static_cast<bool>(doc->selection()), leftBorder, rightBorder, topBorder, botBorder, mainWindow->commandEnvironment()));
 
-    if (leftBorder.exists() && rightBorder.exists()) {
-        const kpColor leftCol = leftBorder.averageColor();
-        const kpColor rightCol = rightBorder.averageColor();
+    return true;
+}
 
-        if ((numRegions == 2 && !leftCol.isSimilarTo(rightCol, processedColorSimilarity))
-            || leftBorder.right() >= rightBorder.left() - 1) // kissing or overlapping
-        {
-#if DEBUG_KP_TOOL_AUTO_CROP
-            qCDebug(kpLogImagelib) << "\tignoring left border";
-#endif
-            leftBorder.invalidate();
-        }
-    }
+QRect kpTransformAutoCropContentsRect(const kpImage &image, int processedColorSimilarity)
+{
+    Q_ASSERT(!image.isNull());
 
-    if (topBorder.exists() && botBorder.exists()) {
-        const kpColor topCol = topBorder.averageColor();
-        const kpColor botCol = botBorder.averageColor();
+    kpTransformAutoCropBorder leftBorder(&image, processedColorSimilarity), rightBorder(&image, processedColorSimilarity),
+        topBorder(&image, processedColorSimilarity), botBorder(&image, processedColorSimilarity);
 
-        if ((numRegions == 2 && !topCol.isSimilarTo(botCol, processedColorSimilarity)) || topBorder.bottom() >= botBorder.top() - 1) // kissing or overlapping
-        {
-#if DEBUG_KP_TOOL_AUTO_CROP
-            qCDebug(kpLogImagelib) << "\tignoring top border";
-#endif
-            topBorder.invalidate();
-        }
+    if (!::FindAutoCropBorders(&leftBorder, &rightBorder, &topBorder, &botBorder)) {
+        return {};
     }
 
-    mainWindow->addImageOrSelectionCommand(
-        new kpTransformAutoCropCommand(static_cast<bool>(doc->selection()), leftBorder, rightBorder, topBorder, botBorder, mainWindow->commandEnvironment()));
-
-    return true;
+    return ::AutoCropContentsRect(image.rect(), leftBorder, rightBorder, topBorder, botBorder);
 }
@@ -55,4 +55,8 @@ private:
 // (returns true on success (even if it did nothing) or false on error)
 bool kpTransformAutoCrop(kpMainWindow *mainWindow);
 
+// Returns the part of <image> that kpTransformAutoCrop() would keep, or an
+// empty rectangle if it has no border to remove.  Shows no dialogs.
+QRect kpTransformAutoCropContentsRect(const kpImage &image, int processedColorSimilarity);
+
 #endif // KP_TRANSFORM_AUTO_CROP_H
@@ -89,7 +89,7 @@ void SetDocumentToSelectionImageCommand::execute()
         // bounding rectangle.
         Q_ASSERT(document()->width() == m_fromSelectionPtr->width());
         Q_ASSERT(document()->height() == m_fromSelectionPtr->height());
-        m_oldImage = document()->image();
+        m_oldImage = document()->getImageAt(document()->rect());
 
         //
         // e.g. original elliptical selection:
@@ -0,0 +1,338 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#define DEBUG_KP_TRANSFORM_RESAMPLE 0
+
+#include "kpTransformResample.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QtMath>
+
+#include "imagelib/kpRowBands.h"
+#include "kpLogCategories.h"
+
+//---------------------------------------------------------------------
+
+// Rows are processed in bands of this many rows, one band per task.
+static const int ResampleRowBandSize = 32;
+
+// Below this many output pixels, starting threads costs more than it saves.
+static const qint64 ResampleMinPixelsForThreads = 256 * 1024;
+
+// When shrinking, the box pre-reduction leaves at least this much
+// shrinking for the filter to do.
+static const int ResampleBoxReductionGap = 3;
+
+//---------------------------------------------------------------------
+
+static double FilterSupport(kpTransformResample::Filter filter)
+{
+    return filter == kpTransformResample::Lanczos3 ? 3.0 : 2.0;
+}
+
+//---------------------------------------------------------------------
+
+static double Sinc(double x)
+{
+    if (x == 0) {
+        return 1.0;
+    }
+
+    x *= M_PI;
+    return std::sin(x) / x;
+}
+
+//---------------------------------------------------------------------
+
+static double FilterWeight(kpTransformResample::Filter filter, double x)
+{
+    x = std::fabs(x);
+
+    if (filter == kpTransformResample::Lanczos3) {
+        return x < 3.0 ? ::Sinc(x) * ::Sinc(x / 3.0) : 0.0;
+    }
+
+    // Mitchell-Netravali with B = C = 1/3.
+    const double B = 1.0 / 3.0, C = 1.0 / 3.0;
+    if (x < 1.0) {
+        return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6;
+    }
+    if (x < 2.0) {
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6;
+    }
+    return 0.0;
+}
+
+//---------------------------------------------------------------------
+
+// The source pixels, and their normalized weights, that each destination
+// pixel along one axis is made of.  Destination pixel <i> is made of
+// source pixels <first[i]> to <first[i] + count[i] - 1>, with weights
+// starting at <weights[i * stride]>.
+struct ResampleContributions {
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<float> weights;
+    int stride;
+};
+
+static ResampleContributions ComputeContributions(int srcSize, int destSize, kpTransformResample::Filter filter)
+{
+    const double scale = double(srcSize) / double(destSize);
+    // When shrinking, stretch the filter to cover every source pixel.
+    const double filterScale = qMax(scale, 1.0);
+    const double support = ::FilterSupport(filter) * filterScale;
+
+    ResampleContributions ret;
+    ret.stride = int(std::ceil(support)) * 2 + 2;
+    ret.first.resize(destSize);
+    ret.count.resize(destSize);
+    ret.weights.resize(size_t(destSize) * ret.stride);
+
+    for (int i = 0; i < destSize; i++) {
+        const double center = (i + 0.5) * scale;
+        const int first = qMax(0, int(std::floor(center - support)));
+        const int end = qMin(srcSize, int(std::ceil(center + support)));
+        const int count = qMin(end - first, ret.stride);
+
+        float *weights = &ret.weights[size_t(i) * ret.stride];
+        double sum = 0;
+        for (int j = 0; j < count; j++) {
+            weights[j] = float(::FilterWeight(filter, (first + j + 0.5 - center) / filterScale));
+            sum += weights[j];
+        }
+
+        if (sum != 0) {
+            for (int j = 0; j < count; j++) {
+                weights[j] = float(weights[j] / sum);
+            }
+        } else {
+            // Can't happen with these filters but be safe: take the
+            // nearest source pixel.
+            std::fill(weights, weights + count, 0.0f);
+            weights[qBound(0, int(center) - first, count - 1)] = 1.0f;
+        }
+
+        ret.first[i] = first;
+        ret.count[i] = count;
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// Rounds and clamps the premultiplied channel sums <c>, keeping each
+// color channel no larger than alpha (the filters' negative lobes could
+// otherwise produce invalid premultiplied pixels).
+static inline QRgb PremultipliedPixel(const float c[4])
+{
+    const int a = qBound(0, int(std::lround(c[0])), 255);
+    const int r = qBound(0, int(std::lround(c[1])), a);
+    const int g = qBound(0, int(std::lround(c[2])), a);
+    const int b = qBound(0, int(std::lround(c[3])), a);
+    return qRgba(r, g, b, a);
+}
+
+//---------------------------------------------------------------------
+
+// Returns <src> shrunk by averaging each <boxWidth>x<boxHeight> block of
+// pixels.  Blocks at the right and bottom edges may be partial, in which
+// case they are averaged over only the source pixels that they cover.
+static QImage BoxReduce(const QImage &src, int boxWidth, int boxHeight)
+{
+    const int srcWidth = src.width(), srcHeight = src.height();
+    const int destWidth = (srcWidth + boxWidth - 1) / boxWidth;
+    const int destHeight = (srcHeight + boxHeight - 1) / boxHeight;
+
+    QImage dest(destWidth, destHeight, QImage::Format_ARGB32_Premultiplied);
+    if (dest.isNull()) {
+        return dest;
+    }
+
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+    uchar *const destBits = dest.bits();
+    const qsizetype destBytesPerLine = dest.bytesPerLine();
+
+    kpRowBands::forEach(destHeight, ResampleRowBandSize, qint64(srcWidth) * srcHeight, ResampleMinPixelsForThreads, [=](int firstRow, int endRow) {
+        std::vector<quint64> sums(size_t(destWidth) * 4);
+
+        for (int y = firstRow; y < endRow; y++) {
+            std::fill(sums.begin(), sums.end(), 0);
+
+            const int srcFirstY = y * boxHeight;
+            const int srcEndY = qMin(srcFirstY + boxHeight, srcHeight);
+            for (int srcY = srcFirstY; srcY < srcEndY; srcY++) {
+                const auto *srcLine = reinterpret_cast<const QRgb *>(srcBits + srcY * srcBytesPerLine);
+                for (int srcX = 0; srcX < srcWidth; srcX++) {
+                    const QRgb p = srcLine[srcX];
+                    quint64 *sum = &sums[size_t(srcX / boxWidth) * 4];
+                    sum[0] += qAlpha(p);
+                    sum[1] += qRed(p);
+                    sum[2] += qGreen(p);
+                    sum[3] += qBlue(p);
+                }
+            }
+
+            const int blockHeight = srcEndY - srcFirstY;
+
+            auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+            for (int x = 0; x < destWidth; x++) {
+                const int srcFirstX = x * boxWidth;
+                const int blockWidth = qMin(srcFirstX + boxWidth, srcWidth) - srcFirstX;
+
+                // (not boxWidth * boxHeight, which would darken and make
+                //  more transparent the partial blocks at the edges)
+                const quint64 n = quint64(blockWidth) * blockHeight;
+                const quint64 *sum = &sums[size_t(x) * 4];
+                destLine[x] = qRgba(int((sum[1] + n / 2) / n), int((sum[2] + n / 2) / n), int((sum[3] + n / 2) / n), int((sum[0] + n / 2) / n));
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
+
+// Returns <src> resampled to <destWidth> wide, keeping its height.
+static QImage ResampleHorizontally(const QImage &src, int destWidth, kpTransformResample::Filter filter)
+{
+    const int height = src.height();
+
+    QImage dest(destWidth, height, QImage::Format_ARGB32_Premultiplied);
+    if (dest.isNull()) {
+        return dest;
+    }
+
+    const ResampleContributions contrib = ::ComputeContributions(src.width(), destWidth, filter);
+
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+    uchar *const destBits = dest.bits();
+    const qsizetype destBytesPerLine = dest.bytesPerLine();
+
+    kpRowBands::forEach(height, ResampleRowBandSize, qint64(destWidth) * height, ResampleMinPixelsForThreads, [&, srcBits, destBits](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; y++) {
+            const auto *srcLine = reinterpret_cast<const QRgb *>(srcBits + y * srcBytesPerLine);
+            auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+
+            for (int x = 0; x < destWidth; x++) {
+                const QRgb *p = srcLine + contrib.first[x];
+                const float *weights = &contrib.weights[size_t(x) * contrib.stride];
+
+                float c[4] = {0, 0, 0, 0};
+                for (int j = 0; j < contrib.count[x]; j++) {
+                    c[0] += weights[j] * qAlpha(p[j]);
+                    c[1] += weights[j] * qRed(p[j]);
+                    c[2] += weights[j] * qGreen(p[j]);
+                    c[3] += weights[j] * qBlue(p[j]);
+                }
+
+                destLine[x] = ::PremultipliedPixel(c);
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
+
+// Returns <src> resampled to <destHeight> high, keeping its width.
+static QImage ResampleVertically(const QImage &src, int destHeight, kpTransformResample::Filter filter)
+{
+    const int width = src.width();
+
+    QImage dest(width, destHeight, QImage::Format_ARGB32_Premultiplied);
+    if (dest.isNull()) {
+        return dest;
+    }
+
+    const ResampleContributions contrib = ::ComputeContributions(src.height(), destHeight, filter);
+
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+    uchar *const destBits = dest.bits();
+    const qsizetype destBytesPerLine = dest.bytesPerLine();
+
+    const qint64 destPixels = qint64(width) * destHeight;
+    kpRowBands::forEach(destHeight, ResampleRowBandSize, destPixels, ResampleMinPixelsForThreads, [&, srcBits, destBits](int firstRow, int endRow) {
+        // Accumulate whole source rows at a time, to read memory in order.
+        std::vector<float> sums(size_t(width) * 4);
+
+        for (int y = firstRow; y < endRow; y++) {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+
+            const float *weights = &contrib.weights[size_t(y) * contrib.stride];
+            for (int j = 0; j < contrib.count[y]; j++) {
+                const auto *srcLine = reinterpret_cast<const QRgb *>(srcBits + (contrib.first[y] + j) * srcBytesPerLine);
+                const float w = weights[j];
+
+                for (int x = 0; x < width; x++) {
+                    float *c = &sums[size_t(x) * 4];
+                    c[0] += w * qAlpha(srcLine[x]);
+                    c[1] += w * qRed(srcLine[x]);
+                    c[2] += w * qGreen(srcLine[x]);
+                    c[3] += w * qBlue(srcLine[x]);
+                }
+            }
+
+            auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+            for (int x = 0; x < width; x++) {
+                destLine[x] = ::PremultipliedPixel(&sums[size_t(x) * 4]);
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+kpImage kpTransformResample::scale(const kpImage &image, int width, int height, Filter filter)
+{
+#if DEBUG_KP_TRANSFORM_RESAMPLE
+    qCDebug(kpLogImagelib) << "kpTransformResample::scale(image.size=" << image.size() << ",width=" << width << ",height=" << height << ",filter=" << filter
+                           << ")";
+#endif
+
+    if (width == image.width() && height == image.height()) {
+        return image;
+    }
+
+    if (filter == Bilinear || image.isNull() || width <= 0 || height <= 0) {
+        return image.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    QImage result = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const int boxWidth = qMax(1, result.width() / (width * ResampleBoxReductionGap));
+    const int boxHeight = qMax(1, result.height() / (height * ResampleBoxReductionGap));
+    if (boxWidth > 1 || boxHeight > 1) {
+#if DEBUG_KP_TRANSFORM_RESAMPLE
+        qCDebug(kpLogImagelib) << "\tbox reducing by" << boxWidth << "x" << boxHeight;
+#endif
+        result = ::BoxReduce(result, boxWidth, boxHeight);
+    }
+
+    if (result.width() != width && !result.isNull()) {
+        result = ::ResampleHorizontally(result, width, filter);
+    }
+
+    if (result.height() != height && !result.isNull()) {
+        result = ::ResampleVertically(result, height, filter);
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------
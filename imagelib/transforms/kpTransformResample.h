@@ -0,0 +1,39 @@
+
+/*
+   SPDX-FileCopyrightText: 2026 The KolourPaint Developers
+
+   SPDX-License-Identifier: BSD-2-Clause
+*/
+
+#ifndef kpTransformResample_H
+#define kpTransformResample_H
+
+#include "imagelib/kpImage.h"
+
+//
+// High quality image scaling, for Smooth Scale.
+//
+// The Mitchell and Lanczos filters are applied separably (first
+// horizontally, then vertically) in premultiplied ARGB, in bands of rows
+// that are spread across threads.  When shrinking by a large factor, the
+// image is first reduced by averaging whole blocks of pixels, so that the
+// filters only have to cover the last few multiples of the reduction.
+//
+
+class kpTransformResample
+{
+public:
+    enum Filter {
+        // QImage::scaled() with Qt::SmoothTransformation.
+        Bilinear,
+        // Mitchell-Netravali cubic (B = C = 1/3): sharp with little ringing.
+        Mitchell,
+        // Lanczos with 3 lobes: sharpest, but may ring around hard edges.
+        Lanczos3
+    };
+
+    // Returns <image> scaled to <width>x<height> using <filter>.
+    static kpImage scale(const kpImage &image, int width, int height, Filter filter);
+};
+
+#endif // kpTransformResample_H
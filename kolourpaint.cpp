@@ -7,6 +7,8 @@
 
 #include <KAboutData>
 
+#include "document/kpBatchProcessor.h"
+#include "document/kpDocumentSaveOptions.h"
 #include "kpVersion.h"
 #include "mainWindow/kpMainWindow.h"
 #include <document/kpDocument.h>
@@ -19,9 +21,102 @@
 #include <QDir>
 #include <QImageReader>
 
+#include <cstdio>
+#include <memory>
+
+// Returns whether --batch was given.  This has to be known before the
+// application object, and therefore the command line parser, exists.
+static bool IsBatchMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], "--batch") == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// Processes the files on the command line without any windows.
+// Returns the exit code.
+static int RunBatch(const QCommandLineParser &cmdLine)
+{
+    kpBatchProcessor processor;
+    QString errorString;
+
+    const QStringList operations = cmdLine.values(QStringLiteral("apply"));
+    for (const QString &operation : operations) {
+        if (!processor.addOperation(operation, &errorString)) {
+            fprintf(stderr, "%s\n%s\n", qPrintable(errorString), qPrintable(kpBatchProcessor::operationsHelpText()));
+            return 1;
+        }
+    }
+
+    const QString outputDir = cmdLine.value(QStringLiteral("output-dir"));
+    if (outputDir.isEmpty() || !QDir().mkpath(outputDir)) {
+        fprintf(stderr, "%s\n", qPrintable(i18n("Batch mode needs an output directory that can be created (--output-dir).")));
+        return 1;
+    }
+    processor.setOutputDirectory(outputDir);
+
+    if (cmdLine.isSet(QStringLiteral("format")) && !processor.setOutputFormat(cmdLine.value(QStringLiteral("format")))) {
+        fprintf(stderr, "%s\n", qPrintable(i18n("Images cannot be saved as \"%1\".", cmdLine.value(QStringLiteral("format")))));
+        return 1;
+    }
+
+    bool ok = true;
+    if (cmdLine.isSet(QStringLiteral("quality"))) {
+        const int quality = cmdLine.value(QStringLiteral("quality")).toInt(&ok);
+        if (!ok || quality < 0 || quality > 100) {
+            fprintf(stderr, "%s\n", qPrintable(i18n("The quality must be from 0 to 100.")));
+            return 1;
+        }
+        processor.setQuality(quality);
+    }
+
+    if (cmdLine.isSet(QStringLiteral("color-depth"))) {
+        const int colorDepth = cmdLine.value(QStringLiteral("color-depth")).toInt(&ok);
+        if (!ok || kpDocumentSaveOptions::colorDepthIsInvalid(colorDepth)) {
+            fprintf(stderr, "%s\n", qPrintable(i18n("The color depth must be 1, 8 or 32.")));
+            return 1;
+        }
+        processor.setColorDepth(colorDepth, cmdLine.isSet(QStringLiteral("dither")));
+    }
+
+    if (cmdLine.isSet(QStringLiteral("jobs"))) {
+        const int jobs = cmdLine.value(QStringLiteral("jobs")).toInt(&ok);
+        if (!ok || jobs < 1) {
+            fprintf(stderr, "%s\n", qPrintable(i18n("The number of jobs must be at least 1.")));
+            return 1;
+        }
+        processor.setMaxJobs(jobs);
+    }
+
+    if (cmdLine.isSet(QStringLiteral("memory-limit"))) {
+        const int megabytes = cmdLine.value(QStringLiteral("memory-limit")).toInt(&ok);
+        if (!ok || megabytes < 1) {
+            fprintf(stderr, "%s\n", qPrintable(i18n("The memory limit must be at least 1 megabyte.")));
+            return 1;
+        }
+        processor.setMemoryLimit(megabytes);
+    }
+
+    const QStringList files = cmdLine.positionalArguments();
+    if (files.isEmpty()) {
+        fprintf(stderr, "%s\n", qPrintable(i18n("Batch mode needs at least one file.")));
+        return 1;
+    }
+
+    return (processor.run(files) == 0) ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // Batch mode never shows a window so it should not need a display.
+    const bool batchMode = ::IsBatchMode(argc, argv);
+    if (batchMode && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    std::unique_ptr<QGuiApplication> app(batchMode ? new QGuiApplication(argc, argv) : new QApplication(argc, argv));
     QImageReader::setAllocationLimit(0); // no explicit memory limit
 
     KLocalizedString::setApplicationDomain("kolourpaint");
@@ -71,7 +166,23 @@ int main(int argc, char *argv[])
     cmdLine.addOption(QCommandLineOption(QStringLiteral("mimetypes"), i18n("List all readable image MIME types")));
     cmdLine.addOption(QCommandLineOption(QStringLiteral("new"), i18n("Start with new image using given size"), i18n("[width]x[height]")));
     cmdLine.addOption(QCommandLineOption(QStringLiteral("no-ask-save"), i18n("Exit without asking to save changes")));
-    cmdLine.process(app);
+
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("batch"), i18n("Process the files without opening any windows (needs --output-dir)")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("apply"),
+                                         i18n("In batch mode, apply the operation to every file, in the order given (see --list-operations)"),
+                                         i18n("operation")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("list-operations"), i18n("List the operations for --apply")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("output-dir"), i18n("In batch mode, save the files to this directory"), i18n("directory")));
+    cmdLine.addOption(
+        QCommandLineOption(QStringLiteral("format"), i18n("In batch mode, save in this format instead of the original one"), i18n("extension or MIME type")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("quality"), i18n("In batch mode, the quality of lossy formats"), i18n("0-100")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("color-depth"), i18n("In batch mode, the color depth to save with"), i18n("1, 8 or 32")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("dither"), i18n("In batch mode, dither when reducing the color depth")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("jobs"), i18n("In batch mode, the number of files processed at once"), i18n("count")));
+    cmdLine.addOption(QCommandLineOption(QStringLiteral("memory-limit"),
+                                         i18n("In batch mode, the approximate memory that the files processed at once may use"),
+                                         i18n("megabytes")));
+    cmdLine.process(*app);
     aboutData.processCommandLine(&cmdLine);
 
     // produce a list of MimeTypes which kolourpaint can handle (can be used inside the .desktop file)
@@ -87,7 +198,16 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    if (app.isSessionRestored()) {
+    if (cmdLine.isSet(QStringLiteral("list-operations"))) {
+        printf("%s\n", qPrintable(kpBatchProcessor::operationsHelpText()));
+
+        return 0;
+    }
+
+    if (batchMode)
+        return ::RunBatch(cmdLine);
+
+    if (app->isSessionRestored()) {
         // Creates a kpMainWindow using the default constructor and then
         // calls kpMainWindow::readProperties().
         kRestoreMainWindows<kpMainWindow>();
@@ -96,10 +216,12 @@ int main(int argc, char *argv[])
         QStringList args = cmdLine.positionalArguments();
 
         if (args.count() >= 1) {
-            for (int i = 0; i < args.count(); i++) {
-                mainWindow = new kpMainWindow(QUrl::fromUserInput(args[i], QDir::currentPath(), QUrl::AssumeLocalFile));
-                mainWindow->show();
-            }
+            QList<QUrl> urls;
+            for (int i = 0; i < args.count(); i++)
+                urls.append(QUrl::fromUserInput(args[i], QDir::currentPath(), QUrl::AssumeLocalFile));
+
+            // (each window is shown straight away, while its image is read)
+            kpMainWindow::openInNewWindows(urls);
         } else {
             kpDocument *doc = nullptr;
             QString sizeStr = cmdLine.value(QStringLiteral("new"));
@@ -469,7 +469,7 @@ void kpAbstractImageSelection::flip(bool horiz, bool vert)
 #if DEBUG_KP_SELECTION && 1
         qCDebug(kpLogLayers) << "\thave pixmap - flipping that";
 #endif
-        d->baseImage = d->baseImage.mirrored(horiz, vert);
+        kpPixmapFX::flip(&d->baseImage, horiz, vert);
     }
 
     if (!d->transparencyMaskCache.isNull()) {
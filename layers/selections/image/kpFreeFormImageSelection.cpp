@@ -166,15 +166,14 @@ static QPolygon RecalculateCardinallyAdjacentPoints(const QPolygon &points)
         if (!cardPoints.isEmpty() && !kpPainter::pointsAreCardinallyAdjacent(p, cardPoints.last())) {
             const QPoint lastPoint = cardPoints.last();
 
-            QList<QPoint> interpPoints = kpPainter::interpolatePoints(lastPoint, p, true /*cardinal adjacency*/);
-
-            Q_ASSERT(interpPoints.size() >= 2);
-            Q_ASSERT(interpPoints[0] == lastPoint);
-            Q_ASSERT(interpPoints.last() == p);
-
-            for (int i = 1 /*skip already existing point*/; i < interpPoints.size(); i++) {
-                cardPoints.append(interpPoints[i]);
-            }
+            kpPainter::forEachInterpolatedPoint(lastPoint, p, true /*cardinal adjacency*/, [&](const QPoint &interpPoint) {
+                // Skip already existing point.
+                if (interpPoint != lastPoint) {
+                    cardPoints.append(interpPoint);
+                }
+            });
+
+            Q_ASSERT(cardPoints.last() == p);
         } else {
             cardPoints.append(p);
         }
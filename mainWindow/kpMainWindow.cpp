@@ -9,6 +9,7 @@
 
 #include "commands/kpCommandHistory.h"
 #include "document/kpDocument.h"
+#include "document/kpDocumentLoader.h"
 #include "environments/commands/kpCommandEnvironment.h"
 #include "environments/document/kpDocumentEnvironment.h"
 #include "environments/tools/kpToolEnvironment.h"
@@ -51,17 +52,6 @@ kpMainWindow::kpMainWindow()
 
 //---------------------------------------------------------------------
 
-kpMainWindow::kpMainWindow(const QUrl &url)
-    : KXmlGuiWindow(nullptr /*parent*/)
-{
-    init();
-    open(url, true /*create an empty doc with the same url if url !exist*/);
-
-    d->isFullyConstructed = true;
-}
-
-//---------------------------------------------------------------------
-
 kpMainWindow::kpMainWindow(kpDocument *newDoc)
     : KXmlGuiWindow(nullptr /*parent*/)
 {
@@ -350,6 +340,10 @@ kpMainWindow::~kpMainWindow()
 {
     d->isFullyConstructed = false;
 
+    // Stop reading any image that open() was asked for.
+    delete d->openLoader;
+    d->openLoader = nullptr;
+
     // Get the kpTool to finish up.  This makes sure that the kpTool destructor
     // will not need to access any other class (that might be deleted before
     // the destructor is called by the QObject child-deletion mechanism).
@@ -607,10 +601,14 @@ void kpMainWindow::setDocument(kpDocument *newDoc)
 
         connect(d->document, &kpDocument::documentSaved, this, &kpMainWindow::slotEnableSettingsShowPath);
 
+        // (only once a background save has actually succeeded)
+        connect(d->document, &kpDocument::documentSaved, this, &kpMainWindow::slotDocumentSaved);
+
         // Command history
         Q_ASSERT(d->commandHistory);
         connect(d->commandHistory, &kpCommandHistory::documentRestored, this, &kpMainWindow::slotDocumentRestored); // caption "!modified"
 
+        connect(d->document, &kpDocument::documentSaveStarted, d->commandHistory, &kpCommandHistory::documentSaveStarted);
         connect(d->document, &kpDocument::documentSaved, d->commandHistory, &kpCommandHistory::documentSaved);
 
         // Sync document -> views
@@ -38,6 +38,7 @@ class kpCommandEnvironment;
 class kpCommandHistory;
 class kpDocument;
 class kpDocumentEnvironment;
+class kpDocumentLoader;
 class kpDocumentMetaInfo;
 class kpDocumentSaveOptions;
 class kpViewManager;
@@ -59,15 +60,16 @@ public:
     // Opens a new window with a blank document.
     kpMainWindow();
 
-    // Opens a new window with the document specified by <url>
-    // or creates a blank document if <url> could not be opened.
-    explicit kpMainWindow(const QUrl &url);
-
     // Opens a new window with the document <newDoc>
     // (<newDoc> can be 0 although this would result in a new
     //  window without a document at all).
     explicit kpMainWindow(kpDocument *newDoc);
 
+    // Opens a new window for each of <urls> straight away, each showing
+    // the progress of reading its image in the background.  All of the
+    // images are read at the same time.
+    static void openInNewWindows(const QList<QUrl> &urls);
+
     void finalizeGUI(KXMLGUIClient *client) override;
 
 public:
@@ -296,8 +298,30 @@ private:
     // to a user open request e.g. File / Open or "kolourpaint doesexist.png".
     // It should not be used for session restore - in that case, it does not
     // make sense to bubble the Recent Files list.
-    bool open(const QUrl &url, bool newDocSameNameIfNotExist = false);
+    //
+    // Unlike openInternal(), a non-empty URL is read in the background with
+    // its progress shown in the status bar (see kpDocumentLoader).  The
+    // document is only created - and, in OpenImagesInSameWindow mode, the
+    // user only asked whether to close the current document - once the
+    // image has been decoded.  While an image is being read, further URLs
+    // are queued.  Any failure is reported to the user by
+    // slotOpenFinished(), so there is nothing for the caller to handle.
+    void open(const QUrl &url, bool newDocSameNameIfNotExist = false);
+
+private:
+    void startOpen(const QUrl &url, bool newDocSameNameIfNotExist);
+    void startPendingOpens();
+    // Returns a new document with the image read by the finished <loader>,
+    // after reporting any error.  Returns nullptr if there is nothing to
+    // open or the user decided not to close the current document.
+    kpDocument *documentFromLoader(const kpDocumentLoader *loader, bool newDocSameNameIfNotExist);
 
+private Q_SLOTS:
+    void slotOpenProgress(int percent);
+    void slotOpenFinished();
+    void slotCancelOpen();
+
+private:
     QList<QUrl> askForOpenURLs(const QString &caption, bool allowMultipleURLs = true);
 
 private Q_SLOTS:
@@ -315,7 +339,7 @@ private Q_SLOTS:
 
     void slotProperties();
 
-    bool save(bool localOnly = false);
+    bool save(bool localOnly = false, bool inBackground = false);
     bool slotSave();
 
 private:
@@ -331,11 +355,13 @@ private:
                        bool *allowLossyPrompt);
 
 private Q_SLOTS:
-    bool saveAs(bool localOnly = false);
+    bool saveAs(bool localOnly = false, bool inBackground = false);
     bool slotSaveAs();
 
     bool slotExport();
 
+    void slotDocumentSaved();
+
     void slotEnableReload();
     bool slotReload();
     void sendPreviewToPrinter(QPrinter *printer);
@@ -501,6 +527,11 @@ private:
     bool isSelectionActive() const;
     bool isTextSelection() const;
 
+    // Returns whether the whole document image (or only the selection's,
+    // if <actOnSelection>) can be put together in memory.  If not, tells
+    // the user so and returns false.  See kpDocument::isOutOfCore().
+    bool imageFitsInMemory(bool actOnSelection);
+
     QString autoCropText() const;
 
     void setupImageMenuActions();
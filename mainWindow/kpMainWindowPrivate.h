@@ -13,6 +13,7 @@
 #include "document/kpDocumentSaveOptions.h"
 
 #include <QList>
+#include <QPair>
 #include <QRect>
 #include <QTimer>
 #include <QUrl>
@@ -20,6 +21,8 @@
 class QAction;
 class QActionGroup;
 class QLabel;
+class QProgressBar;
+class QToolButton;
 
 class KSelectAction;
 class KToggleAction;
@@ -37,6 +40,7 @@ class kpZoomedView;
 class kpThumbnail;
 class kpThumbnailView;
 class kpDocument;
+class kpDocumentLoader;
 class kpViewManager;
 class kpColorToolBar;
 class kpToolToolBar;
@@ -135,6 +139,8 @@ struct kpMainWindowPrivate {
         ,
 
         scanDialog(nullptr)
+        , openLoader(nullptr)
+        , openNewDocSameNameIfNotExist(false)
         ,
 
         exportFirstTime(false)
@@ -245,6 +251,8 @@ struct kpMainWindowPrivate {
 
         statusBarCreated(false)
         , statusBarMessageLabel(nullptr)
+        , statusBarOpenProgressBar(nullptr)
+        , statusBarOpenCancelButton(nullptr)
         , statusBarShapeLastPointsInitialised(false)
         , statusBarShapeLastSizeInitialised(false)
         ,
@@ -320,6 +328,12 @@ struct kpMainWindowPrivate {
 
     SaneDialog *scanDialog;
 
+    // The image being read by open(), if any, and the URLs that open()
+    // was asked for meanwhile.
+    kpDocumentLoader *openLoader;
+    bool openNewDocSameNameIfNotExist;
+    QList<QPair<QUrl, bool>> pendingOpens;
+
     QUrl lastExportURL;
     kpDocumentSaveOptions lastExportSaveOptions;
     bool exportFirstTime;
@@ -403,6 +417,9 @@ struct kpMainWindowPrivate {
     KSqueezedTextLabel *statusBarMessageLabel;
     QList<QLabel *> statusBarLabels;
 
+    QProgressBar *statusBarOpenProgressBar;
+    QToolButton *statusBarOpenCancelButton;
+
     bool statusBarShapeLastPointsInitialised;
     QPoint statusBarShapeLastStartPoint, statusBarShapeLastEndPoint;
     bool statusBarShapeLastSizeInitialised;
@@ -24,10 +24,12 @@
 #include <QPrintDialog>
 #include <QPrintPreviewDialog>
 #include <QPrinter>
+#include <QProgressBar>
 #include <QScreen>
 #include <QSize>
 #include <QSpinBox>
 #include <QTimer>
+#include <QToolButton>
 #include <QVBoxLayout>
 
 #include <KActionCollection>
@@ -47,8 +49,11 @@
 #include "commands/kpCommandHistory.h"
 #include "dialogs/imagelib/kpDocumentMetaInfoDialog.h"
 #include "document/kpDocument.h"
+#include "document/kpDocumentLoader.h"
+#include "imagelib/kpTiledImage.h"
 #include "kpDefs.h"
 #include "kpLogCategories.h"
+#include "lgpl/generic/kpUrlFormatter.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "views/kpView.h"
 #include "views/manager/kpViewManager.h"
@@ -366,20 +371,210 @@ kpDocument *kpMainWindow::openInternal(const QUrl &url, const QSize &fallbackDoc
 //---------------------------------------------------------------------
 
 // private
-bool kpMainWindow::open(const QUrl &url, bool newDocSameNameIfNotExist)
+void kpMainWindow::open(const QUrl &url, bool newDocSameNameIfNotExist)
 {
 #if DEBUG_KP_MAIN_WINDOW
     qCDebug(kpLogMainWindow) << "kpMainWindow::open(" << url << ",newDocSameNameIfNotExist=" << newDocSameNameIfNotExist << ")";
 #endif
 
-    kpDocument *newDoc = openInternal(url, defaultDocSize(), newDocSameNameIfNotExist);
+    // Nothing to read so create the document straight away.
+    if (url.isEmpty()) {
+        openInternal(url, defaultDocSize(), newDocSameNameIfNotExist);
+        return;
+    }
+
+    if (d->openLoader) {
+#if DEBUG_KP_MAIN_WINDOW
+        qCDebug(kpLogMainWindow) << "\tqueued behind" << d->openLoader->url();
+#endif
+        d->pendingOpens.append(qMakePair(url, newDocSameNameIfNotExist));
+        return;
+    }
+
+    startOpen(url, newDocSameNameIfNotExist);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpMainWindow::openInNewWindows(const QList<QUrl> &urls)
+{
+#if DEBUG_KP_MAIN_WINDOW
+    qCDebug(kpLogMainWindow) << "kpMainWindow::openInNewWindows(" << urls << ")";
+#endif
+
+    // Each window starts with a blank document, which is cheap to create,
+    // and shows the progress of its own kpDocumentLoader.  The loaders all
+    // decode on the global thread pool at the same time, rather than each
+    // window reading its image in turn.  Errors are reported once the
+    // window is up.
+    for (const QUrl &url : urls) {
+        auto *mainWindow = new kpMainWindow();
+        mainWindow->show();
+
+        mainWindow->open(url, true /*create an empty doc with the same url if url !exist*/);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpMainWindow::startOpen(const QUrl &url, bool newDocSameNameIfNotExist)
+{
+    Q_ASSERT(!d->openLoader);
+
+    d->openLoader = new kpDocumentLoader(url, this, this);
+    d->openNewDocSameNameIfNotExist = newDocSameNameIfNotExist;
+
+    connect(d->openLoader, &kpDocumentLoader::progress, this, &kpMainWindow::slotOpenProgress);
+    connect(d->openLoader, &kpDocumentLoader::finished, this, &kpMainWindow::slotOpenFinished);
+
+    d->statusBarOpenProgressBar->setToolTip(i18n("Opening \"%1\"", kpUrlFormatter::PrettyFilename(url)));
+    d->statusBarOpenProgressBar->show();
+    d->statusBarOpenCancelButton->show();
+
+    d->openLoader->start();
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpMainWindow::startPendingOpens()
+{
+    // (a dialog shown by slotOpenFinished() may have let the user start
+    //  another open())
+    if (!d->openLoader && !d->pendingOpens.isEmpty()) {
+        const QPair<QUrl, bool> next = d->pendingOpens.takeFirst();
+        startOpen(next.first, next.second);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpMainWindow::slotOpenProgress(int percent)
+{
+    if (percent < 0) {
+        // Decoding - show a busy indicator.
+        d->statusBarOpenProgressBar->setRange(0, 0);
+    } else {
+        d->statusBarOpenProgressBar->setRange(0, 100);
+        d->statusBarOpenProgressBar->setValue(percent);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpMainWindow::slotOpenFinished()
+{
+    kpDocumentLoader *loader = d->openLoader;
+    Q_ASSERT(loader);
+    d->openLoader = nullptr;
+
+    d->statusBarOpenProgressBar->hide();
+    d->statusBarOpenCancelButton->hide();
+
+    const QUrl url = loader->url();
+
+#if DEBUG_KP_MAIN_WINDOW
+    qCDebug(kpLogMainWindow) << "kpMainWindow::slotOpenFinished(" << url << ") status=" << loader->status();
+#endif
+
+    kpDocument *newDoc = documentFromLoader(loader, d->openNewDocSameNameIfNotExist);
+
     if (newDoc) {
-        if (newDoc->isFromExistingURL())
+        // Send document to current or new window.
+        setDocumentChoosingWindow(newDoc);
+
+        if (newDoc->isFromExistingURL()) {
             addRecentURL(url);
-        return true;
+        }
     }
 
-    return false;
+    // (not earlier as the dialogs above run their own event loops)
+    loader->deleteLater();
+
+    startPendingOpens();
+}
+
+//---------------------------------------------------------------------
+
+// private
+kpDocument *kpMainWindow::documentFromLoader(const kpDocumentLoader *loader, bool newDocSameNameIfNotExist)
+{
+    const QUrl url = loader->url();
+
+    kpDocument *newDoc = nullptr;
+
+    // (the error messages match kpDocument::getPixmapFromFile())
+    switch (loader->status()) {
+    case kpDocumentLoader::Succeeded:
+        // If using OpenImagesInSameWindow mode, ask whether to close the
+        // current document.
+        if (shouldOpen()) {
+            const kpTiledImage tiledImage = loader->tiledImage();
+            if (!tiledImage.isNull()) {
+                // (starts out of core, as it is as big)
+                newDoc = new kpDocument(tiledImage.width(), tiledImage.height(), documentEnvironment());
+                newDoc->openImage(url, tiledImage, loader->saveOptions(), loader->metaInfo());
+            } else {
+                newDoc = new kpDocument(loader->image().width(), loader->image().height(), documentEnvironment());
+                newDoc->openImage(url, loader->image(), loader->saveOptions(), loader->metaInfo());
+            }
+        }
+        break;
+
+    case kpDocumentLoader::TransferFailed:
+    case kpDocumentLoader::DecodeFailed:
+        if (loader->status() == kpDocumentLoader::DecodeFailed) {
+            KMessageBox::error(this,
+                               i18n("Could not open \"%1\" - unsupported image format.\n"
+                                    "The file may be corrupt.",
+                                    kpUrlFormatter::PrettyFilename(url)));
+        } else if (!newDocSameNameIfNotExist) {
+            KMessageBox::error(this, i18n("Could not open \"%1\".", kpUrlFormatter::PrettyFilename(url)));
+        }
+
+        // (see kpDocument::open())
+        if (newDocSameNameIfNotExist && shouldOpen()) {
+            const QSize docSize = defaultDocSize();
+            newDoc = new kpDocument(docSize.width(), docSize.height(), documentEnvironment());
+            newDoc->openNew(newDoc->urlExists(url) ? url : QUrl());
+        }
+        break;
+
+    case kpDocumentLoader::TooBig:
+        // (not even with <newDocSameNameIfNotExist>, as the file exists)
+        KMessageBox::error(this,
+                           i18n("Could not open \"%1\" - the image is too big.\n"
+                                "Images this big can only be opened in formats that can be read a part at a time, such as JPEG.",
+                                kpUrlFormatter::PrettyFilename(url)));
+        break;
+
+    case kpDocumentLoader::Cancelled:
+    case kpDocumentLoader::Running:
+        break;
+    }
+
+    return newDoc;
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpMainWindow::slotCancelOpen()
+{
+    if (!d->openLoader) {
+        return;
+    }
+
+    // Cancel everything that the user asked to open, not just the image
+    // that happens to be being read.
+    d->pendingOpens.clear();
+
+    // (calls slotOpenFinished())
+    d->openLoader->cancel();
 }
 
 //---------------------------------------------------------------------
@@ -667,22 +862,18 @@ void kpMainWindow::slotProperties()
 //---------------------------------------------------------------------
 
 // private slot
-bool kpMainWindow::save(bool localOnly)
+bool kpMainWindow::save(bool localOnly, bool inBackground)
 {
     if (d->document->url().isEmpty() || !QImageWriter::supportedMimeTypes().contains(d->document->saveOptions()->mimeType().toLatin1()) ||
         // SYNC: kpDocument::getPixmapFromFile() can't determine quality
         //       from file so it has been set initially to an invalid value.
         (d->document->saveOptions()->mimeTypeHasConfigurableQuality() && d->document->saveOptions()->qualityIsInvalid())
         || (localOnly && !d->document->url().isLocalFile())) {
-        return saveAs(localOnly);
-    }
-
-    if (d->document->save(!d->document->savedAtLeastOnceBefore() /*lossy prompt*/)) {
-        addRecentURL(d->document->url());
-        return true;
+        return saveAs(localOnly, inBackground);
     }
 
-    return false;
+    // (slotDocumentSaved() adds the URL to the recent files)
+    return d->document->save(!d->document->savedAtLeastOnceBefore() /*lossy prompt*/, inBackground);
 }
 
 //---------------------------------------------------------------------
@@ -692,7 +883,8 @@ bool kpMainWindow::slotSave()
 {
     toolEndShape();
 
-    return save();
+    // Let the user keep painting while a local file is written.
+    return save(false /*not only local*/, true /*in background*/);
 }
 
 //---------------------------------------------------------------------
@@ -860,8 +1052,12 @@ QUrl kpMainWindow::askForSaveURL(const QString &caption,
 //---------------------------------------------------------------------
 
 // private slot
-bool kpMainWindow::saveAs(bool localOnly)
+bool kpMainWindow::saveAs(bool localOnly, bool inBackground)
 {
+    if (!imageFitsInMemory(false)) {
+        return false;
+    }
+
     kpDocumentSaveOptions chosenSaveOptions;
     bool allowLossyPrompt;
     QUrl chosenURL = askForSaveURL(i18nc("@title:window", "Save Image As"),
@@ -879,13 +1075,8 @@ bool kpMainWindow::saveAs(bool localOnly)
         return false;
     }
 
-    if (!d->document->saveAs(chosenURL, chosenSaveOptions, allowLossyPrompt)) {
-        return false;
-    }
-
-    addRecentURL(chosenURL);
-
-    return true;
+    // (slotDocumentSaved() adds the URL to the recent files)
+    return d->document->saveAs(chosenURL, chosenSaveOptions, allowLossyPrompt, inBackground);
 }
 
 //---------------------------------------------------------------------
@@ -895,7 +1086,7 @@ bool kpMainWindow::slotSaveAs()
 {
     toolEndShape();
 
-    return saveAs();
+    return saveAs(false /*not only local*/, true /*in background*/);
 }
 
 //---------------------------------------------------------------------
@@ -905,6 +1096,10 @@ bool kpMainWindow::slotExport()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(false)) {
+        return false;
+    }
+
     kpDocumentSaveOptions chosenSaveOptions;
     bool allowLossyPrompt;
     QUrl chosenURL = askForSaveURL(i18nc("@title:window", "Export"),
@@ -938,6 +1133,14 @@ bool kpMainWindow::slotExport()
 
 //---------------------------------------------------------------------
 
+// private slot
+void kpMainWindow::slotDocumentSaved()
+{
+    addRecentURL(d->document->url());
+}
+
+//---------------------------------------------------------------------
+
 // private slot
 void kpMainWindow::slotEnableReload()
 {
@@ -953,6 +1156,9 @@ bool kpMainWindow::slotReload()
 
     Q_ASSERT(d->document);
 
+    // (reload what a background save is writing, once it is written)
+    d->document->waitForSave();
+
     QUrl oldURL = d->document->url();
 
     if (d->document->isModified()) {
@@ -1217,6 +1423,10 @@ void kpMainWindow::slotPrint()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(false)) {
+        return;
+    }
+
     QPrinter printer;
     setPrinterPageOrientation(&printer);
 
@@ -1230,6 +1440,10 @@ void kpMainWindow::slotPrintPreview()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(false)) {
+        return;
+    }
+
     QPrinter printer;
     setPrinterPageOrientation(&printer);
     QPrintPreviewDialog printPreview(&printer, this);
@@ -1245,6 +1459,10 @@ void kpMainWindow::slotMail()
 {
     toolEndShape();
 
+    // Don't attach a half written file or ask to save again while a save
+    // is still running.
+    d->document->waitForSave();
+
     if (d->document->url().isEmpty() /*no name*/ || !(d->document->isFromExistingURL() && d->document->urlExists(d->document->url()))
         || d->document->isModified() /*needs to be saved*/) {
         int result = KMessageBox::questionTwoActions(this,
@@ -1278,6 +1496,12 @@ bool kpMainWindow::queryCloseDocument()
 {
     toolEndShape();
 
+    // Know whether a background save succeeded before deciding whether
+    // the document still needs saving.
+    if (d->document) {
+        d->document->waitForSave();
+    }
+
     if (!d->document || !d->document->isModified() || noAskSave()) {
         return true; // ok to close current doc
     }
@@ -1292,7 +1516,7 @@ bool kpMainWindow::queryCloseDocument()
 
     switch (result) {
     case KMessageBox::ButtonCode::PrimaryAction:
-        return slotSave(); // close only if save succeeds
+        return save(); // close only if save succeeds
     case KMessageBox::ButtonCode::SecondaryAction:
         return true; // close without saving
     default:
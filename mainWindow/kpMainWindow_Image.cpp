@@ -42,6 +42,7 @@
 #include <KActionCollection>
 #include <KConfigGroup>
 #include <KLocalizedString>
+#include <KMessageBox>
 #include <KSharedConfig>
 
 #include <QAction>
@@ -77,6 +78,19 @@ bool kpMainWindow::isTextSelection() const
 
 //---------------------------------------------------------------------
 
+// private
+bool kpMainWindow::imageFitsInMemory(bool actOnSelection)
+{
+    if (actOnSelection || !d->document->isOutOfCore()) {
+        return true;
+    }
+
+    KMessageBox::error(this, i18n("The image is too big to do this - it does not fit in memory."));
+    return false;
+}
+
+//---------------------------------------------------------------------
+
 // private
 QString kpMainWindow::autoCropText() const
 {
@@ -332,7 +346,13 @@ void kpMainWindow::slotResizeScale()
     kpTransformResizeScaleDialog dialog(transformDialogEnvironment(), this);
 
     if (dialog.exec() && !dialog.isNoOp()) {
+        // (only resizing works on the tiles)
+        if (dialog.type() != kpTransformResizeScaleCommand::Resize && !imageFitsInMemory(dialog.actOnSelection())) {
+            return;
+        }
+
         auto *cmd = new kpTransformResizeScaleCommand(dialog.actOnSelection(), dialog.imageWidth(), dialog.imageHeight(), dialog.type(), commandEnvironment());
+        cmd->setSmoothScaleFilter(dialog.smoothScaleFilter());
 
         bool addSelCreateCommand = (dialog.actOnSelection() || cmd->scaleSelectionWithImage());
         bool addSelContentCommand = dialog.actOnSelection();
@@ -356,6 +376,11 @@ void kpMainWindow::slotCrop()
 
     Q_ASSERT(d->document && d->document->selection());
 
+    // The document image is kept for undo.
+    if (!imageFitsInMemory(false)) {
+        return;
+    }
+
     ::kpTransformCrop(this);
 }
 
@@ -366,6 +391,10 @@ void kpMainWindow::slotAutoCrop()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     ::kpTransformAutoCrop(this);
 }
 
@@ -376,6 +405,10 @@ void kpMainWindow::slotFlip()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpTransformFlipCommand(d->document->selection(), false, true, commandEnvironment()));
 }
 
@@ -386,6 +419,10 @@ void kpMainWindow::slotMirror()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpTransformFlipCommand(d->document->selection(), true, false, commandEnvironment()));
 }
 
@@ -396,6 +433,10 @@ void kpMainWindow::slotRotate()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     kpTransformRotateDialog dialog(static_cast<bool>(d->document->selection()), transformDialogEnvironment(), this);
 
     if (dialog.exec() && !dialog.isNoOp()) {
@@ -408,6 +449,10 @@ void kpMainWindow::slotRotate270()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     // TODO: Special command name instead of just "Rotate"?
     addImageOrSelectionCommand(new kpTransformRotateCommand(d->document->selection(), 270, commandEnvironment()));
 }
@@ -417,6 +462,10 @@ void kpMainWindow::slotRotate90()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     // TODO: Special command name instead of just "Rotate"?
     addImageOrSelectionCommand(new kpTransformRotateCommand(d->document->selection(), 90, commandEnvironment()));
 }
@@ -426,6 +475,10 @@ void kpMainWindow::slotSkew()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     kpTransformSkewDialog dialog(static_cast<bool>(d->document->selection()), transformDialogEnvironment(), this);
 
     if (dialog.exec() && !dialog.isNoOp()) {
@@ -441,6 +494,10 @@ void kpMainWindow::slotConvertToBlackAndWhite()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpEffectReduceColorsCommand(1 /*depth*/, true /*dither*/, d->document->selection(), commandEnvironment()));
 }
 
@@ -451,6 +508,10 @@ void kpMainWindow::slotConvertToGrayscale()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpEffectGrayscaleCommand(d->document->selection(), commandEnvironment()));
 }
 
@@ -461,6 +522,10 @@ void kpMainWindow::slotInvertColors()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpEffectInvertCommand(d->document->selection(), commandEnvironment()));
 }
 
@@ -471,6 +536,10 @@ void kpMainWindow::slotClear()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpEffectClearCommand(d->document->selection(), backgroundColor(), commandEnvironment()));
 }
 
@@ -480,6 +549,10 @@ void kpMainWindow::slotMakeConfidential()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     addImageOrSelectionCommand(new kpEffectBlurSharpenCommand(kpEffectBlurSharpen::MakeConfidential,
                                                               kpEffectBlurSharpen::MaxStrength,
                                                               d->document->selection(),
@@ -493,6 +566,10 @@ void kpMainWindow::slotMoreEffects()
 {
     toolEndShape();
 
+    if (!imageFitsInMemory(isSelectionActive())) {
+        return;
+    }
+
     kpEffectsDialog dialog(static_cast<bool>(d->document->selection()), transformDialogEnvironment(), this, d->moreEffectsDialogLastEffect);
 
     if (dialog.exec() && !dialog.isNoOp()) {
@@ -10,9 +10,12 @@
 #include "kpMainWindowPrivate.h"
 #include "mainWindow/kpMainWindow.h"
 
+#include <QIcon>
 #include <QLabel>
+#include <QProgressBar>
 #include <QStatusBar>
 #include <QString>
+#include <QToolButton>
 
 #include "document/kpDocument.h"
 #include "kpDefs.h"
@@ -63,6 +66,21 @@ void kpMainWindow::createStatusBar()
     d->statusBarMessageLabel->setTextElideMode(Qt::ElideRight); // this is the reason why we explicitly set a widget
     sb->addWidget(d->statusBarMessageLabel, 1 /*stretch*/);
 
+    // Only shown while open() is reading an image.
+    d->statusBarOpenProgressBar = new QProgressBar(sb);
+    d->statusBarOpenProgressBar->setFixedHeight(d->statusBarMessageLabel->fontMetrics().height() + 2);
+    d->statusBarOpenProgressBar->setMaximumWidth(d->statusBarMessageLabel->fontMetrics().horizontalAdvance(QLatin1Char('8')) * 20);
+    d->statusBarOpenProgressBar->hide();
+    sb->addWidget(d->statusBarOpenProgressBar);
+
+    d->statusBarOpenCancelButton = new QToolButton(sb);
+    d->statusBarOpenCancelButton->setIcon(QIcon::fromTheme(QStringLiteral("process-stop")));
+    d->statusBarOpenCancelButton->setToolTip(i18n("Cancel Opening"));
+    d->statusBarOpenCancelButton->setAutoRaise(true);
+    d->statusBarOpenCancelButton->hide();
+    connect(d->statusBarOpenCancelButton, &QToolButton::clicked, this, &kpMainWindow::slotCancelOpen);
+    sb->addWidget(d->statusBarOpenCancelButton);
+
     addPermanentStatusBarItem(StatusBarItemShapePoints, (maxDimenLength + 1 /*,*/ + maxDimenLength) * 2 + 3 /* - */);
     addPermanentStatusBarItem(StatusBarItemShapeSize, (1 /*+/-*/ + maxDimenLength) * 2 + 1 /*x*/);
 
@@ -327,7 +345,8 @@ void kpMainWindow::recalculateStatusBar()
 
     if (d->document) {
         setStatusBarDocSize(QSize(d->document->width(), d->document->height()));
-        setStatusBarDocDepth(d->document->image().depth());
+        // (tiled images are always 32-bit)
+        setStatusBarDocDepth(d->document->isTiled() ? 32 : d->document->image().depth());
     } else {
         setStatusBarDocSize();
         setStatusBarDocDepth();
@@ -135,6 +135,10 @@ public:
     // Using <targetWidth> & <targetHeight> to generate preview pixmaps is
     // significantly more efficient than rotating and then scaling yourself.
     //
+    // Lossless rotations (see isLosslessRotation()) that do not scale are
+    // done by directly transposing pixels, instead of painting with a
+    // rotated matrix.
+    //
     static QTransform rotateMatrix(int width, int height, double angle);
     static QTransform rotateMatrix(const QImage &pixmap, double angle);
 
@@ -143,6 +147,15 @@ public:
     static void rotate(QImage *destPixmapPtr, double angle, const kpColor &backgroundColor, int targetWidth = -1, int targetHeight = -1);
     static QImage rotate(const QImage &pm, double angle, const kpColor &backgroundColor, int targetWidth = -1, int targetHeight = -1);
 
+    //
+    // Flips an image horizontally and/or vertically.
+    //
+    // Same as QImage::mirrored() but, for 32-bit images, uses a cache
+    // friendly kernel that is spread across threads for large images.
+    //
+    static void flip(QImage *destPtr, bool horiz, bool vert);
+    static QImage flip(const QImage &pm, bool horiz, bool vert);
+
     //
     // Drawing Shapes
     //
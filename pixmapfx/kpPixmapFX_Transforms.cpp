@@ -9,8 +9,11 @@
 
 #include "kpPixmapFX.h"
 
+#include <algorithm>
+
 #include <QtMath>
 
+#include <QColorSpace>
 #include <QImage>
 #include <QPainter>
 #include <QPoint>
@@ -19,6 +22,7 @@
 #include "kpLogCategories.h"
 
 #include "imagelib/kpColor.h"
+#include "imagelib/kpRowBands.h"
 #include "kpDefs.h"
 #include "layers/selections/kpAbstractSelection.h"
 
@@ -99,6 +103,15 @@ QImage kpPixmapFX::scale(const QImage &image, int w, int h, bool pretty)
 
 //---------------------------------------------------------------------
 
+// Transforms process pixels in square blocks of this size, so that the
+// source and destination of a block both stay in the CPU cache.
+static const int TransformBlockSize = 64;
+
+// Below this many pixels, starting threads costs more than it saves.
+static const qint64 TransformMinPixelsForThreads = 1024 * 1024;
+
+//---------------------------------------------------------------------
+
 // public static
 const double kpPixmapFX::AngleInDegreesEpsilon = qRadiansToDegrees(std::tan(1.0 / 10000.0)) / (2.0 /*max error allowed*/ * 2.0 /*for good measure*/);
 
@@ -219,6 +232,69 @@ static QTransform TrueMatrix(const QTransform &matrix, int srcPixmapWidth, int s
 
 //---------------------------------------------------------------------
 
+// Renders <src>, transformed by <matrix>, into <dest> (which must be
+// QImage::Format_ARGB32_Premultiplied) the same way as an unsmoothed
+// QPainter::drawImage() with QPainter::CompositionMode_Source would:
+// each destination pixel whose centre maps, through the inverse of
+// <matrix>, to inside <src> gets the source pixel there, transparent pixels
+// included.  All other pixels get <backgroundColor> (or transparent, if
+// <backgroundColor> is invalid).
+//
+// Each tile of <dest> maps its own source coordinates, so the tiles are
+// spread across threads for large images.
+static void TransformNearestNeighbor(QImage *dest, const QImage &src_, const QTransform &matrix, const kpColor &backgroundColor)
+{
+    const QRgb background = backgroundColor.isValid() ? qPremultiply(backgroundColor.toQRgb()) : 0;
+
+    bool invertible = false;
+    const QTransform inverse = matrix.inverted(&invertible);
+    if (!invertible || src_.isNull()) {
+        dest->fill(background);
+        return;
+    }
+
+    const QImage src = src_.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int srcWidth = src.width();
+    const int srcHeight = src.height();
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+
+    const int destWidth = dest->width();
+    uchar *const destBits = dest->bits();
+    const qsizetype destBytesPerLine = dest->bytesPerLine();
+
+    const double m11 = inverse.m11(), m12 = inverse.m12();
+    const double m21 = inverse.m21(), m22 = inverse.m22();
+    const double dx = inverse.dx(), dy = inverse.dy();
+
+    kpRowBands::forEach(dest->height(), TransformBlockSize, qint64(destWidth) * dest->height(), TransformMinPixelsForThreads, [=](int firstRow, int endRow) {
+        for (int tileX = 0; tileX < destWidth; tileX += TransformBlockSize) {
+            const int tileEndX = qMin(tileX + TransformBlockSize, destWidth);
+
+            for (int y = firstRow; y < endRow; y++) {
+                auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+
+                // Source coordinates of the centre of pixel (0,y).
+                const double rowX = m21 * (y + 0.5) + dx + m11 * 0.5;
+                const double rowY = m22 * (y + 0.5) + dy + m12 * 0.5;
+
+                for (int x = tileX; x < tileEndX; x++) {
+                    const double srcX = std::floor(rowX + m11 * x);
+                    const double srcY = std::floor(rowY + m12 * x);
+
+                    if (srcX >= 0 && srcX < srcWidth && srcY >= 0 && srcY < srcHeight) {
+                        destLine[x] = reinterpret_cast<const QRgb *>(srcBits + int(srcY) * srcBytesPerLine)[int(srcX)];
+                    } else {
+                        destLine[x] = background;
+                    }
+                }
+            }
+        }
+    });
+}
+
+//---------------------------------------------------------------------
+
 // Like QPixmap::transformed() but fills new areas with <backgroundColor>
 // (unless <backgroundColor> is invalid) and works around internal QTransform
 // floating point -> integer oddities, that would otherwise give fatally
@@ -346,27 +422,14 @@ static QImage TransformPixmap(const QImage &pm, const QTransform &transformMatri
                            << " dy=" << painter.worldMatrix().dy() << endl;
 #endif
 
-    // Note: Do _not_ use "p.setRenderHints (QPainter::SmoothPixmapTransform);"
+    // Note: Do _not_ smooth (e.g. bilinearly interpolate) the source pixels
     //       as the user does not want their image to get blurier every
     //       time they e.g. rotate it (especially important for multiples
     //       of 90 degrees but also true for every other angle).  Being a
     //       pixel-based program, we generally like to preserve RGB values
     //       and avoid unnecessary blurs -- in the worst case, we'd rather
     //       drop pixels, than blur.
-    QPainter p(&newQImage);
-    {
-        // Make sure transparent pixels are drawn into the destination image.
-        p.setCompositionMode(QPainter::CompositionMode_Source);
-
-        // Fill the entire new image with the background color.
-        if (backgroundColor.isValid()) {
-            p.fillRect(newQImage.rect(), backgroundColor.toQColor());
-        }
-
-        p.setWorldTransform(transformMatrix);
-        p.drawImage(QPoint(0, 0), pm);
-    }
-    p.end();
+    ::TransformNearestNeighbor(&newQImage, pm, transformMatrix, backgroundColor);
 
 #if DEBUG_KP_PIXMAP_FX && 1
     qCDebug(kpLogPixmapfx) << "Done";
@@ -520,6 +583,117 @@ bool kpPixmapFX::isLosslessRotation(double angle)
 
 //---------------------------------------------------------------------
 
+static bool IsLosslessTransformFormat(const QImage &image)
+{
+    return image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied;
+}
+
+//---------------------------------------------------------------------
+
+// Returns <src> flipped.  <src> must satisfy IsLosslessTransformFormat().
+static QImage FlipLossless(const QImage &src, bool horiz, bool vert)
+{
+    const int w = src.width();
+    const int h = src.height();
+
+    QImage dest(w, h, src.format());
+    if (dest.isNull()) {
+        return dest;
+    }
+
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+    uchar *const destBits = dest.bits();
+    const qsizetype destBytesPerLine = dest.bytesPerLine();
+
+    kpRowBands::forEach(h, TransformBlockSize, qint64(w) * h, TransformMinPixelsForThreads, [=](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; y++) {
+            const auto *srcLine = reinterpret_cast<const QRgb *>(srcBits + (vert ? h - 1 - y : y) * srcBytesPerLine);
+            auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+
+            if (horiz) {
+                std::reverse_copy(srcLine, srcLine + w, destLine);
+            } else {
+                std::copy(srcLine, srcLine + w, destLine);
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
+
+// Returns <src> rotated clockwise by 90 (<clockwise>) or 270 degrees.
+// <src> must satisfy IsLosslessTransformFormat().
+static QImage TransposeLossless(const QImage &src, bool clockwise)
+{
+    const int srcWidth = src.width();
+    const int srcHeight = src.height();
+
+    QImage dest(srcHeight, srcWidth, src.format());
+    if (dest.isNull()) {
+        return dest;
+    }
+
+    const uchar *const srcBits = src.constBits();
+    const qsizetype srcBytesPerLine = src.bytesPerLine();
+    uchar *const destBits = dest.bits();
+    const qsizetype destBytesPerLine = dest.bytesPerLine();
+
+    // Clockwise, dest(x,y) = src(y, srcHeight - 1 - x).
+    // Anticlockwise, dest(x,y) = src(srcWidth - 1 - y, x).
+    kpRowBands::forEach(srcWidth, TransformBlockSize, qint64(srcWidth) * srcHeight, TransformMinPixelsForThreads, [=](int firstRow, int endRow) {
+        for (int blockX = 0; blockX < srcHeight; blockX += TransformBlockSize) {
+            const int blockEndX = qMin(blockX + TransformBlockSize, srcHeight);
+
+            for (int y = firstRow; y < endRow; y++) {
+                auto *destLine = reinterpret_cast<QRgb *>(destBits + y * destBytesPerLine);
+                const int srcX = clockwise ? y : srcWidth - 1 - y;
+
+                for (int x = blockX; x < blockEndX; x++) {
+                    const int srcY = clockwise ? srcHeight - 1 - x : x;
+                    destLine[x] = reinterpret_cast<const QRgb *>(srcBits + srcY * srcBytesPerLine)[srcX];
+                }
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
+
+// Returns <pm> rotated by <angle>, which must satisfy
+// kpPixmapFX::isLosslessRotation().  The result is in the same format
+// that TransformPixmap() would return.
+static QImage RotateLossless(const QImage &pm, double angle)
+{
+    int quarterTurns = qRound(angle / 90) % 4;
+    if (quarterTurns < 0) {
+        quarterTurns += 4;
+    }
+
+#if DEBUG_KP_PIXMAP_FX
+    qCDebug(kpLogPixmapfx) << "kppixmapfx.cpp: RotateLossless(angle=" << angle << ") quarterTurns=" << quarterTurns;
+#endif
+
+    const QImage src = pm.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    switch (quarterTurns) {
+    case 1:
+        return ::TransposeLossless(src, true /*clockwise*/);
+    case 2:
+        return ::FlipLossless(src, true, true);
+    case 3:
+        return ::TransposeLossless(src, false /*anticlockwise*/);
+    default:
+        return src;
+    }
+}
+
+//---------------------------------------------------------------------
+
 // public static
 void kpPixmapFX::rotate(QImage *destPtr, double angle, const kpColor &backgroundColor, int targetWidth, int targetHeight)
 {
@@ -539,9 +713,61 @@ QImage kpPixmapFX::rotate(const QImage &pm, double angle, const kpColor &backgro
         return pm;
     }
 
+    if (kpPixmapFX::isLosslessRotation(angle)) {
+        const bool swapsDimensions = qRound(angle / 90) % 2 != 0;
+        const int newWidth = swapsDimensions ? pm.height() : pm.width();
+        const int newHeight = swapsDimensions ? pm.width() : pm.height();
+
+        // Not scaling?
+        if ((targetWidth <= 0 || targetWidth == newWidth) && (targetHeight <= 0 || targetHeight == newHeight)) {
+            return ::RotateLossless(pm, angle);
+        }
+    }
+
     QTransform matrix = rotateMatrix(pm, angle);
 
     return ::TransformPixmap(pm, matrix, backgroundColor, targetWidth, targetHeight);
 }
 
 //---------------------------------------------------------------------
+
+// public static
+void kpPixmapFX::flip(QImage *destPtr, bool horiz, bool vert)
+{
+    if (!destPtr) {
+        return;
+    }
+
+    *destPtr = kpPixmapFX::flip(*destPtr, horiz, vert);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QImage kpPixmapFX::flip(const QImage &pm, bool horiz, bool vert)
+{
+    if ((!horiz && !vert) || pm.isNull()) {
+        return pm;
+    }
+
+    if (!::IsLosslessTransformFormat(pm)) {
+        return pm.mirrored(horiz, vert);
+    }
+
+    QImage dest = ::FlipLossless(pm, horiz, vert);
+
+    // Keep the same metadata as QImage::mirrored().
+    dest.setDotsPerMeterX(pm.dotsPerMeterX());
+    dest.setDotsPerMeterY(pm.dotsPerMeterY());
+    dest.setOffset(pm.offset());
+    dest.setDevicePixelRatio(pm.devicePixelRatio());
+    dest.setColorSpace(pm.colorSpace());
+    const QStringList textKeys = pm.textKeys();
+    for (const QString &key : textKeys) {
+        dest.setText(key, pm.text(key));
+    }
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
@@ -56,7 +56,9 @@ void kpToolColorEraser::globalDraw()
 
     kpToolFlowCommand *cmd = new kpToolFlowCommand(i18n("Color Eraser"), environ()->commandEnvironment());
 
-    const QRect dirtyRect = kpPainter::washRect(document()->imagePointer(),
+    QPoint origin;
+    kpImage *image = document()->beginDirectDraw(document()->rect(), &origin);
+    const QRect dirtyRect = kpPainter::washRect(image,
                                                 0,
                                                 0,
                                                 document()->width(),
@@ -64,6 +66,7 @@ void kpToolColorEraser::globalDraw()
                                                 backgroundColor() /*color to draw in*/,
                                                 foregroundColor() /*color to replace*/,
                                                 processedColorSimilarity());
+    document()->endDirectDraw();
 
     if (!dirtyRect.isEmpty()) {
         document()->slotContentsChanged(dirtyRect);
@@ -110,16 +113,23 @@ QRect kpToolColorEraser::drawLine(const QPoint &thisPoint, const QPoint &lastPoi
 
     environ()->flashColorSimilarityToolBarItem();
 
-    const QRect dirtyRect = kpPainter::washLine(document()->imagePointer(),
-                                                lastPoint.x(),
-                                                lastPoint.y(),
-                                                thisPoint.x(),
-                                                thisPoint.y(),
-                                                color(mouseButton()) /*color to draw in*/,
-                                                brushWidth(),
-                                                brushHeight(),
-                                                color(1 - mouseButton()) /*color to replace*/,
-                                                processedColorSimilarity());
+    QPoint origin;
+    kpImage *image = document()->beginDirectDraw(QRect(lastPoint, thisPoint).normalized().adjusted(-brushWidth(), -brushHeight(), brushWidth(), brushHeight()),
+                                                 &origin);
+    const QRect imageDirtyRect = kpPainter::washLine(image,
+                                                     lastPoint.x() - origin.x(),
+                                                     lastPoint.y() - origin.y(),
+                                                     thisPoint.x() - origin.x(),
+                                                     thisPoint.y() - origin.y(),
+                                                     color(mouseButton()) /*color to draw in*/,
+                                                     brushWidth(),
+                                                     brushHeight(),
+                                                     color(1 - mouseButton()) /*color to replace*/,
+                                                     processedColorSimilarity());
+    document()->endDirectDraw();
+
+    // (a tiled document's <image> extends past the document's edges)
+    const QRect dirtyRect = imageDirtyRect.translated(origin) & document()->rect();
 
 #if DEBUG_KP_TOOL_COLOR_ERASER
     qCDebug(kpLogTools) << "\tdirtyRect=" << dirtyRect;
@@ -56,6 +56,9 @@ struct kpToolFlowBasePrivate {
 
     bool brushIsDiagonalLine{};
 
+    // See addContentsChangedRect().
+    QRect changedBoundingRect, changedMergedRect;
+
     kpToolFlowCommand *currentCommand{};
 };
 
@@ -417,4 +420,41 @@ QRect kpToolFlowBase::hotRect() const
 
 //---------------------------------------------------------------------
 
+// protected
+void kpToolFlowBase::addContentsChangedRect(const QRect &drawnRect)
+{
+    // Merged rectangles are no bigger than this in either dimension, so
+    // that little is repainted that was not drawn on.
+    const int maxMergedSize = qMax(64, 4 * qMax(d->brushWidth, d->brushHeight));
+
+    const QRect rect = drawnRect.intersected(document()->rect());
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    d->changedBoundingRect |= rect;
+
+    const QRect united = d->changedMergedRect | rect;
+    if (!d->changedMergedRect.isEmpty() && (united.width() > maxMergedSize || united.height() > maxMergedSize)) {
+        document()->slotContentsChanged(d->changedMergedRect);
+        d->changedMergedRect = rect;
+    } else {
+        d->changedMergedRect = united;
+    }
+}
+
+// protected
+QRect kpToolFlowBase::flushContentsChanged()
+{
+    if (!d->changedMergedRect.isEmpty()) {
+        document()->slotContentsChanged(d->changedMergedRect);
+    }
+
+    const QRect boundingRect = d->changedBoundingRect;
+    d->changedBoundingRect = d->changedMergedRect = QRect();
+    return boundingRect;
+}
+
+//---------------------------------------------------------------------
+
 #include "moc_kpToolFlowBase.cpp"
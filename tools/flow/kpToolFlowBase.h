@@ -57,6 +57,12 @@ public:
 protected:
     virtual QString haventBegunDrawUserMessage() const = 0;
 
+    // Strokes follow the mouse exactly.
+    bool careAboutEveryMouseMove() const override
+    {
+        return true;
+    }
+
     virtual bool haveSquareBrushes() const
     {
         return false;
@@ -87,6 +93,17 @@ protected:
     virtual kpColor color(int which);
     QRect hotRect() const;
 
+    // For drawLine() implementations that draw straight into the
+    // document's image: call addContentsChangedRect() for each rectangle
+    // drawn on and then flushContentsChanged(), which tells the document
+    // about them.  Nearby rectangles are merged but, unlike their bounding
+    // rectangle, a long diagonal stroke does not mark most of the image as
+    // changed.  Nothing is allocated.
+    void addContentsChangedRect(const QRect &drawnRect);
+    // Returns the bounding rectangle, within the document, of the
+    // rectangles added since the last call.
+    QRect flushContentsChanged();
+
 protected Q_SLOTS:
     void updateBrushAndCursor();
 
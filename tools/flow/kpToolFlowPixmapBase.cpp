@@ -29,28 +29,48 @@ kpToolFlowPixmapBase::kpToolFlowPixmapBase(const QString &text,
 
 QRect kpToolFlowPixmapBase::drawLine(const QPoint &thisPoint, const QPoint &lastPoint)
 {
-    QRect docRect = kpPainter::normalizedRect(thisPoint, lastPoint);
-    docRect = neededRect(docRect, qMax(brushWidth(), brushHeight()));
-    kpImage image = document()->getImageAt(docRect);
-
-    const QList<QPoint> points = kpPainter::interpolatePoints(lastPoint, thisPoint, brushIsDiagonalLine());
-
-    for (const QPoint &p : points) {
-        const QPoint point = hotRectForMousePointAndBrushWidthHeight(p, brushWidth(), brushHeight()).topLeft() - docRect.topLeft();
-
-        // OPT: This may be redrawing pixels that were drawn on a previous
-        //      iteration, since the brush is usually bigger than 1 pixel.
-        //      Maybe we could use QRegion to determine all the non-intersecting
-        //      regions and only draw each region once.
-        //
-        //      Try this at least for the easy case of the Eraser, which has
-        //      square, simply-filled brushes.  Profiling needs to be done as
-        //      QRegion is known to be a CPU hog.
-        brushDrawFunction()(&image, point, brushDrawFunctionData());
-    }
-
-    document()->setImageAt(image, docRect.topLeft());
-    return docRect;
+    const auto runRect = [this](int y, int x1, int x2) {
+        const QRect firstRect = hotRectForMousePointAndBrushWidthHeight(QPoint(x1, y), brushWidth(), brushHeight());
+        return firstRect.united(firstRect.translated(x2 - x1, 0));
+    };
+
+    // Stamp the brush straight into the document's image.  The command
+    // holds on to the image from before the stroke for undo (see
+    // kpToolFlowCommand), so this only copies the image on the first
+    // stamp of the stroke.
+    QPoint origin;
+    kpImage *image = document()->beginDirectDraw(runRect(lastPoint.y(), lastPoint.x(), lastPoint.x()).united(runRect(thisPoint.y(), thisPoint.x(), thisPoint.x())),
+                                                 &origin);
+
+    kpPainter::forEachInterpolatedRun(lastPoint, thisPoint, brushIsDiagonalLine(), [&](int y, int x1, int x2) {
+        const QRect imageRunRect = runRect(y, x1, x2).translated(-origin);
+
+        if (haveSquareBrushes()) {
+            // The Eraser's square stamps along a run add up to a rectangle
+            // of the same color, so fill it in one go.
+            kpPainter::fillRect(image, imageRunRect.x(), imageRunRect.y(), imageRunRect.width(), imageRunRect.height(), color(mouseButton()));
+        } else {
+            // OPT: This may be redrawing pixels that were drawn on a previous
+            //      iteration, since the brush is usually bigger than 1 pixel.
+            //      Maybe we could use QRegion to determine all the non-intersecting
+            //      regions and only draw each region once.
+            //
+            //      Profiling needs to be done as QRegion is known to be a CPU hog.
+            for (int x = x1; x <= x2; x++) {
+                brushDrawFunction()(image, imageRunRect.topLeft() + QPoint(x - x1, 0), brushDrawFunctionData());
+            }
+        }
+    });
+
+    document()->endDirectDraw();
+
+    // (only once the drawing is back in the document, as views may repaint
+    //  straight away)
+    kpPainter::forEachInterpolatedRun(lastPoint, thisPoint, brushIsDiagonalLine(), [&](int y, int x1, int x2) {
+        addContentsChangedRect(runRect(y, x1, x2));
+    });
+
+    return flushContentsChanged();
 }
 
 //---------------------------------------------------------------------
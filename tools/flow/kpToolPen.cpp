@@ -38,22 +38,29 @@ QString kpToolPen::haventBegunDrawUserMessage() const
 // protected virtual [base kpToolFlowBase]
 QRect kpToolPen::drawLine(const QPoint &thisPoint, const QPoint &lastPoint)
 {
-    QRect docRect = kpPainter::normalizedRect(thisPoint, lastPoint);
-    docRect = neededRect(docRect, 1 /*pen width*/);
-    kpImage image = document()->getImageAt(docRect);
-
-    const QPoint sp = lastPoint - docRect.topLeft(), ep = thisPoint - docRect.topLeft();
-
-    QPainter painter(&image);
-
-    // never use AA - it does not look good for the usually very short lines
-    // painter.setRenderHint(QPainter::Antialiasing, kpToolEnvironment::drawAntiAliased);
-
-    painter.setPen(color(mouseButton()).toQColor());
-    painter.drawLine(sp, ep);
-
-    document()->setImageAt(image, docRect.topLeft());
-    return docRect;
+    // Draw straight into the document's image (see
+    // kpToolFlowPixmapBase::drawLine()).
+    QPoint origin;
+    kpImage *image = document()->beginDirectDraw(QRect(lastPoint, thisPoint).normalized().adjusted(-1, -1, 1, 1), &origin);
+    {
+        QPainter painter(image);
+        painter.translate(-origin);
+
+        // never use AA - it does not look good for the usually very short lines
+        // painter.setRenderHint(QPainter::Antialiasing, kpToolEnvironment::drawAntiAliased);
+
+        painter.setPen(color(mouseButton()).toQColor());
+        painter.drawLine(lastPoint, thisPoint);
+    }
+    document()->endDirectDraw();
+
+    // QPainter's line may stray from these points by a pixel, so each
+    // run is given a 1-pixel margin.
+    kpPainter::forEachInterpolatedRun(lastPoint, thisPoint, false /*no cardinal adjacency*/, [&](int y, int x1, int x2) {
+        addContentsChangedRect(QRect(x1 - 1, y - 1, x2 - x1 + 3, 3));
+    });
+
+    return flushContentsChanged();
 }
 
 //--------------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 kpToolSpraycan::kpToolSpraycan(kpToolEnvironment *environ, QObject *parent)
     : kpToolFlowBase(i18n("Spraycan"), i18n("Sprays graffiti"), Qt::Key_Y, environ, parent, QStringLiteral("tool_spraycan"))
     , m_toolWidgetSpraycanSize(nullptr)
+    , m_pointGenerator(QRandomGenerator::global()->generate())
 {
     m_timer = new QTimer(this);
     m_timer->setInterval(25 /*ms*/);
@@ -94,35 +95,50 @@ QRect kpToolSpraycan::drawLineWithProbability(const QPoint &thisPoint, const QPo
     qCDebug(kpLogTools) << "CALL(thisPoint=" << thisPoint << ",lastPoint=" << lastPoint << ")";
 #endif
 
-    QList<QPoint> docPoints = kpPainter::interpolatePoints(lastPoint, thisPoint, false /*no need for cardinally adjacency points*/, probability);
+    Q_ASSERT(probability >= 0.0 && probability <= 1.0);
+    const int probabilityTimes1000 = qRound(probability * 1000);
+
+    m_docPoints.clear();
+    kpPainter::forEachInterpolatedPoint(lastPoint, thisPoint, false /*no need for cardinally adjacency points*/, [&](const QPoint &p) {
+        if (probabilityTimes1000 == 1000 || m_pointGenerator.bounded(1000) < probabilityTimes1000) {
+            m_docPoints.append(p);
+        }
+    });
 #if DEBUG_KP_TOOL_SPRAYCAN
-    qCDebug(kpLogTools) << "\tdocPoints=" << docPoints;
+    qCDebug(kpLogTools) << "\tdocPoints=" << m_docPoints;
 #endif
 
     // By chance no points to draw?
-    if (docPoints.empty()) {
+    if (m_docPoints.empty()) {
         return {};
     }
 
-    // For efficiency, only get image after NOP check above.
-    QRect docRect = kpPainter::normalizedRect(thisPoint, lastPoint);
-    docRect = neededRect(docRect, spraycanSize());
-    kpImage image = document()->getImageAt(docRect);
-
-    // Spray at each point, onto the image.
+    // Spray at each point, straight into the document's image (see
+    // kpToolFlowPixmapBase::drawLine()).
     //
     // Note in passing: Unlike other tools such as the Brush, drawing
     //                  over the same point does result in a different
     //                  appearance.
+    QRect pointsRect;
+    for (const auto &dp : std::as_const(m_docPoints)) {
+        pointsRect |= QRect(dp, dp);
+    }
 
-    QList<QPoint> imagePoints;
-    for (const auto &dp : docPoints)
-        imagePoints.append(dp - docRect.topLeft());
-
-    kpPainter::sprayPoints(&image, imagePoints, color(mouseButton()), spraycanSize());
+    QPoint origin;
+    kpImage *image = document()->beginDirectDraw(neededRect(pointsRect, spraycanSize()), &origin);
+    if (!origin.isNull()) {
+        for (auto &dp : m_docPoints) {
+            dp -= origin;
+        }
+    }
+    kpPainter::sprayPoints(image, m_docPoints, color(mouseButton()), spraycanSize());
+    document()->endDirectDraw();
 
     viewManager()->setFastUpdates();
-    document()->setImageAt(image, docRect.topLeft());
+    for (const auto &dp : std::as_const(m_docPoints)) {
+        addContentsChangedRect(neededRect(QRect(dp + origin, dp + origin), spraycanSize()));
+    }
+    const QRect docRect = flushContentsChanged();
     viewManager()->restoreFastUpdates();
 
     return docRect;
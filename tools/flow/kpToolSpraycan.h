@@ -10,7 +10,10 @@
 
 #include "kpToolFlowBase.h"
 
-class QPoint;
+#include <QList>
+#include <QPoint>
+#include <QRandomGenerator>
+
 class QRect;
 class QString;
 class QTimer;
@@ -55,6 +58,12 @@ protected Q_SLOTS:
 protected:
     QTimer *m_timer;
     kpToolWidgetSpraycanSize *m_toolWidgetSpraycanSize;
+
+    // Picks which points of a line are sprayed at.
+    QRandomGenerator m_pointGenerator;
+    // Reused by drawLineWithProbability() so that its capacity is only
+    // allocated once.
+    QList<QPoint> m_docPoints;
 };
 
 #endif // KP_TOOL_SPRAYCAN_H
@@ -19,6 +19,8 @@
 #include <KActionCollection>
 #include <KLocalizedString>
 
+#include <QTimer>
+
 #include "environments/tools/kpToolEnvironment.h"
 #include "imagelib/kpColor.h"
 #include "views/kpView.h"
@@ -44,6 +46,11 @@ kpTool::kpTool(const QString &text, const QString &description, int key, kpToolE
     d->description = description;
     d->began = false;
     d->viewUnderStartPoint = nullptr;
+    d->drawFrameTimer = new QTimer(this);
+    d->drawFrameTimer->setSingleShot(true);
+    connect(d->drawFrameTimer, &QTimer::timeout, this, &kpTool::drawPendingMoves);
+    d->drawMoveEventCount = 0;
+    d->drawFrameCount = 0;
     d->userShapeStartPoint = KP_INVALID_POINT;
     d->userShapeEndPoint = KP_INVALID_POINT;
     d->userShapeSize = KP_INVALID_SIZE;
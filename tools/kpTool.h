@@ -191,6 +191,15 @@ protected:
     {
         return false;
     }
+    // Mouse moves while drawing are coalesced so that draw() is called at
+    // most once per screen frame, with the latest point.  Tools that trace
+    // the path of the mouse return true, to have draw() called for every
+    // point received instead.  The views are still only updated once per
+    // frame.
+    virtual bool careAboutEveryMouseMove() const
+    {
+        return false;
+    }
 
     virtual void beginDraw();
 
@@ -296,6 +305,18 @@ public:
 
     virtual void wheelEvent(QWheelEvent *e);
 
+    // The number of mouse moves received, and of frames drawn for them,
+    // since the current or last draw began.
+    int drawMoveEventCount() const;
+    int drawFrameCount() const;
+
+private Q_SLOTS:
+    // Draws the mouse moves coalesced by mouseMoveEvent().
+    void drawPendingMoves();
+
+private:
+    void discardPendingMoves();
+
     //
     // Keyboard Events
     //
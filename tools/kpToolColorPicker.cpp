@@ -19,6 +19,9 @@
 
 #include <KLocalizedString>
 
+#include <QRect>
+#include <QSize>
+
 kpToolColorPicker::kpToolColorPicker(kpToolEnvironment *environ, QObject *parent)
     : kpTool(i18n("Color Picker"), i18n("Lets you select a color from the image"), Qt::Key_C, environ, parent, QStringLiteral("tool_color_picker"))
 {
@@ -33,7 +36,12 @@ kpColor kpToolColorPicker::colorAtPixel(const QPoint &p)
     qCDebug(kpLogTools) << "kpToolColorPicker::colorAtPixel" << p;
 #endif
 
-    return kpPixmapFX::getColorAtPixel(document()->image(), p);
+    if (!document()->rect().contains(p)) {
+        return kpColor::Invalid;
+    }
+
+    // (not image(), which would put a tiled document's image together)
+    return kpPixmapFX::getColorAtPixel(document()->getImageAt(QRect(p, QSize(1, 1))), QPoint(0, 0));
 }
 
 // private
@@ -67,6 +67,12 @@ void kpToolFloodFill::beginDraw()
     qCDebug(kpLogTools) << "kpToolFloodFill::beginDraw()";
 #endif
 
+    // The fill needs the whole image in memory.
+    if (!document()->imagePointer()) {
+        setUserMessage(i18n("The image is too big to flood fill."));
+        return;
+    }
+
     QApplication::setOverrideCursor(Qt::WaitCursor);
     {
         environ()->flashColorSimilarityToolBarItem();
@@ -111,6 +117,10 @@ void kpToolFloodFill::draw(const QPoint &thisPoint, const QPoint &, const QRect
 // public virtual [base kpTool]
 void kpToolFloodFill::cancelShape()
 {
+    if (!d->currentCommand) {
+        return;
+    }
+
     d->currentCommand->unexecute();
 
     delete d->currentCommand;
@@ -132,6 +142,11 @@ void kpToolFloodFill::releasedAllButtons()
 // public virtual [base kpTool]
 void kpToolFloodFill::endDraw(const QPoint &, const QRect &)
 {
+    // (refused in beginDraw())
+    if (!d->currentCommand) {
+        return;
+    }
+
     environ()->commandHistory()->addCommand(d->currentCommand, false /*no exec - we already did it up there*/);
 
     // Don't delete - it just got added to the history.
@@ -8,6 +8,8 @@
 #ifndef kpToolPrivate_H
 #define kpToolPrivate_H
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QPoint>
 
 #include <QSize>
@@ -18,6 +20,8 @@
 
 #include "views/kpView.h"
 
+class QTimer;
+
 class kpToolEnvironment;
 class KToggleAction;
 
@@ -38,6 +42,15 @@ struct kpToolPrivate {
 
     kpView *viewUnderStartPoint;
 
+    // Mouse moves while drawing are drawn at most once per frame (see
+    // kpTool::mouseMoveEvent()).  These are the view points of the moves
+    // received since the last frame.
+    QList<QPoint> pendingDrawViewPoints;
+    QTimer *drawFrameTimer;
+    QElapsedTimer lastDrawFrameTime;
+    // Mouse moves received, and frames drawn, in the current draw.
+    int drawMoveEventCount, drawFrameCount;
+
     // Set to 2 when the user swaps the foreground and background color.
     //
     // When nonzero, it suppresses the foreground and background "color changed"
@@ -161,6 +161,7 @@ void kpTool::endInternal()
     if (d->began) {
         // before we can stop using the tool, we must stop the current drawing operation (if any)
         if (hasBegunShape()) {
+            drawPendingMoves();
             endShapeInternal(d->currentPoint, normalizedRect());
         }
 
@@ -291,6 +292,8 @@ void kpTool::drawInternal()
 // also called by kpView
 void kpTool::cancelShapeInternal()
 {
+    discardPendingMoves();
+
     if (hasBegunShape()) {
         d->beganDraw = false;
         cancelShape();
@@ -330,6 +330,9 @@ void kpTool::notifyModifierStateChanged()
 {
     if (careAboutModifierState()) {
         if (d->beganDraw) {
+            // Catch up with the mouse first.
+            drawPendingMoves();
+
             draw(d->currentPoint, d->lastPoint, normalizedRect());
         } else {
             d->currentPoint = calculateCurrentPoint();
@@ -23,6 +23,23 @@
 #include <QApplication>
 #include <QClipboard>
 #include <QMouseEvent>
+#include <QScreen>
+#include <QTimer>
+
+//---------------------------------------------------------------------
+
+// Returns the time, in milliseconds, between frames of the screen that
+// <view> is on.
+static int FrameInterval(const kpView *view)
+{
+    const QScreen *screen = view ? view->screen() : nullptr;
+    const qreal refreshRate = screen ? screen->refreshRate() : 0;
+    if (refreshRate <= 0) {
+        return 16;
+    }
+
+    return qMax(1, qRound(1000 / refreshRate));
+}
 
 //---------------------------------------------------------------------
 
@@ -54,6 +71,7 @@ void kpTool::mousePressEvent(QMouseEvent *e)
 #if DEBUG_KP_TOOL && 1
                 qCDebug(kpLogTools) << "\t\thasBegunShape - end";
 #endif
+                drawPendingMoves();
                 endShapeInternal(d->currentPoint, normalizedRect());
             }
 
@@ -116,6 +134,9 @@ void kpTool::mousePressEvent(QMouseEvent *e)
     d->viewUnderStartPoint = view;
     d->lastPoint = QPoint(-1, -1);
 
+    d->drawMoveEventCount = d->drawFrameCount = 0;
+    d->lastDrawFrameTime.invalidate();
+
 #if DEBUG_KP_TOOL && 1
     qCDebug(kpLogTools) << "\tBeginning draw @ " << d->currentPoint;
 #endif
@@ -154,39 +175,24 @@ void kpTool::mouseMoveEvent(QMouseEvent *e)
     d->altPressed = (e->modifiers() & Qt::AltModifier);
 
     if (d->beganDraw) {
-        kpView *view = viewUnderStartPoint();
-        Q_ASSERT(view);
-
-        d->currentPoint = view->transformViewToDoc(e->pos());
-        d->currentViewPoint = e->pos();
-
-#if DEBUG_KP_TOOL && 0
-        qCDebug(kpLogTools) << "\tDraw!";
-#endif
-
-        bool dragScrolled = false;
-        movedAndAboutToDraw(d->currentPoint, d->lastPoint, view->zoomLevelX(), &dragScrolled);
-
-        if (dragScrolled) {
-            d->currentPoint = calculateCurrentPoint();
-            d->currentViewPoint = calculateCurrentPoint(false /*view point*/);
-
-            // Scrollview has scrolled contents and has scheduled an update
-            // for the newly exposed region.  If draw() schedules an update
-            // as well (instead of immediately updating), the scrollview's
-            // update will be executed first and it'll only update part of
-            // the screen resulting in ugly tearing of the viewManager's
-            // tempImage.
-            viewManager()->setFastUpdates();
-        }
-
-        drawInternal();
-
-        if (dragScrolled) {
-            viewManager()->restoreFastUpdates();
+        // A tablet or a fast mouse may send moves much more often than
+        // the screen is refreshed, so only draw once per frame (see
+        // careAboutEveryMouseMove()).
+        d->pendingDrawViewPoints.append(e->pos());
+        d->drawMoveEventCount++;
+
+        if (!d->drawFrameTimer->isActive()) {
+            const int frameInterval = ::FrameInterval(viewUnderStartPoint());
+            const qint64 sinceLastFrame = d->lastDrawFrameTime.isValid() ? d->lastDrawFrameTime.elapsed() : frameInterval;
+
+            // Draw right away unless a frame was just drawn, so that slow
+            // moves are not delayed.
+            if (sinceLastFrame >= frameInterval) {
+                drawPendingMoves();
+            } else {
+                d->drawFrameTimer->start(int(frameInterval - sinceLastFrame));
+            }
         }
-
-        d->lastPoint = d->currentPoint;
     } else {
         kpView *view = viewUnderCursor();
         if (!view) // possible if cancelShape()'ed but still holding down initial mousebtn
@@ -214,6 +220,12 @@ void kpTool::mouseReleaseEvent(QMouseEvent *e)
     // Have _not_ already cancelShape()'ed by pressing other mouse button?
     // (e.g. you can cancel a line dragged out with the LMB, by pressing
     //       the RMB)
+    if (d->beganDraw) {
+        // Draw the moves before the release, before it ends the draw.
+        drawPendingMoves();
+    }
+
+    // drawPendingMoves() could have ended the draw.
     if (d->beganDraw) {
         kpView *view = viewUnderStartPoint();
         Q_ASSERT(view);
@@ -223,6 +235,10 @@ void kpTool::mouseReleaseEvent(QMouseEvent *e)
 
         drawInternal();
 
+#if DEBUG_KP_TOOL && 1
+        qCDebug(kpLogTools) << "\tdrew" << d->drawMoveEventCount << "mouse moves in" << d->drawFrameCount << "frames";
+#endif
+
         endDrawInternal(d->currentPoint, normalizedRect());
     }
 
@@ -233,6 +249,90 @@ void kpTool::mouseReleaseEvent(QMouseEvent *e)
 
 //---------------------------------------------------------------------
 
+// private slot
+void kpTool::drawPendingMoves()
+{
+    d->drawFrameTimer->stop();
+
+    if (!d->beganDraw || d->pendingDrawViewPoints.isEmpty()) {
+        d->pendingDrawViewPoints.clear();
+        return;
+    }
+
+    kpView *view = viewUnderStartPoint();
+    Q_ASSERT(view);
+
+    // Tools that do not trace the mouse only need to see where it is now.
+    const int count = d->pendingDrawViewPoints.count();
+    const int first = careAboutEveryMouseMove() ? 0 : count - 1;
+
+    bool dragScrolled = false;
+
+    // Repaint the views once for all the moves.
+    viewManager()->setQueueUpdates();
+    for (int i = first; i < count && d->beganDraw; i++) {
+        d->currentViewPoint = d->pendingDrawViewPoints[i];
+        d->currentPoint = view->transformViewToDoc(d->currentViewPoint);
+
+#if DEBUG_KP_TOOL && 0
+        qCDebug(kpLogTools) << "\tDraw!";
+#endif
+
+        bool scrolled = false;
+        movedAndAboutToDraw(d->currentPoint, d->lastPoint, view->zoomLevelX(), &scrolled);
+
+        if (scrolled) {
+            d->currentPoint = calculateCurrentPoint();
+            d->currentViewPoint = calculateCurrentPoint(false /*view point*/);
+            dragScrolled = true;
+        }
+
+        drawInternal();
+
+        d->lastPoint = d->currentPoint;
+    }
+    d->pendingDrawViewPoints.clear();
+
+    // Scrollview has scrolled contents and has scheduled an update
+    // for the newly exposed region.  If we schedule an update as well
+    // (instead of immediately updating), the scrollview's update will be
+    // executed first and it'll only update part of the screen resulting in
+    // ugly tearing of the viewManager's tempImage.
+    if (dragScrolled) {
+        viewManager()->setFastUpdates();
+    }
+    viewManager()->restoreQueueUpdates();
+    if (dragScrolled) {
+        viewManager()->restoreFastUpdates();
+    }
+
+    d->drawFrameCount++;
+    d->lastDrawFrameTime.start();
+}
+
+// private
+void kpTool::discardPendingMoves()
+{
+    d->drawFrameTimer->stop();
+    d->pendingDrawViewPoints.clear();
+}
+
+//---------------------------------------------------------------------
+
+// public
+int kpTool::drawMoveEventCount() const
+{
+    return d->drawMoveEventCount;
+}
+
+// public
+int kpTool::drawFrameCount() const
+{
+    return d->drawFrameCount;
+}
+
+//---------------------------------------------------------------------
+
 void kpTool::wheelEvent(QWheelEvent *e)
 {
 #if DEBUG_KP_TOOL
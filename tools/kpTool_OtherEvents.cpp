@@ -53,6 +53,11 @@ void kpTool::focusOutEvent(QFocusEvent *)
     qCDebug(kpLogTools) << "kpTool::focusOutEvent() beganDraw=" << d->beganDraw;
 #endif
 
+    if (d->beganDraw) {
+        drawPendingMoves();
+    }
+
+    // drawPendingMoves() could have ended the draw.
     if (d->beganDraw) {
         endDrawInternal(d->currentPoint, normalizedRect());
     }
@@ -45,6 +45,9 @@ struct kpToolPolygonalBasePrivate {
     int originatingMouseButton;
 
     QPolygon points;
+
+    // The points that the preview being shown was drawn for.
+    QPolygon previewPoints;
 };
 
 //---------------------------------------------------------------------
@@ -294,7 +297,7 @@ void kpToolPolygonalBase::draw(const QPoint &, const QPoint &, const QRect &)
         applyModifiers();
 
         // Update the preview of the shape.
-        updateShape();
+        updateShapeIfChanged();
 
         // Inform the user that we're dragging out a line with 2 control points.
         setUserShapePoints(d->points[count - 2], d->points[count - 1]);
@@ -302,7 +305,7 @@ void kpToolPolygonalBase::draw(const QPoint &, const QPoint &, const QRect &)
     // We're modifying a point.
     else {
         // Update the preview of the shape.
-        updateShape();
+        updateShapeIfChanged();
 
         // Informs the user that we're just modifying a point (perhaps, a control
         // point of a Bezier).
@@ -356,6 +359,20 @@ void kpToolPolygonalBase::updateShape()
         viewManager()->setTempImage(newTempImage);
     }
     viewManager()->restoreFastUpdates();
+
+    d->previewPoints = d->points;
+}
+
+// private
+void kpToolPolygonalBase::updateShapeIfChanged()
+{
+    // When zoomed in, the mouse often moves without leaving its document
+    // pixel.  The shape is then the same, so keep showing its preview.
+    if (d->points == d->previewPoints && viewManager()->tempImage()) {
+        return;
+    }
+
+    updateShape();
 }
 
 // virtual
@@ -169,6 +169,10 @@ protected:
 protected Q_SLOTS:
     void updateShape();
 
+private:
+    // Calls updateShape() unless the preview already shows points().
+    void updateShapeIfChanged();
+
 public:
     void cancelShape() override;
     void releasedAllButtons() override;
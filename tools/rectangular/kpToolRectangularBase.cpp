@@ -38,6 +38,9 @@ struct kpToolRectangularBasePrivate {
     kpToolWidgetFillStyle *toolWidgetFillStyle{};
 
     QRect toolRectangleRect;
+
+    // The toolRectangleRect that the preview being shown was drawn for.
+    QRect previewRect;
 };
 
 //---------------------------------------------------------------------
@@ -203,6 +206,8 @@ void kpToolRectangularBase::applyModifiers()
 
 void kpToolRectangularBase::beginDraw()
 {
+    d->previewRect = QRect();
+
     setUserMessage(cancelUserMessage());
 }
 
@@ -247,6 +252,8 @@ void kpToolRectangularBase::updateShape()
     viewManager()->setFastUpdates();
     viewManager()->setTempImage(newTempImage);
     viewManager()->restoreFastUpdates();
+
+    d->previewRect = d->toolRectangleRect;
 }
 
 //---------------------------------------------------------------------
@@ -255,7 +262,11 @@ void kpToolRectangularBase::draw(const QPoint &, const QPoint &, const QRect &)
 {
     applyModifiers();
 
-    updateShape();
+    // When zoomed in, the mouse often moves without leaving its document
+    // pixel.  The shape is then the same, so keep showing its preview.
+    if (d->toolRectangleRect != d->previewRect || !viewManager()->tempImage()) {
+        updateShape();
+    }
 
     // Recover the start and end points from the transformed & normalized d->toolRectangleRect
 
@@ -20,6 +20,7 @@
 
 #include "document/kpDocument.h"
 #include "imagelib/kpColor.h"
+#include "imagelib/kpImagePyramid.h"
 #include "kpViewScrollableContainer.h"
 #include "layers/selections/kpAbstractSelection.h"
 #include "layers/selections/text/kpTextSelection.h"
@@ -401,16 +402,33 @@ void kpView::paintEventDrawDoc_Unclipped(const QRect &viewRect)
     QImage docPixmap;
     bool tempImageWillBeRendered = false;
 
+    // If zoomed out, <docPixmap> is taken from this level of the
+    // document's image pyramid and covers <levelRect> of that level.
+    int level = 0;
+    QRect levelRect;
+
     // LOTODO: I think <docRect> being empty would be a bug.
     if (!docRect.isEmpty()) {
-        docPixmap = doc->getImageAt(docRect);
+        tempImageWillBeRendered = (!doc->selection() && vm->tempImage() && vm->tempImage()->isVisible(vm) && docRect.intersects(vm->tempImage()->rect()));
+
+        // The selection and temp image can only be drawn onto the full
+        // resolution image.
+        if (!doc->selection() && !tempImageWillBeRendered) {
+            level = kpImagePyramid::levelForScale(double(qMax(zoomLevelX(), zoomLevelY())) / 100.0);
+        }
+
+        if (level > 0) {
+            const int left = docRect.left() >> level, top = docRect.top() >> level;
+            levelRect = QRect(left, top, (docRect.right() >> level) - left + 1, (docRect.bottom() >> level) - top + 1);
+            docPixmap = doc->downsampledImageAt(level, levelRect);
+        } else {
+            docPixmap = doc->getImageAt(docRect);
+        }
 
 #if DEBUG_KP_VIEW_RENDERER && 1
-        qCDebug(kpLogViews) << "\tdocPixmap.hasAlphaChannel()=" << docPixmap.hasAlphaChannel();
+        qCDebug(kpLogViews) << "\tdocPixmap.hasAlphaChannel()=" << docPixmap.hasAlphaChannel() << " level=" << level;
 #endif
 
-        tempImageWillBeRendered = (!doc->selection() && vm->tempImage() && vm->tempImage()->isVisible(vm) && docRect.intersects(vm->tempImage()->rect()));
-
 #if DEBUG_KP_VIEW_RENDERER && 1
         qCDebug(kpLogViews) << "\ttempImageWillBeRendered=" << tempImageWillBeRendered << " (sel=" << doc->selection() << " tempImage=" << vm->tempImage()
                             << " tempImage.isVisible=" << (vm->tempImage() ? vm->tempImage()->isVisible(vm) : false)
@@ -447,8 +465,8 @@ void kpView::paintEventDrawDoc_Unclipped(const QRect &viewRect)
 #endif
         // This is the only troublesome part of the method that draws unclipped.
         painter.translate(origin().x(), origin().y());
-        painter.scale(double(zoomLevelX()) / 100.0, double(zoomLevelY()) / 100.0);
-        painter.drawImage(docRect, docPixmap);
+        painter.scale(double(zoomLevelX()) / 100.0 * (1 << level), double(zoomLevelY()) / 100.0 * (1 << level));
+        painter.drawImage(level > 0 ? levelRect : docRect, docPixmap);
         // painter.resetMatrix ();  // back to 1-1 scaling
 #if DEBUG_KP_VIEW_RENDERER && 1
         qCDebug(kpLogViews) << "\tscale time=" << scaleTimer.elapsed();
@@ -20,6 +20,11 @@
 #include "tools/kpTool.h"
 #include "views/kpView.h"
 
+#include <cstring>
+#include <vector>
+
+#include <QRegion>
+
 //---------------------------------------------------------------------
 
 kpViewManager::kpViewManager(kpMainWindow *mainWindow)
@@ -209,6 +214,118 @@ const kpTempImage *kpViewManager::tempImage() const
 
 //---------------------------------------------------------------------
 
+// Copies row <y> of <rect> of the document, as displayed with <tempImage>
+// (if not null) set on top of it, to <row>.  <docImage> holds the document
+// from <docOrigin> onwards.
+static void DisplayedRow(QRgb *row, const QRect &rect, int y, const kpImage &docImage, const QPoint &docOrigin, const kpTempImage *tempImage)
+{
+    memcpy(row,
+           reinterpret_cast<const QRgb *>(docImage.constScanLine(y - docOrigin.y())) + (rect.x() - docOrigin.x()),
+           rect.width() * sizeof(QRgb));
+
+    if (!tempImage) {
+        return;
+    }
+
+    const QRect tempRect = tempImage->rect();
+    if (y < tempRect.top() || y > tempRect.bottom()) {
+        return;
+    }
+
+    const int x1 = qMax(rect.left(), tempRect.left());
+    const int x2 = qMin(rect.right(), tempRect.right());
+    if (x1 > x2) {
+        return;
+    }
+
+    const kpImage image = tempImage->image();
+    memcpy(row + (x1 - rect.x()),
+           reinterpret_cast<const QRgb *>(image.constScanLine(y - tempRect.y())) + (x1 - tempRect.x()),
+           (x2 - x1 + 1) * sizeof(QRgb));
+}
+
+// Shape previews are compared in squares of this size, in document pixels.
+static const int PreviewTileSize = 32;
+
+// Replacing the SetImage temp image <oldTempImage> with <newTempImage>
+// only changes the document pixels where the two previews differ from
+// each other or from the document.  Returns the tiles of the document
+// containing such pixels, via <changedRegion>, so that dragging out a
+// large shape only repaints around its outline.
+//
+// <docImage> is the part of the document at <docOrigin> under the
+// previews (or all of it).
+//
+// Returns false if the images cannot be compared.
+static bool PreviewChangedRegion(const kpTempImage &oldTempImage,
+                                 const kpTempImage &newTempImage,
+                                 const kpImage &docImage,
+                                 const QPoint &docOrigin,
+                                 QRegion *changedRegion)
+{
+    if (oldTempImage.renderMode() != kpTempImage::SetImage || newTempImage.renderMode() != kpTempImage::SetImage) {
+        return false;
+    }
+
+    const QImage::Format format = docImage.format();
+    if (format != QImage::Format_ARGB32_Premultiplied || oldTempImage.image().format() != format || newTempImage.image().format() != format) {
+        return false;
+    }
+
+    // Neither preview is visible outside the document.
+    const QRect rect = (oldTempImage.rect() | newTempImage.rect()) & QRect(docOrigin, docImage.size());
+    if (rect.isEmpty()) {
+        return true;
+    }
+
+    const int numTileColumns = (rect.width() + PreviewTileSize - 1) / PreviewTileSize;
+
+    std::vector<QRgb> oldRow(rect.width()), newRow(rect.width());
+    std::vector<bool> tileChanged(numTileColumns);
+
+    for (int tileY = rect.top(); tileY <= rect.bottom(); tileY += PreviewTileSize) {
+        const int tileHeight = qMin(PreviewTileSize, rect.bottom() - tileY + 1);
+
+        std::fill(tileChanged.begin(), tileChanged.end(), false);
+
+        for (int y = tileY; y < tileY + tileHeight; y++) {
+            ::DisplayedRow(oldRow.data(), rect, y, docImage, docOrigin, &oldTempImage);
+            ::DisplayedRow(newRow.data(), rect, y, docImage, docOrigin, &newTempImage);
+
+            for (int column = 0; column < numTileColumns; column++) {
+                if (tileChanged[column]) {
+                    continue;
+                }
+
+                const int x = column * PreviewTileSize;
+                const int width = qMin(PreviewTileSize, rect.width() - x);
+                if (memcmp(oldRow.data() + x, newRow.data() + x, width * sizeof(QRgb)) != 0) {
+                    tileChanged[column] = true;
+                }
+            }
+        }
+
+        // Add each run of changed tiles in one go.
+        for (int column = 0; column < numTileColumns;) {
+            if (!tileChanged[column]) {
+                column++;
+                continue;
+            }
+
+            const int firstColumn = column;
+            while (column < numTileColumns && tileChanged[column]) {
+                column++;
+            }
+
+            *changedRegion += QRect(rect.x() + firstColumn * PreviewTileSize, tileY, (column - firstColumn) * PreviewTileSize, tileHeight) & rect;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
 // public
 void kpViewManager::setTempImage(const kpTempImage &tempImage)
 {
@@ -219,8 +336,28 @@ void kpViewManager::setTempImage(const kpTempImage &tempImage)
 
     QRect oldRect;
 
+    // When a shape preview is replaced by the next one, only repaint where
+    // they differ.
+    QRegion changedRegion;
+    bool haveChangedRegion = false;
+
     if (d->tempImage) {
         oldRect = d->tempImage->rect();
+
+        if (!d->tempImage->isBrush() && !tempImage.isBrush()) {
+            if (!document()->isTiled()) {
+                haveChangedRegion = ::PreviewChangedRegion(*d->tempImage, tempImage, document()->image(), QPoint(0, 0), &changedRegion);
+            } else {
+                // Only the part under the previews, as image() would have
+                // to put the whole tiled image together.
+                const QRect previewRect = (oldRect | tempImage.rect()) & document()->rect();
+                if (!previewRect.isEmpty()) {
+                    haveChangedRegion =
+                        ::PreviewChangedRegion(*d->tempImage, tempImage, document()->getImageAt(previewRect), previewRect.topLeft(), &changedRegion);
+                }
+            }
+        }
+
         delete d->tempImage;
         d->tempImage = nullptr;
     }
@@ -229,10 +366,16 @@ void kpViewManager::setTempImage(const kpTempImage &tempImage)
 
     setQueueUpdates();
     {
-        if (oldRect.isValid()) {
-            updateViews(oldRect);
+        if (haveChangedRegion) {
+            for (const QRect &rect : changedRegion) {
+                updateViews(rect);
+            }
+        } else {
+            if (oldRect.isValid()) {
+                updateViews(oldRect);
+            }
+            updateViews(d->tempImage->rect());
         }
-        updateViews(d->tempImage->rect());
     }
     restoreQueueUpdates();
 }
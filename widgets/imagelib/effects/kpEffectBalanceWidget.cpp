@@ -10,6 +10,7 @@
 
 #include "commands/imagelib/effects/kpEffectBalanceCommand.h"
 #include "imagelib/effects/kpEffectBalance.h"
+#include "imagelib/effects/kpEffectChain.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 #include "kpLogCategories.h"
@@ -127,9 +128,16 @@ bool kpEffectBalanceWidget::isNoOp() const
 }
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectBalanceWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectBalanceWidget::effectFunction() const
 {
-    return kpEffectBalance::applyEffect(image, channels(), brightness(), contrast(), gamma());
+    const int channels = this->channels();
+    const int brightness = this->brightness();
+    const int contrast = this->contrast();
+    const int gamma = this->gamma();
+
+    return [=](const kpImage &image) {
+        return kpEffectBalance::applyEffect(image, channels, brightness, contrast, gamma);
+    };
 }
 
 // public virtual [base kpEffectWidgetBase]
@@ -138,6 +146,13 @@ kpEffectCommandBase *kpEffectBalanceWidget::createCommand(kpCommandEnvironment *
     return new kpEffectBalanceCommand(channels(), brightness(), contrast(), gamma(), m_actOnSelection, cmdEnviron);
 }
 
+// public virtual [base kpEffectWidgetBase]
+bool kpEffectBalanceWidget::addToChain(kpEffectChain *chain) const
+{
+    chain->addBalance(channels(), brightness(), contrast(), gamma());
+    return true;
+}
+
 // protected
 int kpEffectBalanceWidget::channels() const
 {
@@ -28,7 +28,7 @@ public:
     QString caption() const override;
 
     bool isNoOp() const override;
-    kpImage applyEffect(const kpImage &image) override;
+    kpEffectFunction effectFunction() const override;
 
     kpEffectCommandBase *createCommand(kpCommandEnvironment *cmdEnviron) const override;
 
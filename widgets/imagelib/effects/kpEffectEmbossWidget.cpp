@@ -50,13 +50,19 @@ bool kpEffectEmbossWidget::isNoOp() const
 }
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectEmbossWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectEmbossWidget::effectFunction() const
 {
     if (isNoOp()) {
-        return image;
+        return [](const kpImage &image) {
+            return image;
+        };
     }
 
-    return kpEffectEmboss::applyEffect(image, strength());
+    const int strength = this->strength();
+
+    return [=](const kpImage &image) {
+        return kpEffectEmboss::applyEffect(image, strength);
+    };
 }
 
 // public virtual [base kpEffectWidgetBase]
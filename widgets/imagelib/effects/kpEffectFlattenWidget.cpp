@@ -11,6 +11,7 @@
 
 #include "commands/imagelib/effects/kpEffectFlattenCommand.h"
 #include "imagelib/effects/kpEffectFlatten.h"
+#include "imagelib/effects/kpEffectChain.h"
 #include "kpDefs.h"
 #include "kpLogCategories.h"
 
@@ -105,17 +106,24 @@ bool kpEffectFlattenWidget::isNoOp() const
 }
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectFlattenWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectFlattenWidget::effectFunction() const
 {
 #if DEBUG_KP_EFFECT_FLATTEN
-    qCDebug(kpLogWidgets) << "kpEffectFlattenWidget::applyEffect() nop=" << isNoOp() << endl;
+    qCDebug(kpLogWidgets) << "kpEffectFlattenWidget::effectFunction() nop=" << isNoOp() << endl;
 #endif
 
     if (isNoOp()) {
-        return image;
+        return [](const kpImage &image) {
+            return image;
+        };
     }
 
-    return kpEffectFlatten::applyEffect(image, color1(), color2());
+    const QColor color1 = this->color1();
+    const QColor color2 = this->color2();
+
+    return [=](const kpImage &image) {
+        return kpEffectFlatten::applyEffect(image, color1, color2);
+    };
 }
 
 // public virtual [base kpEffectWidgetBase]
@@ -124,6 +132,16 @@ kpEffectCommandBase *kpEffectFlattenWidget::createCommand(kpCommandEnvironment *
     return new kpEffectFlattenCommand(color1(), color2(), m_actOnSelection, cmdEnviron);
 }
 
+// public virtual [base kpEffectWidgetBase]
+bool kpEffectFlattenWidget::addToChain(kpEffectChain *chain) const
+{
+    if (!isNoOp()) {
+        chain->addFlatten(color1(), color2());
+    }
+
+    return true;
+}
+
 // protected slot:
 void kpEffectFlattenWidget::slotEnableChanged(bool enable)
 {
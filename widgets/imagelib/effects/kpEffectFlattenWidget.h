@@ -36,9 +36,10 @@ public:
     QString caption() const override;
 
     bool isNoOp() const override;
-    kpImage applyEffect(const kpImage &image) override;
+    kpEffectFunction effectFunction() const override;
 
     kpEffectCommandBase *createCommand(kpCommandEnvironment *cmdEnviron) const override;
+    bool addToChain(kpEffectChain *chain) const override;
 
 protected Q_SLOTS:
     void slotEnableChanged(bool enable);
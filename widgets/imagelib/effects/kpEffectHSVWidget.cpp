@@ -15,6 +15,7 @@
 
 #include "commands/imagelib/effects/kpEffectHSVCommand.h"
 #include "imagelib/effects/kpEffectHSV.h"
+#include "imagelib/effects/kpEffectChain.h"
 
 kpEffectHSVWidget::kpEffectHSVWidget(bool actOnSelection, QWidget *parent)
     : kpEffectWidgetBase(actOnSelection, parent)
@@ -73,9 +74,15 @@ bool kpEffectHSVWidget::isNoOp() const
 }
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectHSVWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectHSVWidget::effectFunction() const
 {
-    return kpEffectHSV::applyEffect(image, m_hueInput->value(), m_saturationInput->value(), m_valueInput->value());
+    const double hue = m_hueInput->value();
+    const double saturation = m_saturationInput->value();
+    const double value = m_valueInput->value();
+
+    return [=](const kpImage &image) {
+        return kpEffectHSV::applyEffect(image, hue, saturation, value);
+    };
 }
 
 // public virtual [base kpEffectWidgetBase]
@@ -84,4 +91,11 @@ kpEffectCommandBase *kpEffectHSVWidget::createCommand(kpCommandEnvironment *cmdE
     return new kpEffectHSVCommand(m_hueInput->value(), m_saturationInput->value(), m_valueInput->value(), m_actOnSelection, cmdEnviron);
 }
 
+// public virtual [base kpEffectWidgetBase]
+bool kpEffectHSVWidget::addToChain(kpEffectChain *chain) const
+{
+    chain->addHSV(m_hueInput->value(), m_saturationInput->value(), m_valueInput->value());
+    return true;
+}
+
 #include "moc_kpEffectHSVWidget.cpp"
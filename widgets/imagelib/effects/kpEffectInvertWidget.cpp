@@ -11,6 +11,7 @@
 
 #include "commands/imagelib/effects/kpEffectInvertCommand.h"
 #include "imagelib/effects/kpEffectInvert.h"
+#include "imagelib/effects/kpEffectChain.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 #include "kpLogCategories.h"
@@ -112,9 +113,13 @@ bool kpEffectInvertWidget::isNoOp() const
 }
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectInvertWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectInvertWidget::effectFunction() const
 {
-    return kpEffectInvert::applyEffect(image, channels());
+    const int channels = this->channels();
+
+    return [=](const kpImage &image) {
+        return kpEffectInvert::applyEffect(image, channels);
+    };
 }
 
 // public virtual [base kpEffectWidgetBase]
@@ -123,6 +128,13 @@ kpEffectCommandBase *kpEffectInvertWidget::createCommand(kpCommandEnvironment *c
     return new kpEffectInvertCommand(channels(), m_actOnSelection, cmdEnviron);
 }
 
+// public virtual [base kpEffectWidgetBase]
+bool kpEffectInvertWidget::addToChain(kpEffectChain *chain) const
+{
+    chain->addInvert(channels());
+    return true;
+}
+
 // protected slots
 void kpEffectInvertWidget::slotRGBCheckBoxToggled()
 {
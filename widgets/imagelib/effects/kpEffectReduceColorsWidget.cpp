@@ -118,9 +118,14 @@ bool kpEffectReduceColorsWidget::isNoOp() const
 //---------------------------------------------------------------------
 
 // public virtual [base kpEffectWidgetBase]
-kpImage kpEffectReduceColorsWidget::applyEffect(const kpImage &image)
+kpEffectFunction kpEffectReduceColorsWidget::effectFunction() const
 {
-    return kpEffectReduceColors::applyEffect(image, depth(), dither());
+    const int depth = this->depth();
+    const bool dither = this->dither();
+
+    return [=](const kpImage &image) {
+        return kpEffectReduceColors::applyEffect(image, depth, dither);
+    };
 }
 
 //---------------------------------------------------------------------
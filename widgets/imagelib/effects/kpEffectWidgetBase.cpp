@@ -21,4 +21,18 @@ QString kpEffectWidgetBase::caption() const
     return {};
 }
 
+// public virtual
+bool kpEffectWidgetBase::addToChain(kpEffectChain *chain) const
+{
+    Q_UNUSED(chain)
+
+    return false;
+}
+
+// public
+kpImage kpEffectWidgetBase::applyEffect(const kpImage &image) const
+{
+    return effectFunction()(image);
+}
+
 #include "moc_kpEffectWidgetBase.cpp"
@@ -10,11 +10,19 @@
 
 #include <QWidget>
 
+#include <functional>
+
 #include "imagelib/kpImage.h"
 
 class kpCommandEnvironment;
+class kpEffectChain;
 class kpEffectCommandBase;
 
+// An effect, with its settings bound, that can be applied to an image.
+// It must not refer back to the widget that created it, so that it
+// can be run on a worker thread.
+typedef std::function<kpImage(const kpImage &)> kpEffectFunction;
+
 class kpEffectWidgetBase : public QWidget
 {
     Q_OBJECT
@@ -28,18 +36,25 @@ Q_SIGNALS:
 
     void settingsChanged();
 
-    // (same as settingsChanged() but preview doesn't update until there
-    //  has been no activity for a while - used for sliders in slow effects)
+    // (same as settingsChanged() but used for sliders in slow effects,
+    //  whose previews are computed in the background without a wait cursor)
     void settingsChangedDelayed();
 
 public:
     virtual QString caption() const;
 
     virtual bool isNoOp() const = 0;
-    virtual kpImage applyEffect(const kpImage &image) = 0;
+    kpImage applyEffect(const kpImage &image) const;
+
+    // Captures the current settings.
+    virtual kpEffectFunction effectFunction() const = 0;
 
     virtual kpEffectCommandBase *createCommand(kpCommandEnvironment *cmdEnviron) const = 0;
 
+    // Appends the effect, with the current settings, to <chain> and returns
+    // true.  Returns false if kpEffectChain does not support this effect.
+    virtual bool addToChain(kpEffectChain *chain) const;
+
 protected:
     bool m_actOnSelection;
 };
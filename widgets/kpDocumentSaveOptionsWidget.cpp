@@ -22,15 +22,17 @@
 #include <KLocalization>
 #include <KSharedConfig>
 
-#include <QApplication>
 #include <QBuffer>
 #include <QComboBox>
 #include <QHBoxLayout>
 #include <QImage>
 #include <QLabel>
+#include <QPromise>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QThreadPool>
 #include <QTimer>
+#include <QtConcurrentRun>
 
 kpDocumentSaveOptionsWidget::kpDocumentSaveOptionsWidget(const QImage &docPixmap,
                                                          const kpDocumentSaveOptions &saveOptions,
@@ -107,6 +109,14 @@ void kpDocumentSaveOptionsWidget::init()
     m_updatePreviewTimer->setSingleShot(true);
     connect(m_updatePreviewTimer, &QTimer::timeout, this, &kpDocumentSaveOptionsWidget::updatePreview);
 
+    // Only the most recent preview is of interest so there is no point
+    // saving several at once.
+    m_previewThreadPool = new QThreadPool(this);
+    m_previewThreadPool->setMaxThreadCount(1);
+
+    m_previewWatcher = new QFutureWatcher<PreviewResult>(this);
+    connect(m_previewWatcher, &QFutureWatcher<PreviewResult>::resultReadyAt, this, &kpDocumentSaveOptionsWidget::slotPreviewResultReady);
+
     m_updatePreviewDialogLastRelativeGeometryTimer = new QTimer(this);
     connect(m_updatePreviewDialogLastRelativeGeometryTimer, &QTimer::timeout, this, &kpDocumentSaveOptionsWidget::updatePreviewDialogLastRelativeGeometry);
 
@@ -122,6 +132,9 @@ kpDocumentSaveOptionsWidget::~kpDocumentSaveOptionsWidget()
 #endif
     hidePreview();
 
+    m_previewWatcher->cancel();
+    m_previewThreadPool->waitForDone();
+
     delete m_documentPixmap;
 }
 
@@ -534,25 +547,69 @@ void kpDocumentSaveOptionsWidget::updatePreviewDelayed()
     m_updatePreviewTimer->start(m_updatePreviewDelay);
 }
 
-// protected slot
-void kpDocumentSaveOptionsWidget::updatePreview()
+// Saves <image> into <data>, returning whether it succeeded.
+static bool SaveToData(const QImage &image, const kpDocumentSaveOptions &saveOptions, const kpDocumentMetaInfo &metaInfo, QByteArray *data)
 {
-    if (!m_previewDialog || !m_documentPixmap) {
+    QBuffer buffer(data);
+    buffer.open(QIODevice::WriteOnly);
+    const bool savedOK = kpDocument::savePixmapToDevice(image, &buffer, saveOptions, metaInfo, false /*no lossy prompt*/, nullptr /*no dialogs*/);
+    buffer.close();
+
+    return savedOK;
+}
+
+// Computes the preview of saving <image>.
+//
+// For large images, a file size estimated from saving a crop of the
+// middle of the image is reported first, followed by the real file size
+// and saved image.  Only the pixel data of the crop is scaled up to the
+// whole image, not the fixed size header and metadata, which are measured
+// by saving a single pixel.
+static void ComputePreview(QPromise<kpDocumentSaveOptionsWidget::PreviewResult> &promise,
+                           const QImage &image,
+                           const kpDocumentSaveOptions &saveOptions,
+                           const kpDocumentMetaInfo &metaInfo)
+{
+    // The crop is <EstimateCropLength> pixels square and is only used if
+    // it is at most 1/<MinEstimateAreaFactor> of the image.
+    const int EstimateCropLength = 256;
+    const int MinEstimateAreaFactor = 16;
+
+    if (promise.isCanceled()) {
         return;
     }
 
-    m_updatePreviewTimer->stop();
+    const qint64 imageArea = static_cast<qint64>(image.width()) * image.height();
+    const qint64 cropArea = static_cast<qint64>(EstimateCropLength) * EstimateCropLength;
+
+    if (image.width() >= EstimateCropLength && image.height() >= EstimateCropLength && imageArea >= cropArea * MinEstimateAreaFactor) {
+        const QRect crop((image.width() - EstimateCropLength) / 2, (image.height() - EstimateCropLength) / 2, EstimateCropLength, EstimateCropLength);
+
+        QByteArray cropData;
+        if (::SaveToData(image.copy(crop), saveOptions, metaInfo, &cropData)) {
+            QByteArray pixelData;
+            const bool savedPixelOK = ::SaveToData(image.copy(crop.x(), crop.y(), 1, 1), saveOptions, metaInfo, &pixelData);
+            const qint64 overhead = savedPixelOK ? qMin(pixelData.size(), cropData.size()) : 0;
 
-    QApplication::setOverrideCursor(Qt::WaitCursor);
+            kpDocumentSaveOptionsWidget::PreviewResult estimate;
+            estimate.fileSize = overhead + (cropData.size() - overhead) * imageArea / cropArea;
+            estimate.isEstimate = true;
+            promise.addResult(estimate);
+        }
+
+        if (promise.isCanceled()) {
+            return;
+        }
+    }
 
     QByteArray data;
+    const bool savedOK = ::SaveToData(image, saveOptions, metaInfo, &data);
 
-    QBuffer buffer(&data);
-    buffer.open(QIODevice::WriteOnly);
-    bool savedOK = kpDocument::savePixmapToDevice(*m_documentPixmap, &buffer, documentSaveOptions(), m_documentMetaInfo, false /*no lossy prompt*/, this);
-    buffer.close();
+    if (promise.isCanceled()) {
+        return;
+    }
 
-    QImage image;
+    kpDocumentSaveOptionsWidget::PreviewResult result;
 
     // Ignore any failed saves.
     //
@@ -561,17 +618,53 @@ void kpDocumentSaveOptionsWidget::updatePreview()
     // preview even if this "half a file" is actually loadable by
     // QImage::loadFormData().
     if (savedOK) {
-        image.loadFromData(data);
+        result.filePixmap.loadFromData(data);
     } else {
-        // Leave <image> as invalid.
+        // Leave <result.filePixmap> as invalid.
         // TODO: This code path has not been well tested.
         //       Will we trigger divide by zero errors in "m_previewDialog"?
     }
 
-    // REFACTOR: merge with kpDocument::getPixmapFromFile()
-    m_previewDialog->setFilePixmapAndSize(image, data.size());
+    result.fileSize = data.size();
+    promise.addResult(result);
+}
+
+// protected slot
+void kpDocumentSaveOptionsWidget::updatePreview()
+{
+    if (!m_previewDialog || !m_documentPixmap) {
+        return;
+    }
+
+    m_updatePreviewTimer->stop();
+
+    // Saving cannot be interrupted but ComputePreview() stops at the next
+    // opportunity.  Stale results are discarded by setFuture().
+    m_previewWatcher->cancel();
+
+    m_previewWatcher->setFuture(QtConcurrent::run(m_previewThreadPool, &ComputePreview, *m_documentPixmap, documentSaveOptions(), m_documentMetaInfo));
+}
 
-    QApplication::restoreOverrideCursor();
+// protected slot
+void kpDocumentSaveOptionsWidget::slotPreviewResultReady(int index)
+{
+    if (m_previewWatcher->isCanceled() || !m_previewDialog) {
+        return;
+    }
+
+    const PreviewResult result = m_previewWatcher->resultAt(index);
+
+#if DEBUG_KP_DOCUMENT_SAVE_OPTIONS_WIDGET
+    qCDebug(kpLogWidgets) << "kpDocumentSaveOptionsWidget::slotPreviewResultReady(" << index << ") fileSize=" << result.fileSize
+                          << " isEstimate=" << result.isEstimate;
+#endif
+
+    // REFACTOR: merge with kpDocument::getPixmapFromFile()
+    if (result.isEstimate) {
+        m_previewDialog->setFileSizeEstimate(result.fileSize);
+    } else {
+        m_previewDialog->setFilePixmapAndSize(result.filePixmap, result.fileSize);
+    }
 }
 
 // protected slot
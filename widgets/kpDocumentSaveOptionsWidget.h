@@ -8,6 +8,8 @@
 #ifndef kpDocumentSaveOptionsWidget_H
 #define kpDocumentSaveOptionsWidget_H
 
+#include <QFutureWatcher>
+#include <QImage>
 #include <QRect>
 #include <QWidget>
 
@@ -15,11 +17,11 @@
 #include "imagelib/kpDocumentMetaInfo.h"
 
 class QComboBox;
-class QImage;
 class QLabel;
 class QTimer;
 class QSpinBox;
 class QPushButton;
+class QThreadPool;
 
 class kpDocumentSaveOptionsPreviewDialog;
 
@@ -93,8 +95,19 @@ protected Q_SLOTS:
     void hidePreview();
     void updatePreviewDelayed();
     void updatePreview();
+    void slotPreviewResultReady(int index);
     void updatePreviewDialogLastRelativeGeometry();
 
+public:
+    // Computed off the GUI thread by updatePreview().
+    struct PreviewResult {
+        // The saved image as loaded back, unless <isEstimate>.
+        QImage filePixmap;
+        qint64 fileSize = 0;
+        // Whether <fileSize> has been extrapolated from saving a crop.
+        bool isEstimate = false;
+    };
+
 protected:
     QWidget *m_visualParent;
 
@@ -118,6 +131,8 @@ protected:
     QRect m_previewDialogLastRelativeGeometry;
     QTimer *m_updatePreviewTimer;
     int m_updatePreviewDelay;
+    QThreadPool *m_previewThreadPool;
+    QFutureWatcher<PreviewResult> *m_previewWatcher;
     QTimer *m_updatePreviewDialogLastRelativeGeometryTimer;
 };
 
@@ -9,8 +9,11 @@
 
 #include "widgets/toolbars/options/kpToolWidgetBrush.h"
 
+#include <QList>
 #include <QPainter>
 
+#include <algorithm>
+
 #include <KLocalizedString>
 
 #include "kpDefs.h"
@@ -27,12 +30,12 @@ static int BrushSizes[][3] = {{8, 4, 1 /*like Pen*/}, {9, 5, 2}, {9, 5, 2}, {9,
 
 //---------------------------------------------------------------------
 
-static void Draw(kpImage *destImage, const QPoint &topLeft, void *userData)
+// Draws the brush at <row>, <col> with QPainter.  Only used to build the
+// brush stamps (see Stamp()).
+static void DrawWithPainter(kpImage *destImage, const QPoint &topLeft, const kpToolWidgetBrush::DrawPackage *pack)
 {
-    auto *pack = static_cast<kpToolWidgetBrush::DrawPackage *>(userData);
-
 #if DEBUG_KP_TOOL_WIDGET_BRUSH
-    qCDebug(kpLogWidgets) << "kptoolwidgetbrush.cpp:Draw(destImage,topLeft=" << topLeft << " pack: row=" << pack->row << " col=" << pack->col
+    qCDebug(kpLogWidgets) << "kptoolwidgetbrush.cpp:DrawWithPainter(destImage,topLeft=" << topLeft << " pack: row=" << pack->row << " col=" << pack->col
                           << " color=" << (int *)pack->color.toQRgb();
 #endif
     const int size = ::BrushSizes[pack->row][pack->col];
@@ -108,6 +111,127 @@ static void Draw(kpImage *destImage, const QPoint &topLeft, void *userData)
 
 //---------------------------------------------------------------------
 
+// A run of pixels in one row of a brush.
+struct BrushSpan {
+    int y, x, width;
+};
+
+// The pixels that a brush covers, as spans relative to its top-left.
+using BrushStamp = QList<BrushSpan>;
+
+static BrushStamp MakeStamp(int row, int col)
+{
+    const int size = ::BrushSizes[row][col];
+
+    QImage mask(size, size, QImage::Format_ARGB32_Premultiplied);
+    mask.fill(0);
+
+    const kpToolWidgetBrush::DrawPackage pack = kpToolWidgetBrush::drawFunctionDataForRowCol(kpColor::Black, row, col);
+    ::DrawWithPainter(&mask, QPoint(0, 0), &pack);
+
+    BrushStamp stamp;
+    for (int y = 0; y < size; y++) {
+        const auto *line = reinterpret_cast<const QRgb *>(mask.constScanLine(y));
+        for (int x = 0; x < size;) {
+            if (qAlpha(line[x]) == 0) {
+                x++;
+                continue;
+            }
+
+            BrushSpan span{y, x, 0};
+            while (x < size && qAlpha(line[x]) != 0) {
+                span.width++;
+                x++;
+            }
+
+            stamp.append(span);
+        }
+    }
+
+    return stamp;
+}
+
+// Returns the stamp of the brush at <row>, <col>, which is only rendered
+// the first time that it is needed.
+static const BrushStamp &Stamp(int row, int col)
+{
+    static const QList<BrushStamp> stamps = [] {
+        QList<BrushStamp> ret;
+        for (int r = 0; r < BRUSH_SIZE_NUM_ROWS; r++) {
+            for (int c = 0; c < BRUSH_SIZE_NUM_COLS; c++) {
+                ret.append(::MakeStamp(r, c));
+            }
+        }
+        return ret;
+    }();
+
+    return stamps[row * BRUSH_SIZE_NUM_COLS + col];
+}
+
+// Returns <pixel> * <alpha> / 255 for each channel, rounded the same way
+// as by Qt's raster paint engine.
+static inline QRgb ByteMul(QRgb pixel, uint alpha)
+{
+    uint t = (pixel & 0xff00ff) * alpha;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+
+    pixel = ((pixel >> 8) & 0xff00ff) * alpha;
+    pixel = (pixel + ((pixel >> 8) & 0xff00ff) + 0x800080);
+    pixel &= 0xff00ff00;
+
+    return pixel | t;
+}
+
+static void Draw(kpImage *destImage, const QPoint &topLeft, void *userData)
+{
+    auto *pack = static_cast<kpToolWidgetBrush::DrawPackage *>(userData);
+
+#if DEBUG_KP_TOOL_WIDGET_BRUSH
+    qCDebug(kpLogWidgets) << "kptoolwidgetbrush.cpp:Draw(destImage,topLeft=" << topLeft << " pack: row=" << pack->row << " col=" << pack->col
+                          << " color=" << (int *)pack->color.toQRgb();
+#endif
+
+    const BrushStamp &stamp = ::Stamp(pack->row, pack->col);
+    const QColor color = pack->color.toQColor();
+
+    // Every pixel of the brush is drawn exactly once, as if by QPainter
+    // (with the default composition mode, SourceOver).
+    if (destImage->format() != QImage::Format_ARGB32_Premultiplied) {
+        QPainter painter(destImage);
+        for (const BrushSpan &span : stamp) {
+            painter.fillRect(topLeft.x() + span.x, topLeft.y() + span.y, span.width, 1, color);
+        }
+        return;
+    }
+
+    const QRgb source = qPremultiply(color.rgba());
+    const uint inverseAlpha = 255 - qAlpha(source);
+    if (inverseAlpha == 255) {
+        return;
+    }
+
+    const int width = destImage->width(), height = destImage->height();
+    for (const BrushSpan &span : stamp) {
+        const int y = topLeft.y() + span.y;
+        const int x1 = qMax(topLeft.x() + span.x, 0), x2 = qMin(topLeft.x() + span.x + span.width, width);
+        if (y < 0 || y >= height || x1 >= x2) {
+            continue;
+        }
+
+        QRgb *pixels = reinterpret_cast<QRgb *>(destImage->scanLine(y)) + x1;
+        if (inverseAlpha == 0) {
+            std::fill(pixels, pixels + (x2 - x1), source);
+        } else {
+            for (int i = 0; i < x2 - x1; i++) {
+                pixels[i] = source + ::ByteMul(pixels[i], inverseAlpha);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
 kpToolWidgetBrush::kpToolWidgetBrush(QWidget *parent, const QString &name)
     : kpToolWidgetBase(parent, name)
 {